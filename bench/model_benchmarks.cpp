@@ -0,0 +1,424 @@
+/**
+ * Microbenchmarks for the parts of Model::Step that dominate run time.
+ *
+ * Most benchmarks take two arguments: the number of agents and the
+ * mean number of neighbors of each agent. The arena size is fixed and
+ * the communication range is chosen to give the requested mean degree
+ * for agents placed uniformly at random.
+ *
+ * Build with -DBUILD_BENCHMARKS=On and run e.g.
+ *   ./model_benchmarks --benchmark_filter=Step
+ */
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "Model.hpp"
+#include "ModelBatch.hpp"
+#include "Agent.hpp"
+#include "AgentStore.hpp"
+#include "Network.hpp"
+#include "ModelStats.hpp"
+#include "Rule.hpp"
+#include "TotalisticRule.hpp"
+#include "Proximity.hpp"
+
+namespace
+{
+   const double ARENA_SIZE = 100;
+   const int    SEED       = 1234;
+
+   /**
+    * Communication range giving num_agents uniformly placed agents a
+    * mean degree of about mean_degree.
+    */
+   double RangeFor(int num_agents, double mean_degree)
+   {
+      return sqrt(mean_degree * ARENA_SIZE * ARENA_SIZE / (M_PI * num_agents));
+   }
+
+   Model MakeModel(const benchmark::State& state)
+   {
+      int num_agents = state.range(0);
+      Model model(ARENA_SIZE, num_agents, RangeFor(num_agents, state.range(1)), SEED, 0.5);
+      model.RecordNetworkDensityOnly();
+      return model;
+   }
+
+   /**
+    * The edges of a random geometric graph.
+    */
+   std::vector<std::pair<int,int>> RandomEdges(const benchmark::State& state, int seed)
+   {
+      Model model(ARENA_SIZE, state.range(0), RangeFor(state.range(0), state.range(1)), seed, 0.5);
+      std::shared_ptr<NetworkSnapshot> network = model.CurrentNetwork();
+      std::vector<std::pair<int,int>> edges;
+      for(int u = 0; u < network->Size(); u++)
+      {
+         for(int v : network->GetNeighbors(u))
+         {
+            if(u < v)
+            {
+               edges.push_back(std::make_pair(u, v));
+            }
+         }
+      }
+      return edges;
+   }
+
+   TotalisticRule MajorityTotalisticRule()
+   {
+      std::istringstream rule_file(
+         "1 + [0.0,0.5) -> 0, 0\n"
+         "0 + [0.0,0.5) -> 0, 0\n"
+         "0 + (0.5,1.0] -> 1, 0\n"
+         "1 + (0.5,1.0] -> 1, 0\n"
+         "1 + [0.5,0.5] -> 0, 0\n"
+         "0 + [0.5,0.5] -> 1, 0\n");
+      TotalisticRule rule;
+      rule_file >> rule;
+      return rule;
+   }
+
+   void AgentsAndDegrees(benchmark::internal::Benchmark* b)
+   {
+      for(int num_agents : {256, 1024, 4096, 16384})
+      {
+         for(int mean_degree : {4, 16, 64})
+         {
+            b->Args({num_agents, mean_degree});
+         }
+      }
+   }
+}
+
+static void BM_CurrentNetwork(benchmark::State& state)
+{
+   Model model = MakeModel(state);
+   for(auto _ : state)
+   {
+      benchmark::DoNotOptimize(model.CurrentNetwork());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CurrentNetwork)->Apply(AgentsAndDegrees);
+
+// All-pairs search one pair at a time through Point::Within, as the
+// model used to, against the batched squared-distance kernel.
+static void BM_AllPairsPointWithin(benchmark::State& state)
+{
+   Model model = MakeModel(state);
+   std::vector<Point> points = model.GetAgentStore().Positions();
+   double range = RangeFor(state.range(0), state.range(1));
+   std::vector<std::pair<int,int>> pairs;
+   for(auto _ : state)
+   {
+      pairs.clear();
+      for(int i = 0; i < points.size(); i++)
+      {
+         for(int j = i + 1; j < points.size(); j++)
+         {
+            if(points[i].Within(range, points[j]))
+            {
+               pairs.push_back(std::make_pair(i, j));
+            }
+         }
+      }
+      benchmark::DoNotOptimize(pairs.data());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0) * (state.range(0) - 1) / 2);
+}
+BENCHMARK(BM_AllPairsPointWithin)->Args({256, 16})->Args({1024, 16})->Args({4096, 16});
+
+static void BM_AllPairsKernel(benchmark::State& state)
+{
+   Model model = MakeModel(state);
+   std::vector<Point> points = model.GetAgentStore().Positions();
+   double range = RangeFor(state.range(0), state.range(1));
+   std::vector<std::pair<int,int>> pairs;
+   for(auto _ : state)
+   {
+      proximity::AllPairs(points, range, pairs);
+      benchmark::DoNotOptimize(pairs.data());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0) * (state.range(0) - 1) / 2);
+   state.SetLabel(proximity::KernelName());
+}
+BENCHMARK(BM_AllPairsKernel)->Args({256, 16})->Args({1024, 16})->Args({4096, 16});
+
+static void BM_ModelStep(benchmark::State& state)
+{
+   Model model = MakeModel(state);
+   MajorityRule majority;
+   for(auto _ : state)
+   {
+      model.Step(&majority);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelStep)->Apply(AgentsAndDegrees);
+
+static void BM_ModelStepTotalistic(benchmark::State& state)
+{
+   Model model = MakeModel(state);
+   TotalisticRule rule = MajorityTotalisticRule();
+   for(auto _ : state)
+   {
+      model.Step(&rule);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelStepTotalistic)->Apply(AgentsAndDegrees);
+
+/**
+ * Step slow agents with the Verlet search, counter-based streams and
+ * no noise, where dense networks can sum neighbor states over
+ * bit-packed states (argument 2).
+ */
+static void BM_ModelStepPacked(benchmark::State& state)
+{
+   int num_agents = state.range(0);
+   Model model(ARENA_SIZE, num_agents, RangeFor(num_agents, state.range(1)), SEED, 0.5, 0.1);
+   model.RecordNetworkDensityOnly();
+   model.SetNeighborSearch(Model::NeighborSearch::Verlet);
+   model.UseCounterRng();
+   model.UsePackedStates(state.range(2));
+   TotalisticRule rule = MajorityTotalisticRule();
+   for(auto _ : state)
+   {
+      model.Step(&rule);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelStepPacked)->ArgsProduct({{1024, 4096}, {256, 1024}, {0, 1}});
+
+/**
+ * Step slow agents (speed 0.1) with the given neighbor search, where
+ * the Verlet list is rebuilt only every few steps.
+ */
+static void ModelStepSlow(benchmark::State& state, Model::NeighborSearch method)
+{
+   int num_agents = state.range(0);
+   Model model(ARENA_SIZE, num_agents, RangeFor(num_agents, state.range(1)), SEED, 0.5, 0.1);
+   model.RecordNetworkDensityOnly();
+   model.SetNeighborSearch(method);
+   MajorityRule majority;
+   for(auto _ : state)
+   {
+      model.Step(&majority);
+   }
+   state.SetItemsProcessed(state.iterations() * num_agents);
+}
+
+static void BM_ModelStepSlowCellList(benchmark::State& state)
+{
+   ModelStepSlow(state, Model::NeighborSearch::CellList);
+}
+BENCHMARK(BM_ModelStepSlowCellList)->Apply(AgentsAndDegrees);
+
+static void BM_ModelStepSlowVerlet(benchmark::State& state)
+{
+   ModelStepSlow(state, Model::NeighborSearch::Verlet);
+}
+BENCHMARK(BM_ModelStepSlowVerlet)->Apply(AgentsAndDegrees);
+
+static void BM_ModelCreate(benchmark::State& state)
+{
+   int seed = SEED;
+   for(auto _ : state)
+   {
+      Model model(ARENA_SIZE, state.range(0), RangeFor(state.range(0), state.range(1)), seed++, 0.5);
+      benchmark::DoNotOptimize(model.CurrentOnes());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelCreate)->Args({1024, 16})->Args({4096, 16});
+
+static void BM_ModelReset(benchmark::State& state)
+{
+   Model model = MakeModel(state);
+   int seed = SEED;
+   for(auto _ : state)
+   {
+      model.Reset(seed++, 0.5);
+      benchmark::DoNotOptimize(model.CurrentOnes());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelReset)->Args({1024, 16})->Args({4096, 16});
+
+static void BM_SnapshotAddEdge(benchmark::State& state)
+{
+   std::vector<std::pair<int,int>> edges = RandomEdges(state, SEED);
+   for(auto _ : state)
+   {
+      NetworkSnapshot snapshot(state.range(0));
+      for(auto& e : edges)
+      {
+         snapshot.AddEdge(e.first, e.second);
+      }
+      benchmark::DoNotOptimize(snapshot.EdgeCount()); // merges the added edges
+   }
+   state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_SnapshotAddEdge)->Apply(AgentsAndDegrees);
+
+static void BM_SnapshotGetNeighbors(benchmark::State& state)
+{
+   NetworkSnapshot snapshot(state.range(0), RandomEdges(state, SEED));
+   for(auto _ : state)
+   {
+      int sum = 0;
+      for(int v = 0; v < snapshot.Size(); v++)
+      {
+         for(int n : snapshot.GetNeighbors(v))
+         {
+            sum += n;
+         }
+      }
+      benchmark::DoNotOptimize(sum);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SnapshotGetNeighbors)->Apply(AgentsAndDegrees);
+
+static void BM_SnapshotUnion(benchmark::State& state)
+{
+   NetworkSnapshot first(state.range(0), RandomEdges(state, SEED));
+   NetworkSnapshot second(state.range(0), RandomEdges(state, SEED + 1));
+   for(auto _ : state)
+   {
+      NetworkSnapshot u = first;
+      u.Union(second);
+      benchmark::DoNotOptimize(u.EdgeCount());
+   }
+   state.SetItemsProcessed(state.iterations() * (first.EdgeCount() + second.EdgeCount()));
+}
+BENCHMARK(BM_SnapshotUnion)->Apply(AgentsAndDegrees);
+
+static void BM_PushState(benchmark::State& state)
+{
+   // a fresh random network each step so the aggregate keeps growing
+   std::vector<std::shared_ptr<NetworkSnapshot>> snapshots;
+   for(int s = 0; s < 16; s++)
+   {
+      snapshots.push_back(std::make_shared<NetworkSnapshot>(state.range(0), RandomEdges(state, SEED + s)));
+   }
+
+   ModelStats stats(state.range(0));
+   stats.NetworkSummaryOnly();
+   int t = 0;
+   for(auto _ : state)
+   {
+      stats.PushState(0.5, snapshots[t++ % snapshots.size()]);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PushState)->Apply(AgentsAndDegrees);
+
+static void BM_TotalisticRuleApply(benchmark::State& state)
+{
+   TotalisticRule rule = MajorityTotalisticRule();
+   std::mt19937_64 gen(SEED);
+   std::bernoulli_distribution coin(0.5);
+   std::vector<int> neighbors(state.range(0));
+   for(int& n : neighbors)
+   {
+      n = coin(gen);
+   }
+   for(auto _ : state)
+   {
+      benchmark::DoNotOptimize(rule.Apply(1, neighbors));
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TotalisticRuleApply)->RangeMultiplier(4)->Range(4, 256);
+
+static void BM_TotalisticRuleApplyCount(benchmark::State& state)
+{
+   TotalisticRule rule = MajorityTotalisticRule();
+   int total = state.range(0);
+   int ones  = 0;
+   for(auto _ : state)
+   {
+      benchmark::DoNotOptimize(rule.ApplyCount(1, ones, total));
+      ones = (ones + 1) % (total + 1);
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TotalisticRuleApplyCount)->RangeMultiplier(4)->Range(4, 256);
+
+static void BM_AgentStep(benchmark::State& state)
+{
+   std::vector<Agent> agents = MakeModel(state).GetAgents();
+   for(auto _ : state)
+   {
+      for(Agent& agent : agents)
+      {
+         agent.Step();
+      }
+   }
+   state.SetItemsProcessed(state.iterations() * agents.size());
+}
+BENCHMARK(BM_AgentStep)->Args({1024, 16})->Args({16384, 16});
+
+static void BM_AgentStoreStep(benchmark::State& state)
+{
+   AgentStore agents = MakeModel(state).GetAgentStore();
+   for(auto _ : state)
+   {
+      agents.Step();
+   }
+   state.SetItemsProcessed(state.iterations() * agents.Size());
+}
+BENCHMARK(BM_AgentStoreStep)->Args({1024, 16})->Args({16384, 16});
+
+/**
+ * Step 16 counter-based replicas one model at a time, for comparison
+ * with BM_ModelBatchStep.
+ */
+static void BM_ReplicaModelsStep(benchmark::State& state)
+{
+   const int num_agents = state.range(0);
+   std::vector<Model> models;
+   for(int r = 0; r < 16; r++)
+   {
+      Model model(ARENA_SIZE, num_agents, RangeFor(num_agents, state.range(1)), SEED + r, 0.5);
+      model.UseCounterRng();
+      model.RecordNetworkDensityOnly();
+      models.push_back(model);
+   }
+   MajorityRule majority;
+   for(auto _ : state)
+   {
+      for(Model& model : models)
+      {
+         model.Step(&majority);
+      }
+   }
+   state.SetItemsProcessed(state.iterations() * num_agents * models.size());
+}
+BENCHMARK(BM_ReplicaModelsStep)->Args({256, 16})->Args({1024, 16});
+
+static void BM_ModelBatchStep(benchmark::State& state)
+{
+   const int num_agents = state.range(0);
+   std::vector<int> seeds;
+   for(int r = 0; r < 16; r++)
+   {
+      seeds.push_back(SEED + r);
+   }
+   ModelBatch batch(ARENA_SIZE, num_agents, RangeFor(num_agents, state.range(1)), seeds, 0.5);
+   batch.RecordNetworkDensityOnly();
+   MajorityRule majority;
+   for(auto _ : state)
+   {
+      batch.Step(&majority);
+   }
+   state.SetItemsProcessed(state.iterations() * num_agents * seeds.size());
+}
+BENCHMARK(BM_ModelBatchStep)->Args({256, 16})->Args({1024, 16});
+
+BENCHMARK_MAIN();
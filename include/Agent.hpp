@@ -89,6 +89,8 @@ public:
    bool IsDark() const;
 
    bool IsInteractive() const;
+
+   friend class AgentStore;
 };
 
 #endif // _AGENT_HPP
@@ -0,0 +1,225 @@
+#ifndef _AGENT_STORE_HPP
+#define _AGENT_STORE_HPP
+
+#include <vector>
+#include <iostream>
+#include <random>
+#include <memory>
+#include <cstdint>
+
+#include "Agent.hpp"
+#include "Point.hpp"
+#include "Heading.hpp"
+#include "MovementRule.hpp"
+#include "Philox.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Structure-of-arrays storage for a population of agents that share a
+ * speed and an arena.
+ *
+ * Agents in the store behave exactly like Agent objects constructed
+ * with the same arguments, but positions and headings are kept in
+ * contiguous arrays so that Step() can move every agent in a few tight
+ * loops.
+ *
+ * The built-in movement rules (MovementRule itself, RandomWalk,
+ * CorrelatedRandomWalk and LevyWalk) are not stored per agent: the
+ * store remembers which one is in use, keeps any per-agent turn state
+ * in arrays, and runs a turn loop specialized for that rule. Other
+ * rules get one clone per agent, as Agent does.
+ */
+class AgentStore
+{
+public:
+   /**
+    * Independent uses of the counter-based generator within one step.
+    */
+   enum RandomStream : std::uint32_t {
+      MovementStream = 0, // turning
+      ModeStream     = 1, // going dark or interactive
+      NoiseStream    = 2, // noise on the states received from neighbors
+   };
+
+   /**
+    * The movement rules with a specialized turn loop.
+    */
+   enum class MovementKind {
+      Straight,   // MovementRule: never turn
+      Random,     // RandomWalk
+      Correlated, // CorrelatedRandomWalk
+      Levy,       // LevyWalk
+      Custom,     // anything else, through a per-agent clone
+   };
+
+private:
+   double speed_;
+   double arena_size_;
+   int    steps_;
+
+   // if true each agent draws from Philox(seed_, agent, step) instead
+   // of from its own generator in generators_.
+   bool          counter_rng_;
+   std::uint64_t seed_;
+
+   std::vector<double>        x_;
+   std::vector<double>        y_;
+   std::vector<Heading>       heading_;
+   std::vector<Heading>       previous_heading_;
+   std::vector<unsigned char> dark_;
+
+   std::vector<std::mt19937_64> generators_;
+
+   MovementKind                      movement_kind_;
+   std::shared_ptr<MovementRule>     movement_rule_; // the rule every agent copies
+   double                            sigma_;         // of a correlated random walk
+   std::shared_ptr<const AliasTable> step_length_;   // of a Levy walk
+   double                            levy_mu_;
+   int                               levy_max_step_;
+   std::vector<unsigned int>         levy_time_;     // per-agent Levy walk state
+   std::vector<unsigned int>         levy_next_turn_;
+   std::vector<std::shared_ptr<MovementRule>> movement_rules_; // only for Custom
+
+   // scratch space used by Step()
+   std::vector<double>        dx_;
+   std::vector<double>        dy_;
+   std::vector<unsigned char> out_of_bounds_;
+
+   void Reflect(int i);
+
+   /**
+    * Move and turn agents [begin, end).
+    */
+   void StepRange(int begin, int end);
+
+   /**
+    * Set the heading of each interactive agent in [begin, end) to
+    * turn(i, gen), where gen is the agent's random stream.
+    */
+   template<typename Turn>
+   void TurnRange(int begin, int end, Turn turn);
+
+   /**
+    * Give the last agent added the turn state of a copy of the
+    * movement rule.
+    */
+   void AddMovementState();
+
+public:
+   AgentStore(double speed, double arena_size);
+   ~AgentStore();
+   AgentStore(const AgentStore&) = default;
+   AgentStore(AgentStore&&) = default;
+   AgentStore& operator=(const AgentStore&) = default;
+   AgentStore& operator=(AgentStore&&) = default;
+
+   /**
+    * Remove every agent, keeping the buffers, the movement rule and the
+    * choice of generators. Counter-based streams are keyed by seed
+    * from now on (see UseCounterRng()).
+    */
+   void Clear(std::uint64_t seed);
+
+   /**
+    * Add an agent at position p with heading h. The agent's random
+    * number generator is seeded with seed.
+    */
+   void Add(Point p, Heading h, int seed);
+
+   /**
+    * Get the number of agents.
+    */
+   int Size() const;
+
+   Point   Position(int i) const;
+   Heading GetHeading(int i) const;
+   Heading GetPreviousHeading(int i) const;
+   void    SetHeading(int i, Heading h);
+
+   bool IsDark(int i) const;
+   bool IsInteractive(int i) const;
+   void GoDark(int i);
+   void GoInteractive(int i);
+
+   /**
+    * The x and y coordinates of every agent.
+    */
+   const std::vector<double>& X() const;
+   const std::vector<double>& Y() const;
+
+   /**
+    * Get the positions of all the agents.
+    */
+   std::vector<Point> Positions() const;
+
+   /**
+    * Copy the positions of all the agents into positions, reusing its
+    * storage.
+    */
+   void Positions(std::vector<Point>& positions) const;
+
+   /**
+    * Draw all random numbers from the counter-based generator keyed on
+    * (seed, agent, step) instead of each agent's Mersenne twister.
+    * Frees the per-agent generators.
+    */
+   void UseCounterRng(std::uint64_t seed);
+
+   /**
+    * Returns true if agents use counter-based random streams.
+    */
+   bool UsesCounterRng() const;
+
+   /**
+    * Give every agent its own copy of the movement rule.
+    */
+   void SetMovementRule(std::shared_ptr<MovementRule> rule);
+
+   /**
+    * Get which turn loop is used for the current movement rule.
+    */
+   MovementKind GetMovementKind() const;
+
+   /**
+    * Move every agent a single timestep, reflecting off the arena
+    * walls, then let every interactive agent turn. Equivalent to
+    * calling Agent::Step() on each agent.
+    */
+   void Step();
+
+   /**
+    * Step the agents with the work split over a thread pool. Every
+    * agent draws only from its own random stream, so the result does
+    * not depend on the number of threads.
+    */
+   void Step(ThreadPool& pool);
+
+   /**
+    * Get a copy of agent i as a stand-alone Agent.
+    */
+   Agent GetAgent(int i) const;
+
+   /**
+    * Get copies of all the agents.
+    */
+   std::vector<Agent> Agents() const;
+
+   /**
+    * Write the agents, their random generators and their turn state
+    * to a binary stream.
+    */
+   void Save(std::ostream& out) const;
+
+   /**
+    * Replace the agents with ones read from a stream. The store must
+    * already use the same kind of movement rule as the saved one
+    * (e.g. both Levy walks with the same mu and max step); custom rules
+    * are given fresh clones, since their state can't be saved. Throws
+    * std::runtime_error, leaving the store unchanged, if the stream is
+    * not a saved store or was saved with a different speed, arena,
+    * movement rule or number of agents.
+    */
+   void Load(std::istream& in);
+};
+
+#endif // _AGENT_STORE_HPP
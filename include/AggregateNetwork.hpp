@@ -0,0 +1,103 @@
+#ifndef _AGGREGATE_NETWORK_HPP
+#define _AGGREGATE_NETWORK_HPP
+
+#include <vector>
+#include <iostream>
+#include <unordered_set>
+#include <cstdint>
+
+#include "TriangularBitMatrix.hpp"
+#include "Network.hpp"
+
+/**
+ * The union of a sequence of network snapshots: two vertices are
+ * adjacent if they were adjacent in any snapshot so far.
+ *
+ * Adding a snapshot only costs a constant-time lookup per edge in the
+ * snapshot, and the edge count and degree statistics are kept up to
+ * date as new edges are found, so none of the queries need to look at
+ * the whole aggregate.
+ */
+class AggregateNetwork
+{
+private:
+   int       num_vertices_;
+   long long edge_count_;
+
+   std::vector<int> degrees_;
+   std::vector<int> degree_histogram_; // number of vertices with each degree
+
+   // Edges seen so far. The bit matrix takes num_vertices^2 / 2 bits,
+   // so large networks keep a hash set of edge ids instead.
+   bool                              use_matrix_;
+   TriangularBitMatrix               adjacency_;
+   std::unordered_set<std::uint64_t> edges_;
+
+   /**
+    * Record the edge (u, v), u < v. Returns true if it is new.
+    */
+   bool InsertEdge(int u, int v);
+
+   /**
+    * Get the k-th smallest degree.
+    */
+   int KthDegree(int k) const;
+
+public:
+   /**
+    * Networks with more vertices than this store their edges in a
+    * hash set rather than a bit matrix. The matrix is then at most
+    * 4 MB, which every replica's ModelStats carries.
+    */
+   static const int MAX_MATRIX_VERTICES = 8192;
+
+   AggregateNetwork(int num_vertices);
+   ~AggregateNetwork();
+   AggregateNetwork(const AggregateNetwork&) = default;
+   AggregateNetwork(AggregateNetwork&&) = default;
+   AggregateNetwork& operator=(const AggregateNetwork&) = default;
+   AggregateNetwork& operator=(AggregateNetwork&&) = default;
+
+   /**
+    * Remove every edge, keeping the storage.
+    */
+   void Clear();
+
+   /**
+    * Add the edges of a snapshot with the same number of vertices.
+    * @return the number of edges that were not already in the
+    * aggregate.
+    */
+   int Add(const NetworkSnapshot& snapshot);
+
+   /**
+    * Returns true if u and v have been adjacent in any snapshot.
+    */
+   bool HasEdge(int u, int v) const;
+
+   int       Size() const;
+   long long EdgeCount() const;
+   int       Degree(int v) const;
+
+   /**
+    * Same as NetworkSnapshot::Density() for the union of the snapshots.
+    */
+   double Density() const;
+   double AverageDegree() const;
+   double DegreeVariance() const;
+   double MedianDegree() const;
+
+   /**
+    * Get every edge (u, v), u < v, seen so far.
+    */
+   std::vector<std::pair<int,int>> Edges() const;
+
+   /**
+    * Write the aggregate to a binary stream, or replace it with one
+    * read from a stream.
+    */
+   void Save(std::ostream& out) const;
+   void Load(std::istream& in);
+};
+
+#endif // _AGGREGATE_NETWORK_HPP
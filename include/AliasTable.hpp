@@ -0,0 +1,55 @@
+#ifndef _ALIAS_TABLE_HPP
+#define _ALIAS_TABLE_HPP
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+/**
+ * Vose's alias method for sampling from a fixed discrete distribution
+ * over 0..n-1 in constant time.
+ *
+ * The table is built once in O(n). Each sample then takes a single
+ * uniform draw: its integer part picks a column and its fractional
+ * part chooses between the column and its alias.
+ */
+class AliasTable
+{
+private:
+   std::vector<double> probability_; // chance of keeping each column
+   std::vector<int>    alias_;       // the other outcome in each column
+
+public:
+   /**
+    * Build the table for outcome i having weight weights[i]. The
+    * weights need not be normalized but must be non-negative with a
+    * positive sum.
+    */
+   AliasTable(const std::vector<double>& weights);
+   ~AliasTable();
+
+   /**
+    * Get the number of outcomes.
+    */
+   int Size() const;
+
+   /**
+    * Get the probability of outcome i.
+    */
+   double Probability(int i) const;
+
+   /**
+    * Draw an outcome.
+    */
+   template<typename Generator>
+   int operator()(Generator& gen) const
+      {
+         const int n = probability_.size();
+         std::uniform_real_distribution<double> u(0.0, n);
+         double x = u(gen);
+         int column = std::min((int)x, n - 1);
+         return (x - column) < probability_[column] ? column : alias_[column];
+      }
+};
+
+#endif // _ALIAS_TABLE_HPP
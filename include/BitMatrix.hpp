@@ -0,0 +1,75 @@
+#ifndef _BIT_MATRIX_HPP
+#define _BIT_MATRIX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * A square matrix of bits packed 64 to a word, one row after another.
+ */
+class BitMatrix
+{
+private:
+   int                        size_;
+   int                        words_per_row_;
+   std::vector<std::uint64_t> words_;
+
+public:
+   BitMatrix(int size = 0) :
+      size_(size),
+      words_per_row_((size + 63) / 64),
+      words_((std::size_t)size * ((size + 63) / 64), 0)
+      {}
+
+   int Size() const { return size_; }
+   int WordsPerRow() const { return words_per_row_; }
+
+   bool Test(int i, int j) const
+      {
+         return (Row(i)[j / 64] >> (j % 64)) & 1;
+      }
+
+   /**
+    * Set bit (i, j). Returns true if it was not already set.
+    */
+   bool Set(int i, int j)
+      {
+         std::uint64_t& word = words_[(std::size_t)i * words_per_row_ + j / 64];
+         std::uint64_t  bit  = (std::uint64_t)1 << (j % 64);
+         bool was_set = (word & bit) != 0;
+         word |= bit;
+         return !was_set;
+      }
+
+   /**
+    * Clear bit (i, j).
+    */
+   void Reset(int i, int j)
+      {
+         words_[(std::size_t)i * words_per_row_ + j / 64] &= ~((std::uint64_t)1 << (j % 64));
+      }
+
+   /**
+    * Clear every bit.
+    */
+   void Clear()
+      {
+         std::fill(words_.begin(), words_.end(), 0);
+      }
+
+   /**
+    * Get the words holding row i.
+    */
+   const std::uint64_t* Row(int i) const
+      {
+         return words_.data() + (std::size_t)i * words_per_row_;
+      }
+
+   std::uint64_t* Row(int i)
+      {
+         return words_.data() + (std::size_t)i * words_per_row_;
+      }
+};
+
+#endif // _BIT_MATRIX_HPP
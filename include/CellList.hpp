@@ -0,0 +1,87 @@
+#ifndef _CELL_LIST_HPP
+#define _CELL_LIST_HPP
+
+#include <vector>
+#include <utility>
+
+#include "Point.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * A uniform grid (cell list) over the square [-arena_size/2,
+ * arena_size/2] used to find every pair of points that lie within
+ * some range of each other without comparing all pairs.
+ *
+ * Each cell is at least as wide as the range, so a point can only be
+ * within range of points in its own cell or one of the eight
+ * surrounding cells.
+ *
+ * The coordinates are copied in cell order when the grid is built.
+ * Neighboring cells in a row are then contiguous, so each point is
+ * compared with all of its candidates in two batched range tests (see
+ * Proximity.hpp).
+ */
+class CellList
+{
+private:
+   double arena_size_;
+   double range_;
+   double squared_range_; // see proximity::SquaredRange()
+   int    cells_per_side_;
+   double cell_size_;
+
+   std::vector<int> cell_start_;  // offset of the first point in each cell
+   std::vector<int> cell_points_; // point indices grouped by cell
+   std::vector<double> cell_x_;   // coordinates of the points in cell_points_ order
+   std::vector<double> cell_y_;
+   std::vector<int> point_cell_;  // the cell containing each point
+   std::vector<int> next_;        // scratch space for Build()
+
+   int CellIndex(double coordinate) const;
+   void Resize(int num_points);
+
+   /**
+    * Append the pairs whose first cell lies in grid rows [first_row,
+    * last_row).
+    */
+   void RowPairs(const std::vector<Point>& points, int first_row, int last_row,
+                 std::vector<std::pair<int,int>>& pairs) const;
+
+public:
+   CellList(double arena_size, double range);
+   ~CellList();
+   CellList(const CellList&) = default;
+   CellList(CellList&&) = default;
+   CellList& operator=(const CellList&) = default;
+   CellList& operator=(CellList&&) = default;
+
+   /**
+    * Bin the points into the grid. Points outside the arena are
+    * placed in the nearest cell.
+    */
+   void Build(const std::vector<Point>& points);
+
+   /**
+    * Find every pair (i, j) with i < j such that points[i] and
+    * points[j] are within range of each other. The points must be the
+    * same points last passed to Build(). Any existing contents of
+    * pairs are discarded.
+    */
+   void Pairs(const std::vector<Point>& points,
+              std::vector<std::pair<int,int>>& pairs) const;
+
+   /**
+    * Same as Pairs() but with the grid rows split over a thread
+    * pool. The pairs are listed in the same order.
+    */
+   void Pairs(const std::vector<Point>& points,
+              std::vector<std::pair<int,int>>& pairs,
+              ThreadPool& pool) const;
+
+   /**
+    * Get the number of cells along each side of the grid.
+    */
+   int CellsPerSide() const;
+};
+
+#endif // _CELL_LIST_HPP
@@ -0,0 +1,120 @@
+#ifndef _CONVERGENCE_DETECTOR_HPP
+#define _CONVERGENCE_DETECTOR_HPP
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * Decides when the outcome of an LCA run is settled, so the run can
+ * stop before its maximum time.
+ *
+ * The detector is shown the states after every step (and before the
+ * first one) and looks for:
+ *
+ *  - consensus: every agent in the same state;
+ *  - a fixed point or a cycle: the state vector repeating with some
+ *    period p <= max period, for `repeats` periods in a row. State
+ *    vectors are compared by a 64 bit hash;
+ *  - a plateau: the density staying within a tolerance over a window
+ *    of steps.
+ *
+ * Only consensus is detected by default. Agents keep moving, so a
+ * cycle or plateau is not strictly absorbing the way consensus is
+ * (without noise): the longer the repeats or window, the surer the
+ * outcome.
+ */
+class ConvergenceDetector
+{
+public:
+   enum class Outcome {
+      Undecided,
+      Consensus,  // every agent in the same state
+      FixedPoint, // the state vector stopped changing
+      Cycle,      // the state vector repeats with a period > 1
+      Plateau,    // the density stayed within the tolerance
+   };
+
+   /**
+    * Default number of periods a cycle must repeat for.
+    */
+   static const int DEFAULT_REPEATS = 10;
+
+private:
+   bool   consensus_;
+   int    max_period_;
+   int    repeats_;
+   int    plateau_window_;
+   double plateau_tolerance_;
+
+   Outcome outcome_;
+   int     period_;
+   int     observed_;
+
+   std::vector<std::uint64_t> hashes_;    // ring of the last max_period_ + 1 hashes
+   std::vector<int>           matches_;   // matches_[p]: steps in a row with period p
+   std::vector<double>        densities_; // ring of the last plateau_window_ densities
+
+   static std::uint64_t Hash(const std::vector<int>& states);
+
+   Outcome Decide(const std::vector<int>& states, int ones);
+
+public:
+   ConvergenceDetector();
+   ~ConvergenceDetector();
+
+   /**
+    * Turn consensus detection on or off.
+    */
+   void DetectConsensus(bool detect);
+
+   /**
+    * Stop once the states repeat with a period of at most max_period
+    * steps for repeats periods in a row. A max_period of 0 turns cycle
+    * detection off.
+    */
+   void DetectCycles(int max_period, int repeats = DEFAULT_REPEATS);
+
+   /**
+    * Stop once the largest and smallest density over the last window
+    * observations differ by at most tolerance. A window of 0 turns
+    * plateau detection off.
+    */
+   void DetectPlateau(int window, double tolerance);
+
+   /**
+    * Forget everything observed, keeping the settings.
+    */
+   void Reset();
+
+   /**
+    * Look at the states after a step, along with the number of them in
+    * state 1. Once an outcome is decided it does not change until
+    * Reset().
+    * @return the outcome so far.
+    */
+   Outcome Observe(const std::vector<int>& states, int ones);
+
+   Outcome GetOutcome() const;
+
+   /**
+    * Returns true once an outcome other than Undecided was found.
+    */
+   bool IsDecided() const;
+
+   /**
+    * Get the period of the fixed point (1) or cycle found, or 0.
+    */
+   int Period() const;
+
+   /**
+    * Get the number of observations since the last Reset().
+    */
+   int Observed() const;
+
+   /**
+    * Get a short name for an outcome, e.g. "consensus".
+    */
+   static const char* Name(Outcome outcome);
+};
+
+#endif // _CONVERGENCE_DETECTOR_HPP
@@ -0,0 +1,226 @@
+#ifndef _ENSEMBLE_RUNNER_HPP
+#define _ENSEMBLE_RUNNER_HPP
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <utility> // std::declval
+
+#include "ThreadPool.hpp"
+#include "LCAFactory.hpp"
+#include "SweepCheckpoint.hpp"
+
+/**
+ * Runs an ensemble of independent simulations -- several replicas at
+ * each of several parameter settings -- on a work-stealing thread
+ * pool.
+ *
+ * Every (parameter, replica) pair is a separate task, so a few slow
+ * parameter settings (e.g. initial densities near 0.5) do not hold up
+ * a whole thread. Each task writes its result to its own slot, so no
+ * lock is needed to collect the results, and results are returned in
+ * parameter and replica order regardless of which thread ran them.
+ */
+class EnsembleRunner
+{
+private:
+   ThreadPool pool_;
+
+   // Wrapper so that results of type bool are not packed into a
+   // std::vector<bool>, whose elements can't be written concurrently.
+   template<typename T>
+   struct Slot
+   {
+      T value;
+   };
+
+   /**
+    * LCAs that finished a replica, kept to be reset for the next one
+    * rather than making a new LCA per replica. There are never more
+    * than one per thread.
+    */
+   class SpareLCAs
+   {
+   private:
+      const LCAFactory&                 factory_;
+      std::mutex                        mutex_;
+      std::vector<std::unique_ptr<LCA>> lcas_;
+
+   public:
+      explicit SpareLCAs(const LCAFactory& factory) : factory_(factory) {}
+
+      /**
+       * Get an LCA as made by factory.Create(initial_density, seed).
+       */
+      std::unique_ptr<LCA> Take(double initial_density, int seed)
+         {
+            std::unique_ptr<LCA> lca;
+            {
+               std::lock_guard<std::mutex> lock(mutex_);
+               if(!lcas_.empty())
+               {
+                  lca = std::move(lcas_.back());
+                  lcas_.pop_back();
+               }
+            }
+            if(lca)
+            {
+               factory_.Reset(*lca, initial_density, seed);
+               return lca;
+            }
+            return factory_.Create(initial_density, seed);
+         }
+
+      void Give(std::unique_ptr<LCA> lca)
+         {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lcas_.push_back(std::move(lca));
+         }
+   };
+
+   /**
+    * The task for replica r at density index d of a factory run:
+    * measure an LCA seeded with factory.Seed(d, r). Shared by the
+    * factory overloads of Run() so that only the checkpointed one
+    * needs results that can be written to a checkpoint.
+    */
+   template<typename F>
+   static auto ReplicaTask(SpareLCAs& spares, const LCAFactory& factory,
+                           const std::vector<double>& densities, F& measure)
+      {
+         return [&spares, &factory, &densities, &measure](int d, int r)
+            {
+               std::unique_ptr<LCA> lca = spares.Take(densities[d], factory.Seed(d, r));
+               auto result = measure(*lca);
+               spares.Give(std::move(lca));
+               return result;
+            };
+      }
+
+public:
+   /**
+    * @param num_threads the number of threads to use, or one per core
+    * if num_threads < 1.
+    */
+   explicit EnsembleRunner(int num_threads = 0);
+   ~EnsembleRunner();
+
+   int NumThreads() const;
+
+   /**
+    * Call f(parameter, replica) for every parameter in [0,
+    * num_parameters) and replica in [0, replicas). f is called from
+    * several threads at once.
+    * @return results[parameter][replica]
+    */
+   template<typename F>
+   auto Run(int num_parameters, int replicas, F f)
+      -> std::vector<std::vector<decltype(f(0, 0))>>
+      {
+         typedef decltype(f(0, 0)) Result;
+         std::vector<Slot<Result>> slots(num_parameters * replicas);
+         pool_.Run(slots.size(), [&slots, &f, replicas](int t)
+                   {
+                      slots[t].value = f(t / replicas, t % replicas);
+                   });
+
+         std::vector<std::vector<Result>> results(num_parameters);
+         for(int p = 0; p < num_parameters; p++)
+         {
+            for(int r = 0; r < replicas; r++)
+            {
+               results[p].push_back(std::move(slots[p * replicas + r].value));
+            }
+         }
+         return results;
+      }
+
+   /**
+    * Same as Run(num_parameters, replicas, f), but skip the cells
+    * already recorded in checkpoint and record each new result there
+    * as soon as it is computed, so a sweep that is stopped can be
+    * resumed. Results must be readable and writable with operator>>
+    * and operator<<. If checkpoint is null nothing is recorded.
+    *
+    * Tasks on the pool must not throw, so if recording a result fails
+    * the first error is kept, the cells not yet started are skipped,
+    * and the error is rethrown here once the pool is done.
+    */
+   template<typename F>
+   auto Run(int num_parameters, int replicas, F f, SweepCheckpoint* checkpoint)
+      -> std::vector<std::vector<decltype(f(0, 0))>>
+      {
+         typedef decltype(f(0, 0)) Result;
+         if(checkpoint == nullptr)
+         {
+            return Run(num_parameters, replicas, f);
+         }
+
+         std::mutex         error_mutex;
+         std::exception_ptr error;
+         std::atomic<bool>  failed(false);
+         auto record = [&f, checkpoint, &error_mutex, &error, &failed](int p, int r)
+            {
+               Result result;
+               if(!failed && !checkpoint->Get(p, r, result))
+               {
+                  result = f(p, r);
+                  try
+                  {
+                     checkpoint->Put(p, r, result);
+                  }
+                  catch(...)
+                  {
+                     std::lock_guard<std::mutex> lock(error_mutex);
+                     if(!error)
+                     {
+                        error = std::current_exception();
+                     }
+                     failed = true;
+                  }
+               }
+               return result;
+            };
+         auto results = Run(num_parameters, replicas, record);
+         if(error)
+         {
+            std::rethrow_exception(error);
+         }
+         return results;
+      }
+
+   /**
+    * Run replicas of the factory's LCA at each initial density. Replica
+    * r at density index d is seeded with factory.Seed(d, r), so the
+    * results only depend on the factory's seed. Each thread resets
+    * and reuses one LCA for its replicas (see LCAFactory::Reset()).
+    * @param measure called with each new LCA; runs it and returns the
+    * quantity of interest.
+    * @return results[density][replica]
+    */
+   template<typename F>
+   auto Run(const LCAFactory& factory, const std::vector<double>& densities, int replicas, F measure)
+      -> std::vector<std::vector<decltype(measure(std::declval<LCA&>()))>>
+      {
+         SpareLCAs spares(factory);
+         return Run(densities.size(), replicas, ReplicaTask(spares, factory, densities, measure));
+      }
+
+   /**
+    * Same as Run(factory, densities, replicas, measure), but resumable
+    * through checkpoint as above.
+    */
+   template<typename F>
+   auto Run(const LCAFactory& factory, const std::vector<double>& densities, int replicas, F measure,
+            SweepCheckpoint* checkpoint)
+      -> std::vector<std::vector<decltype(measure(std::declval<LCA&>()))>>
+      {
+         SpareLCAs spares(factory);
+         return Run(densities.size(), replicas, ReplicaTask(spares, factory, densities, measure),
+                    checkpoint);
+      }
+};
+
+#endif // _ENSEMBLE_RUNNER_HPP
@@ -3,8 +3,10 @@
 
 #include <memory>
 #include <functional>
+#include <iostream>
 
 #include "Model.hpp"
+#include "ConvergenceDetector.hpp"
 
 /**
  * An LCA experiment.
@@ -15,10 +17,28 @@ private:
    int                    max_time_;
    std::shared_ptr<Rule>  update_rule_;
    std::unique_ptr<Model> model_;
+   ConvergenceDetector    convergence_;
 public:
    LCA(const Model& m, std::shared_ptr<Rule> update_rule, int max_time);
+
+   /**
+    * Take over model instead of copying it.
+    */
+   LCA(Model&& m, std::shared_ptr<Rule> update_rule, int max_time);
+   LCA(std::unique_ptr<Model> m, std::shared_ptr<Rule> update_rule, int max_time);
    ~LCA();
 
+   /**
+    * Start the experiment over with a new seed and initial density,
+    * reusing the model's buffers (see Model::Reset()).
+    */
+   void Reset(int seed, double initial_density);
+
+   /**
+    * Set the states by position (see Model::SetPositionalState()).
+    */
+   void SetPositionalState(double initial_density);
+
    /**
     * Run the LCA Simulation for 'max_time_' time steps
     */
@@ -32,6 +52,33 @@ public:
     */
    int Run(std::function<bool(const ModelStats&)> early_stop);
 
+   /**
+    * Run the LCA Simulation for 'max_time_' steps or until the
+    * convergence detector decides the outcome (by default, when the
+    * agents reach consensus). The detector sees the states before the
+    * first step too.
+    * @return the number of steps taken when the run stopped.
+    */
+   int RunUntilDecided();
+
+   /**
+    * Set the convergence detector used by RunUntilDecided(). It is
+    * reset first.
+    */
+   void SetConvergence(const ConvergenceDetector& detector);
+
+   /**
+    * Get the convergence detector, e.g. for the outcome of the last
+    * RunUntilDecided().
+    */
+   const ConvergenceDetector& GetConvergence() const;
+
+   /**
+    * Run the LCA Simulation until the model has taken 'max_time_' time
+    * steps in total, e.g. to finish a run restored with Load().
+    */
+   void Resume();
+
    /**
     * Run the LCA simulation for the given number of time steps.
     * @param k the number of steps to run.
@@ -40,11 +87,42 @@ public:
 
    const ModelStats& GetStats() const;
 
-   const std::vector<Agent>& GetAgents() const;
+   /**
+    * Get the underlying model.
+    */
+   const Model& GetModel() const;
+
+   /**
+    * Get the model's step profile. All zero unless built with
+    * LCA_PROFILE.
+    */
+   const StepProfile& GetProfile() const;
+
+   /**
+    * Get copies of the agents. Each copy carries its own generator and
+    * movement rule; per-frame readers should use
+    * GetModel().GetAgentStore() instead.
+    */
+   std::vector<Agent>        GetAgents() const;
    const std::vector<int>&   GetStates() const;
    std::shared_ptr<NetworkSnapshot> CurrentNetwork() const;
    double CurrentDensity() const;
    void MinimizeMemory();
+
+   /**
+    * Keep the stats in constant memory: only the last window
+    * densities and running summaries (see ModelStats::Streaming()).
+    * Enough for early stopping on the current density and for
+    * IsCorrect().
+    */
+   void StreamStats(int window = ModelStats::DEFAULT_WINDOW);
+
+   /**
+    * Save the state of the model, or restore one saved from an LCA
+    * made the same way (see Model::Save() and Model::Load()).
+    */
+   void Save(std::ostream& out) const;
+   void Load(std::istream& in);
 };
 
 #endif // _LCA_HPP
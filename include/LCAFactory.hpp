@@ -3,11 +3,15 @@
 
 #include <memory>
 #include <mutex>
+#include <cstdint>
 
 #include "Rule.hpp"
 #include "MovementRule.hpp"
+#include "TotalisticRule.hpp"
 #include "Model.hpp"
 #include "LCA.hpp"
+#include "SweepCheckpoint.hpp"
+#include "ConvergenceDetector.hpp"
 
 /**
  * A factory for building LCA experiment instances
@@ -21,6 +25,7 @@ private:
    double                             communication_range_;
    int                                arena_size_;
    int                                seed_;
+   std::uint64_t                      base_seed_; /* seed used for Seed(), set by Init() */
    double                             speed_;
    int                                max_time_; /* max number of time steps to run */
    std::shared_ptr<MovementRule>      movement_rule_;
@@ -29,6 +34,14 @@ private:
    std::uniform_int_distribution<int> seed_distribution_;
    double                             pdark_ = 0;
    double                             pinteractive_ = 1;
+   Model::NeighborSearch              neighbor_search_ = Model::NeighborSearch::CellList;
+   double                             verlet_skin_ = 0; /* skin of the Verlet neighbor search */
+   int                                rule_max_degree_ = TotalisticRule::DEFAULT_MAX_DEGREE; /* largest neighborhood in the rule lookup table */
+   bool                               counter_rng_ = false;
+   int                                threads_ = 1; /* threads used within each model step */
+   bool                               profile_ = false;
+   std::unique_ptr<SweepCheckpoint>   checkpoint_; /* set by --checkpoint */
+   ConvergenceDetector                convergence_; /* given to every LCA for RunUntilDecided() */
 
    enum InitializationMethod {
       Uniform,    // initialize states at random
@@ -58,6 +71,32 @@ public:
     */
    std::unique_ptr<LCA> Create(double initial_density);
 
+   /**
+    * Make a new LCA instance with the given model seed. Unlike
+    * Create(double) the result does not depend on how many LCAs were
+    * made before, so experiments run in parallel are reproducible.
+    * This operation is thread safe.
+    * @param initial_density initial fraction of 'ones'
+    * @param seed the seed of the new model, e.g. from Seed().
+    * @return A new LCA instance
+    */
+   std::unique_ptr<LCA> Create(double initial_density, int seed) const;
+
+   /**
+    * Start lca, made by Create(), over as if it had been made by
+    * Create(initial_density, seed), reusing its buffers. This
+    * operation is thread safe as long as each thread resets its own
+    * LCA.
+    */
+   void Reset(LCA& lca, double initial_density, int seed) const;
+
+   /**
+    * Get a seed for one replica of one parameter setting in an
+    * ensemble. The seed depends only on the arguments and the --seed
+    * option (or the random seed chosen by Init() if there is none).
+    */
+   int Seed(int parameter, int replica) const;
+
    /**
     * Set the maximum time the simulation will run.
     * @param t maximum number of time steps.
@@ -78,6 +117,21 @@ public:
     */
    void RecordStateHistory(bool record);
 
+   /**
+    * Returns true if --profile was given, i.e. the driver should print
+    * the step profiles of the LCAs it runs.
+    */
+   bool Profile() const;
+
+   /**
+    * Get the checkpoint given with --checkpoint <file>, or null if
+    * there is none. The checkpoint is tied to the full command line
+    * passed to Init(); if it already existed, Seed() uses the seed
+    * saved in it, so a restarted sweep without --seed continues with
+    * the seeds it started with.
+    */
+   SweepCheckpoint* Checkpoint() const;
+
    /**
     * Get the arena size used by the factory.
     */
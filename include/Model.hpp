@@ -2,44 +2,162 @@
 #define _MOTION_CA_MODEL_HPP
 
 #include <vector>
+#include <iostream>
 #include <random>
 #include <functional>
 #include <memory>
 
 #include "Agent.hpp"
+#include "AgentStore.hpp"
 #include "Network.hpp"
 #include "Rule.hpp"
 #include "ModelStats.hpp"
+#include "ThreadPool.hpp"
+#include "NetworkBuilder.hpp"
+#include "BitMatrix.hpp"
+#include "StepProfile.hpp"
 
 /**
  * The model of moving agents.
  */
 class Model
 {
+public:
+   /**
+    * How to find the pairs of agents that are within communication
+    * range of each other (see NetworkBuilder::Method).
+    */
+   typedef NetworkBuilder::Method NeighborSearch;
+
 private:
    ModelStats         _stats;
 
-   std::vector<Agent> _agents;
+   AgentStore         _agents;
    std::vector<int>   _agent_states;
+   int                _ones; // agents in state 1, kept up to date by every change of state
    int                _steps;
    double             _arena_size;
+   int                _seed;
 
    std::mt19937_64 _rng;
+   bool            _counter_rng; // draw from per-agent Philox streams instead of _rng
    std::function<double(std::mt19937_64&)> _turn_distribution;
    std::function<int(std::mt19937_64&)>    _step_distribution;
    std::bernoulli_distribution             _noise;
    std::bernoulli_distribution             go_dark_;
    std::bernoulli_distribution             go_interactive_;
    double                                  _noise_probability;
+   bool                                    _initial_dark; // SetPDark() drew the first modes
 
    double _communication_range;
 
-   int Noise(int i);
+   std::shared_ptr<ThreadPool> _thread_pool;
+
+   StepProfile _profile;
+
+   // scratch space reused by every Step()
+   std::vector<int>   _new_states;
+   std::vector<Point> _positions;
+   NetworkBuilder     _network_builder; // only NextNetwork() builds with it
+
+   // bit-packed states for dense networks; see PackStates().
+   bool                       _packed_states;
+   std::vector<std::uint64_t> _packed_ones;        // interactive agents in state 1
+   std::vector<std::uint64_t> _packed_interactive; // interactive agents
+
+   /**
+    * Build the current network in the scratch space. The snapshot is
+    * reused unless something else still holds it (e.g. the stats).
+    */
+   std::shared_ptr<NetworkSnapshot> NextNetwork();
+
+   template<typename Generator>
+   int Noise(int i, Generator& gen);
+
+   /**
+    * Call f with the (possibly noisy) state of each interactive
+    * neighbor.
+    */
+   template<typename Generator, typename F>
+   void ForEachNeighborState(const NeighborView& neighbors, Generator& gen, F f);
+
+   /**
+    * Randomly switch agent i between the dark and interactive modes.
+    */
+   template<typename Generator>
+   void UpdateMode(int i, Generator& gen);
+
+   /**
+    * Compute the new state of agent a.
+    */
+   template<typename Generator>
+   std::pair<int, double> Update(const Rule* rule, bool totalistic, int a,
+                                 const NetworkSnapshot& network, Generator& gen);
+
+   /**
+    * Compute the new state of agent a from the packed states: the sum
+    * of its neighbors' states is a popcount of its adjacency row ANDed
+    * with the packed states.
+    */
+   std::pair<int, double> UpdatePacked(const Rule* rule, const BitMatrix& adjacency, int a) const;
+
+   /**
+    * Pack the states into bitsets if the new states can be computed
+    * from them and the adjacency rows the network builder kept, which
+    * needs a totalistic rule, binary states, no noise to draw (see
+    * ForEachNeighborState()) and a dense network found by the Verlet
+    * search (see NetworkBuilder::KeepAdjacency()).
+    * @return the adjacency rows of the current network if the states
+    * were packed, or null.
+    */
+   const BitMatrix* PackStates(const Rule* rule);
+
+   /**
+    * Update the modes of agents [begin, end).
+    */
+   void UpdateModes(int begin, int end);
+
+   /**
+    * Compute the new states of agents [begin, end) and turn them, from
+    * the packed states if adjacency is not null.
+    * @return the change in the number of agents in state 1.
+    */
+   int UpdateStates(const Rule* rule, const NetworkSnapshot& network, const BitMatrix* adjacency,
+                    std::vector<int>& new_states, int begin, int end);
+
+   /**
+    * Send each agent dark with the probability of going dark.
+    */
+   void DrawInitialModes();
+
+   /**
+    * Place num_agents agents with random positions, headings and
+    * states drawn from _rng, and record the initial state.
+    */
+   void Populate(int num_agents, double initial_density);
+
+   /**
+    * Recount the agents in state 1 after the states were replaced.
+    */
+   void CountOnes();
 
 public:
    Model(double arena_size, int num_agents, double communication_range,
          int seed, double initial_density, double agent_speed = 1.0);
    ~Model();
+   Model(const Model&) = default;
+   Model(Model&&) = default;
+   Model& operator=(const Model&) = default;
+   Model& operator=(Model&&) = default;
+
+   /**
+    * Start over as if newly made with the given seed and initial
+    * density, keeping every setting (movement rule, noise, threads,
+    * neighbor search, what the stats record, ...) and reusing the
+    * buffers. Gives the same run as a new model with the same settings
+    * (with SetPDark() called at most once).
+    */
+   void Reset(int seed, double initial_density);
 
    /**
     * Reinitialize the model with states set according to x-coordinate
@@ -55,8 +173,27 @@ public:
     */
    double CurrentDensity() const;
 
+   /**
+    * Get the number of agents in state 1. Kept as a running count, so
+    * this is constant time.
+    */
+   int CurrentOnes() const;
+
+   /**
+    * Search for the network of agents within range of each other at
+    * their current positions. The search runs on the calling thread
+    * with its own cell list, so it leaves the Verlet candidates alone
+    * and is safe to call from several threads at once.
+    */
    std::shared_ptr<NetworkSnapshot> CurrentNetwork() const;
 
+   /**
+    * Get the network the last Step() (or the constructor) built for the
+    * current positions, without searching again. The snapshot is not
+    * changed by later steps while it is held.
+    */
+   std::shared_ptr<NetworkSnapshot> StepNetwork() const;
+
    /**
     * Get the density of the communication network.
     */
@@ -67,21 +204,40 @@ public:
     */
    void RecordNetworkDensityOnly();
 
+   /**
+    * Keep only the last window densities and running summaries in the
+    * stats (see ModelStats::Streaming()).
+    */
+   void StreamStats(int window = ModelStats::DEFAULT_WINDOW);
+
    /**
     * Get statistics about the model.
     */
    const ModelStats& GetStats() const;
 
    /**
-    * Get the agents from the model.
+    * Get copies of the agents in the model.
+    */
+   std::vector<Agent> GetAgents() const;
+
+   /**
+    * Get the agents from the model without copying them.
     */
-   const std::vector<Agent>& GetAgents() const;
+   const AgentStore& GetAgentStore() const;
 
    /**
     * Get the current states of the agents
     */
    const std::vector<int>& GetStates() const;
 
+   /**
+    * Make room for the statistics of the next steps time steps. Once
+    * room is reserved, and with RecordNetworkDensityOnly(), Step()
+    * makes no heap allocations after the first step (except what the
+    * rule itself allocates).
+    */
+   void Reserve(int steps);
+
    /**
     * Set the movement rule.
     */
@@ -97,6 +253,36 @@ public:
     */
    void SetStepDistribution(std::function<int(std::mt19937_64&)> step_distribution);
 
+   /**
+    * Use counter-based random streams keyed on (seed, agent, step)
+    * for all random draws made while stepping the model, instead of
+    * one Mersenne twister per agent plus one for the model. This
+    * makes copies of the model much smaller and makes every agent's
+    * draws independent of every other agent's, but gives different
+    * (equally valid) trajectories than the default generators.
+    */
+   void UseCounterRng();
+
+   /**
+    * Split each step over num_threads threads (one per core if
+    * num_threads < 1). Movement and neighbor search are always done in
+    * parallel. Random mode changes and noise are only drawn in parallel
+    * with counter-based streams (see UseCounterRng()), since otherwise
+    * every agent draws from the model's single generator. Results are
+    * the same for any number of threads.
+    */
+   void SetThreads(int num_threads);
+
+   /**
+    * Allow (the default) or forbid summing neighbor states with
+    * popcounts over bit-packed states on dense networks. This only
+    * happens with the Verlet search, which keeps the adjacency rows
+    * between steps, with counter-based streams (see UseCounterRng())
+    * and with no noise, where skipping the noise draws cannot change
+    * the run, so the results are the same either way.
+    */
+   void UsePackedStates(bool use);
+
    /**
     * Set the amount of noise. p is a real number in [0,1].
     */
@@ -117,10 +303,58 @@ public:
     */
    void Step(const Rule* rule);
 
+   /**
+    * Get the number of steps taken so far.
+    */
+   int Steps() const;
+
+   /**
+    * Write the state of the model -- agents, states, random number
+    * generators, step count, noise and mode settings, and stats -- to
+    * a binary stream.
+    */
+   void Save(std::ostream& out) const;
+
+   /**
+    * Replace the state of the model with one written by Save(). The
+    * model must have been made with the same number of agents, arena,
+    * communication range, speed and movement rule (e.g. by the same
+    * LCAFactory); stepping it then continues exactly as the saved
+    * model would have. Execution settings (threads, neighbor search)
+    * are kept. Throws std::runtime_error if the stream does not hold a
+    * matching saved model.
+    */
+   void Load(std::istream& in);
+
+   /**
+    * Get the time spent in each phase of Step() and the work done so
+    * far. All zero unless built with LCA_PROFILE.
+    */
+   const StepProfile& GetProfile() const;
+
    /**
     * Set the communication range of the agents.
     */
    void SetCommunicationRange(double range);
+
+   /**
+    * Set the method used to build the communication network. All
+    * methods produce identical networks.
+    */
+   void SetNeighborSearch(NeighborSearch method);
+
+   /**
+    * Set the skin of the Verlet neighbor search. A larger skin means
+    * fewer rebuilds but more candidate pairs to filter each step. The
+    * default is ten steps of straight-line motion, capped at half the
+    * communication range.
+    */
+   void SetVerletSkin(double skin);
+
+   /**
+    * Get the number of times the Verlet candidate list has been built.
+    */
+   int VerletRebuilds() const;
 };
 
 #endif // _MOTION_CA_MODEL_HPP
@@ -0,0 +1,209 @@
+#ifndef _MODEL_BATCH_HPP
+#define _MODEL_BATCH_HPP
+
+#include <vector>
+#include <random>
+#include <memory>
+#include <functional>
+
+#include "Heading.hpp"
+#include "MovementRule.hpp"
+#include "Network.hpp"
+#include "ModelStats.hpp"
+#include "NetworkBuilder.hpp"
+#include "Rule.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Many replicas of the same model, differing only in their seeds,
+ * advanced in lockstep.
+ *
+ * Per-agent data is stored with the replica index innermost, so the
+ * value for agent i in replica r is at [i * NumReplicas() + r] and the
+ * movement and mode loops run over all the replicas of an agent in
+ * contiguous memory. Each replica has its own communication network,
+ * so neighbor search and the state update are done one replica at a
+ * time, with the replicas split over a thread pool. Each replica keeps
+ * its own NetworkBuilder and scratch buffers, so as in Model a step
+ * makes no heap allocations once they have grown.
+ *
+ * Every replica draws from counter-based streams, so replica r follows
+ * exactly the same trajectory as
+ *
+ *    Model m(arena_size, num_agents, range, seeds[r], density, speed);
+ *    m.UseCounterRng();
+ *
+ * given the same settings and rule.
+ *
+ * Replicas can be stopped independently; a stopped replica keeps its
+ * final state and statistics while the others continue.
+ */
+class ModelBatch
+{
+private:
+   int    num_agents_;
+   int    num_replicas_;
+   double arena_size_;
+   double speed_;
+
+   std::vector<int>             seeds_;
+   std::vector<std::mt19937_64> generators_; // used only while setting up
+   std::vector<int>             steps_;
+   std::vector<unsigned char>   active_;
+   std::vector<ModelStats>      stats_;
+   std::vector<int>             ones_; // agents in state 1 in each replica
+
+   // per (agent, replica), replica innermost
+   std::vector<double>        x_;
+   std::vector<double>        y_;
+   std::vector<Heading>       heading_;
+   std::vector<unsigned char> dark_;
+   std::vector<int>           states_;
+   std::vector<std::shared_ptr<MovementRule>> movement_rules_;
+   bool                                       straight_; // the rule never turns
+
+   std::bernoulli_distribution noise_;
+   std::bernoulli_distribution go_dark_;
+   std::bernoulli_distribution go_interactive_;
+   double                      noise_probability_;
+
+   std::shared_ptr<ThreadPool> thread_pool_;
+
+   // scratch space used by Step()
+   std::vector<double>        dx_;
+   std::vector<double>        dy_;
+   std::vector<unsigned char> out_of_bounds_;
+   std::vector<int>           new_states_;
+
+   // per replica scratch space, each only touched by its replica's task
+   std::vector<NetworkBuilder>     builders_;
+   std::vector<std::vector<Point>>         positions_;
+   std::vector<std::vector<int>>           replica_states_;
+   std::vector<std::vector<unsigned char>> replica_dark_;
+   std::vector<std::vector<int>>           neighbor_states_;
+
+   int Index(int agent, int replica) const;
+
+   /**
+    * Build the network of replica r at its current positions.
+    */
+   std::shared_ptr<NetworkSnapshot> NextNetwork(int r);
+
+   void Reflect(int k);
+
+   /**
+    * Move, turn and change the modes of the agents of every active
+    * replica.
+    */
+   void Move();
+
+   /**
+    * Build the network of replica r and compute its new states.
+    * @return the change in the number of agents in state 1.
+    */
+   int UpdateStates(const Rule* rule, int r);
+
+public:
+   /**
+    * Create one replica for each seed.
+    */
+   ModelBatch(double arena_size, int num_agents, double communication_range,
+              const std::vector<int>& seeds, double initial_density, double agent_speed = 1.0);
+   ~ModelBatch();
+
+   int NumAgents() const;
+   int NumReplicas() const;
+
+   /**
+    * Give every agent of every replica its own copy of the movement
+    * rule.
+    */
+   void SetMovementRule(std::shared_ptr<MovementRule> rule);
+
+   /**
+    * Same as the corresponding Model settings.
+    */
+   void SetNoise(double p);
+   void SetPDark(double p);
+   void SetPInteractive(double p);
+
+   /**
+    * Split the replicas of each step over num_threads threads (one
+    * per core if num_threads < 1). Results are the same for any number
+    * of threads.
+    */
+   void SetThreads(int num_threads);
+
+   /**
+    * Only save the density of each replica's network snapshots.
+    */
+   void RecordNetworkDensityOnly();
+
+   /**
+    * Make room for the statistics of the next steps time steps in
+    * every replica (see Model::Reserve()).
+    */
+   void Reserve(int steps);
+
+   /**
+    * Same as the corresponding Model settings, applied to every
+    * replica.
+    */
+   void SetNeighborSearch(NetworkBuilder::Method method);
+   void SetVerletSkin(double skin);
+
+   /**
+    * Get the number of times replica r's Verlet candidates were built.
+    */
+   int VerletRebuilds(int r) const;
+
+   /**
+    * Evaluate every active replica for one time-step.
+    */
+   void Step(const Rule* rule);
+
+   /**
+    * Run every replica for max_time steps or until early_stop returns
+    * true for its statistics, as LCA::Run() does for a single model.
+    * @return the number of steps run by each replica.
+    */
+   std::vector<int> Run(const Rule* rule, int max_time,
+                        std::function<bool(const ModelStats&)> early_stop);
+
+   /**
+    * Stop stepping replica r.
+    */
+   void Stop(int r);
+
+   bool IsActive(int r) const;
+
+   /**
+    * Get the number of replicas that have not been stopped.
+    */
+   int NumActive() const;
+
+   /**
+    * Get the number of steps replica r has run for.
+    */
+   int Steps(int r) const;
+
+   const ModelStats& GetStats(int r) const;
+
+   double CurrentDensity(int r) const;
+
+   /**
+    * Get the number of agents in state 1 in replica r. Kept as a
+    * running count, so this is constant time.
+    */
+   int CurrentOnes(int r) const;
+
+   /**
+    * Get copies of the states, positions or headings of the agents of
+    * replica r.
+    */
+   std::vector<int>     GetStates(int r) const;
+   std::vector<Point>   Positions(int r) const;
+   std::vector<Heading> Headings(int r) const;
+};
+
+#endif // _MODEL_BATCH_HPP
@@ -2,28 +2,66 @@
 #define _MODEL_STATS_HPP
 
 #include <vector>
+#include <iostream>
+#include <stdexcept>
 
 #include "Network.hpp"
+#include "AggregateNetwork.hpp"
 
 /**
  * Statistics about a model including current timestep, current
  * density, density at each previous timestep, and whether or not the
  * classification is correct.
+ *
+ * In streaming mode (see Streaming()) only the most recent densities
+ * are kept, in a ring buffer, along with running summaries, so memory
+ * use does not grow with the number of steps.
  */
 class ModelStats
 {
+public:
+   /**
+    * Default number of recent densities kept in streaming mode.
+    */
+   static const int DEFAULT_WINDOW = 16;
+
 private:
    Network             _network;
-   std::vector<double> _ca_density;
+   std::vector<double> _ca_density; // a ring buffer of _window densities when streaming
    std::vector<double> _network_density;
 
    bool _network_summary_only = false;
+   bool _streaming            = false;
+   int  _window               = 0;
+
+   AggregateNetwork _aggregate_network;
+
+   int  _num_agents;
+   int  _current_ones = 0;     // agents in state 1 at the current step
+   bool _consensus    = false; // all agents in the same state at the current step
 
-   NetworkSnapshot _aggregate_network;
+   // running summaries of the ca density
+   unsigned int _elapsed_time = 0;
+   double       _first_density;
+   double       _min_density;
+   double       _max_density;
+   double       _density_sum;
+   int          _first_zero = -1; // first time the density was 0
+   int          _first_one  = -1; // first time the density was 1
+
+   /**
+    * Throw std::logic_error if streaming, since what was asked for
+    * is no longer kept.
+    */
+   void CheckNotStreaming(const char* what) const;
 
 public:
    ModelStats(int num_agents);
    ~ModelStats();
+   ModelStats(const ModelStats&) = default;
+   ModelStats(ModelStats&&) = default;
+   ModelStats& operator=(const ModelStats&) = default;
+   ModelStats& operator=(ModelStats&&) = default;
 
    /**
     * Record the ca density and the density of the interaction network
@@ -31,12 +69,45 @@ public:
     */
    void PushState(double density, std::shared_ptr<NetworkSnapshot> snapshot);
 
+   /**
+    * Same as PushState() with the density given as the exact number of
+    * agents in state 1.
+    */
+   void PushCount(int ones, std::shared_ptr<NetworkSnapshot> snapshot);
+
    /**
     * Don't save the network snapshots, only save the density of each
     * snapshot.
     */
    void NetworkSummaryOnly();
 
+   /**
+    * Forget every recorded state, keeping the buffers and the choice
+    * of what is recorded (see NetworkSummaryOnly() and Streaming()).
+    */
+   void Clear();
+
+   /**
+    * Only keep the last window densities plus running summaries from
+    * now on, and stop tracking the network and the aggregate network.
+    * After this, the density history and anything about the networks
+    * throw std::logic_error. IsCorrect(), IsSynchronized(),
+    * CurrentCADensity(), RecentCADensity() and the summaries below
+    * still work. window must be at least 3.
+    */
+   void Streaming(int window = DEFAULT_WINDOW);
+
+   /**
+    * Returns true if in streaming mode.
+    */
+   bool IsStreaming() const;
+
+   /**
+    * Make room for the states of the next steps time steps so that
+    * recording them does not allocate.
+    */
+   void Reserve(int steps);
+
    /**
     * Get the sequence of densities up to this time.
     */
@@ -77,6 +148,53 @@ public:
    double MedianAggregateDegree() const;
 
    double CurrentCADensity() const;
+
+   /**
+    * Get the number of agents in state 1 at the current step. Exact
+    * if the states were recorded with PushCount(), otherwise rounded
+    * from the density.
+    */
+   int CurrentOnes() const;
+
+   /**
+    * Return true if every agent was in the same state at the current
+    * step. Unlike comparing CurrentCADensity() with 0 and 1 this is an
+    * integer comparison when the states were recorded with
+    * PushCount().
+    */
+   bool IsConsensus() const;
+
+   /**
+    * Get the ca density k steps ago (k = 0 is the current density).
+    * Throws std::out_of_range if it is not kept.
+    */
+   double RecentCADensity(int k) const;
+
+   /**
+    * Get the ca density at the first recorded step.
+    */
+   double InitialCADensity() const;
+
+   /**
+    * Get the smallest, largest and mean ca density so far.
+    */
+   double MinCADensity() const;
+   double MaxCADensity() const;
+   double MeanCADensity() const;
+
+   /**
+    * Get the first time step at which every agent was in the given
+    * state (0 or 1), or -1 if that has not happened yet.
+    */
+   int FirstPassageTime(int state) const;
+
+   /**
+    * Write everything recorded so far to a binary stream, or replace
+    * the stats with ones read from a stream. Throws
+    * std::runtime_error if the stream is not saved stats.
+    */
+   void Save(std::ostream& out) const;
+   void Load(std::istream& in);
 };
 
 #endif // _MODEL_STATS_HPP
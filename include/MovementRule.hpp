@@ -3,9 +3,14 @@
 
 #include <random>
 #include <memory>
+#include <cmath> // M_PI
+#include <typeinfo>
+#include <stdexcept>
 
 #include "Point.hpp"
 #include "Heading.hpp"
+#include "Philox.hpp"
+#include "AliasTable.hpp"
 
 class MovementRule
 {
@@ -26,6 +31,35 @@ public:
          return current_heading;
       }
 
+   /**
+    * Generate a new heading using a counter-based generator. Every
+    * subclass must override both versions of Turn(); only the plain
+    * straight-line rule may rely on this one, which throws
+    * std::logic_error for anything else rather than quietly stop
+    * turning.
+    */
+   virtual Heading Turn(const Point&     current_position,
+                        const Heading&   current_heading,
+                        Philox&          gen)
+      {
+         if(typeid(*this) != typeid(MovementRule))
+         {
+            throw std::logic_error("MovementRule::Turn: rule has no counter-based Turn()");
+         }
+         return current_heading;
+      }
+
+   /**
+    * Throw std::logic_error if a copy of this rule cannot turn with a
+    * counter-based generator. Lets callers fail when they are set up
+    * instead of in the middle of a parallel step.
+    */
+   void CheckCounterTurn() const
+      {
+         Philox gen(0, 0, 0);
+         Clone()->Turn(Point(0, 0), Heading(0), gen);
+      }
+
    /**
     * Polymorphic constructor idiom. Create a copy of this rule.
     */
@@ -35,21 +69,67 @@ public:
       }
 };
 
+/**
+ * Turn to a uniformly random heading after a power-law distributed
+ * number of steps: P(k) is proportional to the mass of a continuous
+ * power law with exponent mu on [k, k+1), truncated to [1, max_step).
+ */
 class LevyWalk : public MovementRule
 {
 private:
    unsigned int next_turn;
    unsigned int current_time;
-   std::uniform_real_distribution<double> heading_distribution;
    double mu;
    int    max_step;
+
+   // step_length[k-1] is the chance of k steps between turns. Built
+   // once and shared by all copies of the rule.
+   std::shared_ptr<const AliasTable> step_length;
+
 public:
    LevyWalk(double mu, int max_step);
    ~LevyWalk();
 
+   /**
+    * Advance a walker whose turn state is (current_time, next_turn)
+    * by one step. Turn() is exactly this applied to the rule's own
+    * state; AgentStore applies it to state kept in arrays.
+    */
+   template<typename Generator>
+   static Heading TurnWith(unsigned int& current_time, unsigned int& next_turn,
+                           const AliasTable& step_length,
+                           const Heading& current_heading, Generator& gen)
+      {
+         current_time++;
+         if(current_time >= next_turn)
+         {
+            std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
+            next_turn = current_time + 1 + step_length(gen);
+            return Heading(heading_distribution(gen));
+         }
+         else
+         {
+            return current_heading;
+         }
+      }
+
+   std::shared_ptr<const AliasTable> StepLength() const;
+   double Mu() const;
+   int MaxStep() const;
+   unsigned int CurrentTime() const;
+   unsigned int NextTurn() const;
+
+   /**
+    * Set the turn state of this walker.
+    */
+   void SetTurnState(unsigned int current_time, unsigned int next_turn);
+
    Heading Turn(const Point&     current_position,
                 const Heading&   current_heading,
                 std::mt19937_64& gen) override;
+   Heading Turn(const Point&     current_position,
+                const Heading&   current_heading,
+                Philox&          gen) override;
    std::shared_ptr<MovementRule> Clone() const override;
 };
 
@@ -57,25 +137,50 @@ class CorrelatedRandomWalk : public MovementRule
 {
 private:
    double _sigma;
+
 public:
    CorrelatedRandomWalk(double sigma);
    ~CorrelatedRandomWalk();
 
+   /**
+    * The new heading drawn by Turn().
+    */
+   template<typename Generator>
+   static Heading TurnWith(const Heading& current_heading, double sigma, Generator& gen)
+      {
+         std::normal_distribution<double> heading_rv(current_heading.Radians(), sigma);
+         return Heading(heading_rv(gen));
+      }
+
+   double Sigma() const;
+
    Heading Turn(const Point&     current_position,
                 const Heading&   current_heading,
                 std::mt19937_64& gen) override;
+   Heading Turn(const Point&     current_position,
+                const Heading&   current_heading,
+                Philox&          gen) override;
    std::shared_ptr<MovementRule> Clone() const override;
 };
 
 class RandomWalk : public MovementRule
 {
-private:
-   std::uniform_real_distribution<double> heading_distribution;
 public:
    RandomWalk();
    ~RandomWalk();
 
+   /**
+    * The new heading drawn by Turn().
+    */
+   template<typename Generator>
+   static Heading TurnWith(Generator& gen)
+      {
+         std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
+         return Heading(heading_distribution(gen));
+      }
+
    Heading Turn(const Point&, const Heading&, std::mt19937_64& gen) override;
+   Heading Turn(const Point&, const Heading&, Philox& gen) override;
    std::shared_ptr<MovementRule> Clone() const override;
 };
 
@@ -2,23 +2,100 @@
 #define _MOTION_CA_NETWORK_HPP
 
 #include <vector>
-#include <set>
+#include <utility>
+#include <algorithm>
 #include <stdexcept>
 #include <memory>
 #include <iostream>
 
+#include "BitMatrix.hpp"
+
+/**
+ * A non-owning view of the (sorted) neighbors of a single vertex in a
+ * NetworkSnapshot. The view is invalidated by any change to the
+ * snapshot it was taken from.
+ */
+class NeighborView
+{
+private:
+   const int* _begin;
+   const int* _end;
+
+public:
+   NeighborView(const int* begin, const int* end) : _begin(begin), _end(end) {}
+
+   const int* begin() const { return _begin; }
+   const int* end()   const { return _end; }
+   int        size()  const { return _end - _begin; }
+   bool       empty() const { return _begin == _end; }
+   int operator[](int i) const { return _begin[i]; }
+
+   /**
+    * Find the neighbor v. Returns end() if v is not a neighbor.
+    */
+   const int* find(int v) const
+      {
+         const int* it = std::lower_bound(_begin, _end, v);
+         return (it != _end && *it == v) ? it : _end;
+      }
+};
+
+/**
+ * An undirected network stored in compressed sparse row form: the
+ * neighbors of every vertex are stored end to end in one array, with a
+ * second array holding the offset of each vertex's first neighbor.
+ *
+ * Edges added with AddEdge() are buffered and merged into the CSR
+ * arrays the next time the snapshot is queried, so a snapshot that is
+ * being modified must not be read from more than one thread at a
+ * time. Snapshots built in one go with SetEdges() are safe to share.
+ */
 class NetworkSnapshot
 {
 private:
 
-   std::vector<std::set<int>> _adjacency_list;
    int _num_vertices;
 
+   // _offsets[v] is the index in _neighbors of the first neighbor of
+   // v. _offsets has _num_vertices+1 entries.
+   mutable std::vector<int> _offsets;
+   mutable std::vector<int> _neighbors;
+
+   // edges added since the CSR arrays were last built.
+   mutable std::vector<std::pair<int,int>> _pending;
+   mutable std::vector<int>                _cursor; // scratch space for Build()
+
+   void CheckEdge(int i, int j) const;
+   void Build(const std::vector<std::pair<int,int>>& edges) const;
+   void Compact() const;
+
 public:
 
    NetworkSnapshot(int num_vertices);
+
+   /**
+    * Build a snapshot containing the given edges. Duplicate edges are
+    * ignored. Throws out_of_range if any edge is invalid.
+    */
+   NetworkSnapshot(int num_vertices, const std::vector<std::pair<int,int>>& edges);
    ~NetworkSnapshot();
 
+   /**
+    * Replace all the edges in the snapshot, reusing its storage.
+    * Duplicate edges are ignored. Throws out_of_range if any edge is
+    * invalid, in which case the snapshot is left unchanged.
+    */
+   void SetEdges(const std::vector<std::pair<int,int>>& edges);
+
+   /**
+    * Replace all the edges in the snapshot with the set bits of a
+    * symmetric adjacency matrix with a clear diagonal, reusing its
+    * storage. The rows come out sorted, so this is cheaper than
+    * SetEdges() on dense networks. Throws invalid_argument if the
+    * matrix is not the size of the snapshot.
+    */
+   void SetAdjacency(const BitMatrix& adjacency);
+
    /**
     * Add an edge between vertices i and j to the snapshot.
     *
@@ -71,12 +148,12 @@ public:
    int Degree(int v) const;
 
    /**
-    * Get the set of neighbors to vertex v.
+    * Get the neighbors of vertex v in increasing order.
     *
     * If v is not a node in the network then throws an out_of_range
     * exception.
     */
-   std::set<int> GetNeighbors(int v) const;
+   NeighborView GetNeighbors(int v) const;
 
    /**
     * get the number of vertices
@@ -99,12 +176,21 @@ public:
 
    Network();
    ~Network();
+   Network(const Network&) = default;
+   Network(Network&&) = default;
+   Network& operator=(const Network&) = default;
+   Network& operator=(Network&&) = default;
    
    /**
     * Append a snapshot to the network.
     */
    void AppendSnapshot(std::shared_ptr<NetworkSnapshot> snapshot);
 
+   /**
+    * Make room for n more snapshots.
+    */
+   void Reserve(int n);
+
    /**
     * Get the network snapshot at time t. If t is out of range then
     * throws an exception.
@@ -0,0 +1,167 @@
+#ifndef _NETWORK_BUILDER_HPP
+#define _NETWORK_BUILDER_HPP
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include "Point.hpp"
+#include "Network.hpp"
+#include "ThreadPool.hpp"
+#include "CellList.hpp"
+#include "VerletList.hpp"
+#include "BitMatrix.hpp"
+
+/**
+ * Builds the communication network of a set of moving points once per
+ * time step, reusing its search structures and buffers from one step
+ * to the next.
+ *
+ * The snapshot returned by Build() is rebuilt in place on the next
+ * call unless something else (e.g. the stats) still holds it, so once
+ * the buffers have grown a step makes no heap allocations.
+ *
+ * With the Verlet search the builder can also keep the network as a
+ * bit matrix of adjacency rows (see KeepAdjacency()). Between rebuilds
+ * of the candidates only the pairs that came within or went out of
+ * range are written to it, and the snapshot is read off the rows
+ * instead of sorting the pairs.
+ */
+class NetworkBuilder
+{
+public:
+   /**
+    * How to find the pairs of points that are within range of each
+    * other.
+    */
+   enum class Method {
+      AllPairs, // compare every pair of points
+      CellList, // bin points into a grid of range-wide cells
+      Verlet,   // filter a cached list of pairs within range + skin
+   };
+
+private:
+   double arena_size_;
+   double range_;
+   Method method_;
+
+   CellList                         cells_;
+   VerletList                       verlet_;
+   std::vector<std::pair<int,int>>  pairs_;
+   std::shared_ptr<NetworkSnapshot> network_;
+
+   bool                             keep_adjacency_;
+   bool                             adjacency_current_; // adjacency_ holds the last network built
+   BitMatrix                        adjacency_;
+   std::vector<std::pair<int,int>>  entered_; // pairs that came within range this step
+   std::vector<std::pair<int,int>>  left_;    // pairs that went out of range this step
+
+   /**
+    * Turn the pairs found, or the adjacency rows if they are current,
+    * into the current network.
+    */
+   std::shared_ptr<NetworkSnapshot> Snapshot(int num_points);
+
+   /**
+    * Bring the adjacency rows up to the pairs just found: apply
+    * entered_ and left_ if incremental is true and the rows held the
+    * previous network, otherwise set them from pairs_. The rows are
+    * left stale if the network is too sparse.
+    */
+   void UpdateAdjacency(bool incremental, int num_points);
+
+   /**
+    * Free the adjacency rows.
+    */
+   void DropAdjacency();
+
+public:
+   /**
+    * Adjacency rows are only kept while the mean degree is at least
+    * this many times the number of words in a row. Below that they
+    * take more memory than the neighbor lists, and walking the lists
+    * is cheaper than a popcount over a row.
+    */
+   static const int ADJACENCY_DEGREE_PER_WORD = 8;
+
+   /**
+    * Build networks of points within range of each other in the square
+    * [-arena_size/2, arena_size/2]. The Verlet search keeps pairs
+    * within range + verlet_skin.
+    */
+   NetworkBuilder(double arena_size, double range, double verlet_skin);
+   ~NetworkBuilder();
+   NetworkBuilder(const NetworkBuilder&) = default;
+   NetworkBuilder(NetworkBuilder&&) = default;
+   NetworkBuilder& operator=(const NetworkBuilder&) = default;
+   NetworkBuilder& operator=(NetworkBuilder&&) = default;
+
+   /**
+    * Set the search method. All methods produce identical networks.
+    */
+   void   SetMethod(Method method);
+   Method GetMethod() const;
+
+   /**
+    * Replace the Verlet candidates with an empty list with the given
+    * skin.
+    */
+   void SetVerletSkin(double skin);
+
+   /**
+    * Get the number of times the Verlet candidate list has been built.
+    */
+   int VerletRebuilds() const;
+
+   /**
+    * Drop the Verlet candidates, e.g. when the points are replaced by
+    * unrelated ones.
+    */
+   void Clear();
+
+   /**
+    * Build the network of the points for this step. The points must
+    * be the same points as last time, moved. The Verlet candidates are
+    * only ever updated here.
+    */
+   std::shared_ptr<NetworkSnapshot> Build(const std::vector<Point>& points);
+
+   /**
+    * Same as Build() with the search split over a thread pool.
+    */
+   std::shared_ptr<NetworkSnapshot> Build(const std::vector<Point>& points, ThreadPool& pool);
+
+   /**
+    * Also keep the network as adjacency rows between steps. Only the
+    * Verlet search keeps them, and only while the network is dense
+    * (see ADJACENCY_DEGREE_PER_WORD).
+    */
+   void KeepAdjacency(bool keep);
+
+   /**
+    * Get the adjacency rows of the network last built, or null if they
+    * are not being kept.
+    */
+   const BitMatrix* Adjacency() const;
+
+   /**
+    * Get the network last built, or the one last given to
+    * SetNetwork().
+    */
+   std::shared_ptr<NetworkSnapshot> Network() const;
+
+   /**
+    * Use network as the network last built, e.g. after the points were
+    * loaded from a file.
+    */
+   void SetNetwork(std::shared_ptr<NetworkSnapshot> network);
+
+   /**
+    * Search for the network of the points from scratch, with a
+    * throwaway cell list (or every pair). This leaves the builder
+    * alone, so it is safe to call from several threads at once.
+    */
+   std::shared_ptr<NetworkSnapshot> Search(const std::vector<Point>& points) const;
+};
+
+#endif // _NETWORK_BUILDER_HPP
@@ -0,0 +1,88 @@
+#ifndef _PACKED_LATTICE_HPP
+#define _PACKED_LATTICE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <random>
+
+/**
+ * 64 independent replicas of a one-dimensional ring lattice running
+ * the majority rule, packed one replica per bit.
+ *
+ * Word i holds cell i of every replica, so one bitwise operation
+ * updates the same cell in all 64 replicas at once. The number of ones
+ * in each cell's neighborhood is kept in bit-sliced counters (one word
+ * per bit of the count) that slide along the ring, so a step costs
+ * O(num_cells * log(radius)) word operations for all 64 replicas.
+ *
+ * The result of a step is the same as OneDLattice::Step with a
+ * MajorityRule for each replica.
+ */
+class PackedLattice
+{
+private:
+   int  num_cells_;
+   int  radius_;
+   int  window_; // cells in a neighborhood, including the cell itself
+   bool flip_;
+   int  steps_;
+
+   std::vector<std::uint64_t> states_;
+   std::vector<std::uint64_t> next_;
+   std::vector<std::uint64_t> count_; // bit-sliced neighborhood count
+   std::uint64_t              changed_;
+
+   void Add(std::uint64_t bits);
+   void Subtract(std::uint64_t bits);
+
+   /**
+    * Mask of the replicas whose count is at least c.
+    */
+   std::uint64_t AtLeast(int c) const;
+
+   /**
+    * Mask of the replicas whose count is exactly c.
+    */
+   std::uint64_t Equal(int c) const;
+
+public:
+   static const int REPLICAS = 64;
+
+   /**
+    * @param flip if true a cell whose neighborhood is evenly split
+    * changes state, otherwise it keeps its state. Same as
+    * MajorityRule(flip).
+    */
+   PackedLattice(int num_cells, int radius, bool flip = true);
+   ~PackedLattice();
+
+   int NumCells() const;
+
+   /**
+    * Set every cell of every replica to 1 with probability density.
+    */
+   void SetDensity(double density, std::mt19937_64& gen);
+
+   void                SetStates(int replica, const std::vector<int>& states);
+   std::vector<int>    GetStates(int replica) const;
+
+   /**
+    * Get the number of cells in state 1 in a replica.
+    */
+   int    Ones(int replica) const;
+   double GetDensity(int replica) const;
+
+   /**
+    * Step every replica.
+    */
+   void Step();
+
+   /**
+    * Get the mask of replicas whose state changed in the last
+    * step. Every replica counts as changing before the second step,
+    * as in OneDLattice::IsChanging().
+    */
+   std::uint64_t Changing() const;
+};
+
+#endif // _PACKED_LATTICE_HPP
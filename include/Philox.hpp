@@ -0,0 +1,147 @@
+#ifndef _PHILOX_HPP
+#define _PHILOX_HPP
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * The Philox4x32-10 counter-based random number generator (Salmon et
+ * al. "Parallel random numbers: as easy as 1, 2, 3", SC 2011).
+ *
+ * Each output is a pure function of a 64-bit key and a 128-bit
+ * counter. The key is the seed and the counter names a stream (e.g.
+ * an agent, a time step and a purpose) plus a position within the
+ * stream, so an independent stream can be created for any (seed,
+ * agent, step) without storing any generator state, and any position
+ * in a stream can be reached in constant time.
+ *
+ * Satisfies the UniformRandomBitGenerator requirements so it can be
+ * used with the standard library distributions.
+ */
+class Philox
+{
+public:
+   typedef std::uint64_t result_type;
+
+private:
+   std::uint32_t key_[2];
+   std::uint32_t counter_[4]; // counter_[0] is the block within the stream
+   std::uint32_t block_[4];   // output of the current block
+   int           next_;       // next unused 32-bit word of block_
+
+   static void MulHiLo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo)
+      {
+         std::uint64_t product = (std::uint64_t)a * (std::uint64_t)b;
+         hi = product >> 32;
+         lo = (std::uint32_t)product;
+      }
+
+   void Generate()
+      {
+         std::uint32_t k0 = key_[0];
+         std::uint32_t k1 = key_[1];
+         std::uint32_t x0 = counter_[0];
+         std::uint32_t x1 = counter_[1];
+         std::uint32_t x2 = counter_[2];
+         std::uint32_t x3 = counter_[3];
+         for(int round = 0; round < 10; round++)
+         {
+            std::uint32_t hi0, lo0, hi1, lo1;
+            MulHiLo(0xD2511F53, x0, hi0, lo0);
+            MulHiLo(0xCD9E8D57, x2, hi1, lo1);
+            x0 = hi1 ^ x1 ^ k0;
+            x1 = lo1;
+            x2 = hi0 ^ x3 ^ k1;
+            x3 = lo0;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+         }
+         block_[0] = x0;
+         block_[1] = x1;
+         block_[2] = x2;
+         block_[3] = x3;
+      }
+
+public:
+   /**
+    * Create the generator for one stream.
+    * @param seed the key shared by all streams of a simulation.
+    * @param stream identifies the stream, e.g. the agent.
+    * @param step identifies the time step.
+    * @param substream distinguishes independent uses within one step.
+    */
+   Philox(std::uint64_t seed, std::uint32_t stream, std::uint32_t step, std::uint32_t substream = 0)
+      {
+         key_[0]     = (std::uint32_t)seed;
+         key_[1]     = (std::uint32_t)(seed >> 32);
+         counter_[0] = 0;
+         counter_[1] = substream;
+         counter_[2] = step;
+         counter_[3] = stream;
+         Seek(0);
+      }
+
+   static constexpr result_type min() { return 0; }
+   static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+   result_type operator()()
+      {
+         if(next_ >= 4)
+         {
+            counter_[0]++;
+            Generate();
+            next_ = 0;
+         }
+         result_type r = ((result_type)block_[next_ + 1] << 32) | block_[next_];
+         next_ += 2;
+         return r;
+      }
+
+   /**
+    * Jump to the n-th output of the stream.
+    */
+   void Seek(std::uint64_t n)
+      {
+         counter_[0] = (std::uint32_t)(n / 2);
+         Generate();
+         next_ = 2 * (n % 2);
+      }
+
+   /**
+    * Get the index of the next output within the stream.
+    */
+   std::uint64_t Position() const
+      {
+         return 2 * (std::uint64_t)counter_[0] + next_ / 2;
+      }
+
+   /**
+    * Skip the next z outputs.
+    */
+   void discard(unsigned long long z)
+      {
+         Seek(Position() + z);
+      }
+
+   /**
+    * Get the raw 4x32 output block for the current counter. Used to
+    * check the implementation against the published test vectors.
+    */
+   static void Block(const std::uint32_t key[2], const std::uint32_t counter[4], std::uint32_t out[4])
+      {
+         Philox p(0, 0, 0);
+         p.key_[0] = key[0];
+         p.key_[1] = key[1];
+         for(int i = 0; i < 4; i++)
+         {
+            p.counter_[i] = counter[i];
+         }
+         p.Generate();
+         for(int i = 0; i < 4; i++)
+         {
+            out[i] = p.block_[i];
+         }
+      }
+};
+
+#endif // _PHILOX_HPP
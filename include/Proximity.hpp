@@ -0,0 +1,54 @@
+#ifndef _PROXIMITY_HPP
+#define _PROXIMITY_HPP
+
+#include <vector>
+#include <utility>
+
+#include "Point.hpp"
+
+/**
+ * Batched range tests on contiguous arrays of coordinates.
+ *
+ * Squared distances are compared against a squared range, several
+ * points at a time in SIMD lanes (AVX2 when the processor has it,
+ * otherwise SSE2, otherwise plain scalar code). The squared range is
+ * chosen so that the result is exactly the same as Point::Within(),
+ * including for points right on the boundary.
+ */
+namespace proximity
+{
+   /**
+    * Get the largest squared distance d2 with sqrt(d2) <= range, so
+    * that dx*dx + dy*dy <= SquaredRange(range) exactly when
+    * Point::Within(range) is true. Negative (or NaN) ranges match
+    * nothing.
+    */
+   double SquaredRange(double range);
+
+   /**
+    * Find which of the points (xs[k], ys[k]), k in [0, n), are within
+    * range of (x, y).
+    * @param squared_range SquaredRange(range).
+    * @param hits receives the index k of every such point, in
+    * increasing order. Must have room for n entries.
+    * @return the number of points found.
+    */
+   int Within(double x, double y, const double* xs, const double* ys, int n,
+              double squared_range, int* hits);
+
+   /**
+    * Find every pair (i, j), i < j, of points within range of each
+    * other by comparing all pairs. Any existing contents of pairs are
+    * discarded.
+    */
+   void AllPairs(const std::vector<Point>& points, double range,
+                 std::vector<std::pair<int,int>>& pairs);
+
+   /**
+    * Get the name of the kernel used by Within() on this machine:
+    * "avx2", "sse2" or "scalar".
+    */
+   const char* KernelName();
+}
+
+#endif // _PROXIMITY_HPP
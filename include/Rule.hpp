@@ -5,11 +5,31 @@
 
 class Rule {
 public:
+   virtual ~Rule() {}
+
    /**
     * Apply the rule to the current state and neighbor's state
     * yeilding the new state.
     */
    virtual std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const = 0;
+
+   /**
+    * Apply the rule knowing only the sum of the neighbors' states
+    * (the number of neighbors in state 1) and the number of
+    * neighbors. Gives the same result as Apply() for any rule where
+    * IsTotalistic() is true.
+    *
+    * The default implementation builds a neighbor vector and calls
+    * Apply().
+    */
+   virtual std::pair<int, double> ApplyCount(int self, int ones, int total) const;
+
+   /**
+    * Return true if the result of the rule depends only on the
+    * agent's own state and the sum of its neighbors' states, so that
+    * ApplyCount() can be used in place of Apply().
+    */
+   virtual bool IsTotalistic() const;
 };
 
 
@@ -18,6 +38,8 @@ public:
    Identity();
    ~Identity();
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
+   std::pair<int, double> ApplyCount(int self, int ones, int total) const override;
+   bool IsTotalistic() const override;
 };
 
 class Constant : public Rule {
@@ -25,6 +47,8 @@ public:
    Constant(int c);
    ~Constant();
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
+   std::pair<int, double> ApplyCount(int self, int ones, int total) const override;
+   bool IsTotalistic() const override;
 private:
    int state;
 };
@@ -35,6 +59,8 @@ public:
    MajorityRule(bool f);
    ~MajorityRule();
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
+   std::pair<int, double> ApplyCount(int self, int ones, int total) const override;
+   bool IsTotalistic() const override;
 private:
    bool flip = true;
 };
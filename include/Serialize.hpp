@@ -0,0 +1,106 @@
+#ifndef _SERIALIZE_HPP
+#define _SERIALIZE_HPP
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <utility>
+#include <stdexcept>
+#include <cstdint>
+#include <type_traits>
+
+class NetworkSnapshot;
+
+/**
+ * Helpers for the binary Save()/Load() methods of the model classes.
+ *
+ * Values are written in the byte order of the machine, as in
+ * trajectory files, so a saved model can only be loaded on the same
+ * kind of machine. Every read throws std::runtime_error if the stream
+ * ends early.
+ */
+namespace serialize
+{
+   /**
+    * Write a tag identifying what follows, e.g. "LCAMODEL".
+    */
+   void WriteTag(std::ostream& out, const char tag[8]);
+
+   /**
+    * Read a tag and throw std::runtime_error unless it matches.
+    */
+   void ReadTag(std::istream& in, const char tag[8]);
+
+   void        WriteString(std::ostream& out, const std::string& s);
+   std::string ReadString(std::istream& in);
+
+   /**
+    * Write a list of edges, or the edges (u, v), u < v, of a snapshot.
+    */
+   void WriteEdges(std::ostream& out, const std::vector<std::pair<int,int>>& edges);
+   void WriteEdges(std::ostream& out, const NetworkSnapshot& snapshot);
+   std::vector<std::pair<int,int>> ReadEdges(std::istream& in);
+
+   /**
+    * Save a random engine (or anything with a text operator<<) as a
+    * string.
+    */
+   template<typename Engine>
+   void WriteEngine(std::ostream& out, const Engine& engine)
+   {
+      std::ostringstream state;
+      state << engine;
+      WriteString(out, state.str());
+   }
+
+   template<typename Engine>
+   void ReadEngine(std::istream& in, Engine& engine)
+   {
+      std::istringstream state(ReadString(in));
+      if(!(state >> engine))
+      {
+         throw std::runtime_error("serialize::ReadEngine: bad engine state");
+      }
+   }
+
+   template<typename T>
+   void Write(std::ostream& out, const T& value)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "serialize::Write");
+      out.write((const char*)&value, sizeof(T));
+   }
+
+   template<typename T>
+   T Read(std::istream& in)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "serialize::Read");
+      T value;
+      if(!in.read((char*)&value, sizeof(T)))
+      {
+         throw std::runtime_error("serialize::Read: unexpected end of stream");
+      }
+      return value;
+   }
+
+   template<typename T>
+   void WriteVector(std::ostream& out, const std::vector<T>& values)
+   {
+      Write<std::uint64_t>(out, values.size());
+      out.write((const char*)values.data(), values.size() * sizeof(T));
+   }
+
+   template<typename T>
+   std::vector<T> ReadVector(std::istream& in)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "serialize::ReadVector");
+      std::vector<T> values(Read<std::uint64_t>(in));
+      if(!in.read((char*)values.data(), values.size() * sizeof(T)))
+      {
+         throw std::runtime_error("serialize::ReadVector: unexpected end of stream");
+      }
+      return values;
+   }
+}
+
+#endif // _SERIALIZE_HPP
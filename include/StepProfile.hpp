@@ -0,0 +1,88 @@
+#ifndef _STEP_PROFILE_HPP
+#define _STEP_PROFILE_HPP
+
+#include <iostream>
+#include <chrono>
+
+/**
+ * Cumulative time spent in each phase of Model::Step and counts of
+ * the work done.
+ *
+ * The counters are only updated when the library is built with
+ * LCA_PROFILE defined (cmake -DLCA_PROFILE=On). Otherwise the timers
+ * compile to nothing and every field stays zero.
+ */
+struct StepProfile
+{
+   double move_seconds    = 0; // moving and turning agents
+   double mode_seconds    = 0; // switching agents between dark and interactive
+   double network_seconds = 0; // building the interaction network
+   double update_seconds  = 0; // applying the rule
+   double stats_seconds   = 0; // recording statistics
+
+   long long steps             = 0;
+   long long edges             = 0; // edges in all the networks built
+   long long rule_applications = 0; // rule evaluations (one per interactive agent)
+   long long allocations       = 0; // heap allocations made by the stepping thread
+
+   /**
+    * Returns true if the library was built with profiling.
+    */
+   static bool Enabled();
+
+   /**
+    * Get the number of heap allocations made so far by the calling
+    * thread. Always 0 without profiling.
+    */
+   static long long ThreadAllocations();
+
+   double TotalSeconds() const;
+
+   StepProfile& operator+= (const StepProfile& p);
+   friend std::ostream& operator<< (std::ostream& out, const StepProfile& p);
+};
+
+#ifdef LCA_PROFILE
+
+/**
+ * Adds the time from construction to destruction to a counter.
+ */
+class ScopedTimer
+{
+private:
+   double&                               seconds_;
+   std::chrono::steady_clock::time_point start_;
+
+public:
+   explicit ScopedTimer(double& seconds) :
+      seconds_(seconds),
+      start_(std::chrono::steady_clock::now())
+      {}
+
+   ~ScopedTimer()
+      {
+         seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+      }
+};
+
+#define LCA_PROFILE_CONCAT_(a, b) a##b
+#define LCA_PROFILE_CONCAT(a, b)  LCA_PROFILE_CONCAT_(a, b)
+
+/**
+ * Time the rest of the enclosing scope into the given counter.
+ */
+#define LCA_PROFILE_SCOPE(seconds) ScopedTimer LCA_PROFILE_CONCAT(lca_profile_timer_, __LINE__)(seconds)
+
+/**
+ * Code that is only compiled when profiling.
+ */
+#define LCA_PROFILE_ONLY(...) __VA_ARGS__
+
+#else
+
+#define LCA_PROFILE_SCOPE(seconds)  do {} while(0)
+#define LCA_PROFILE_ONLY(...)
+
+#endif // LCA_PROFILE
+
+#endif // _STEP_PROFILE_HPP
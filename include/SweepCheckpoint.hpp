@@ -0,0 +1,105 @@
+#ifndef _SWEEP_CHECKPOINT_HPP
+#define _SWEEP_CHECKPOINT_HPP
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <cstdint>
+
+/**
+ * A record, kept in a file, of the (parameter, replica) cells of a
+ * sweep that have finished, so that a sweep that is killed can be
+ * restarted without recomputing them.
+ *
+ * The file is plain text. The first line identifies the sweep:
+ *
+ *    lca-checkpoint <seed> <signature>
+ *
+ * where the signature is normally the command line of the driver, and
+ * every later line holds one finished cell:
+ *
+ *    <parameter> <replica> <result>
+ *
+ * Each line is flushed as soon as its cell finishes, and a partly
+ * written last line (e.g. if the driver was killed while writing it)
+ * is ignored when the file is read back.
+ */
+class SweepCheckpoint
+{
+private:
+   std::string   path_;
+   std::uint64_t seed_;
+
+   mutable std::mutex                         mutex_;
+   std::map<std::pair<int,int>, std::string>  results_;
+   std::ofstream                              out_;
+
+   std::string Find(int parameter, int replica, bool& found) const;
+   void        Append(int parameter, int replica, const std::string& result);
+
+public:
+   /**
+    * Open the checkpoint at path, creating it if it does not exist.
+    * Throws std::runtime_error if the file can't be written or was
+    * written for a sweep with a different signature.
+    * @param signature identifies the sweep, e.g. from Signature().
+    * @param seed the seed of the sweep. If the file already exists the
+    * seed saved in it is used instead (see Seed()).
+    */
+   SweepCheckpoint(const std::string& path, const std::string& signature, std::uint64_t seed);
+   ~SweepCheckpoint();
+
+   SweepCheckpoint(const SweepCheckpoint&) = delete;
+   SweepCheckpoint& operator=(const SweepCheckpoint&) = delete;
+
+   /**
+    * Join the arguments of a command line (without the program name)
+    * into a signature.
+    */
+   static std::string Signature(int argc, char** argv);
+
+   /**
+    * Get the seed of the sweep: the one first passed to the
+    * constructor when the file was created. Lets a restarted sweep
+    * that picks a random seed draw the cells it has left from the same
+    * seed as the cells already done.
+    */
+   std::uint64_t Seed() const;
+
+   /**
+    * Get the number of finished cells.
+    */
+   int Size() const;
+
+   /**
+    * If cell (parameter, replica) has finished, read its result into
+    * result and return true. Thread safe.
+    */
+   template<typename T>
+   bool Get(int parameter, int replica, T& result) const
+      {
+         bool found;
+         std::istringstream in(Find(parameter, replica, found));
+         return found && (in >> result);
+      }
+
+   /**
+    * Record the result of cell (parameter, replica) and flush it to
+    * the file. Results are written with operator<< and read back with
+    * operator>>, with enough precision to recover doubles exactly.
+    * Thread safe.
+    */
+   template<typename T>
+   void Put(int parameter, int replica, const T& result)
+      {
+         std::ostringstream out;
+         out.precision(17);
+         out << result;
+         Append(parameter, replica, out.str());
+      }
+};
+
+#endif // _SWEEP_CHECKPOINT_HPP
@@ -0,0 +1,107 @@
+#ifndef _THREAD_POOL_HPP
+#define _THREAD_POOL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+/**
+ * A fixed set of worker threads used to split loops within a single
+ * time step, or to run many independent simulations.
+ *
+ * Each thread owns a queue of task indices. Tasks are dealt out in
+ * contiguous blocks, one per thread, and a thread that runs out of
+ * work steals half of the remaining tasks of another thread, so tasks
+ * of very different lengths are still balanced. ParallelFor() makes
+ * exactly one task per thread, and chunk boundaries depend only on the
+ * loop bounds and the number of threads, never on timing, so loops
+ * whose iterations are independent give the same results as running
+ * serially. The calling thread works on tasks too, so a pool of one
+ * thread has no workers and runs everything inline.
+ */
+class ThreadPool
+{
+private:
+   /**
+    * The tasks [front, back) waiting to run on one thread. The owner
+    * takes tasks from the front and thieves from the back.
+    */
+   struct TaskQueue
+   {
+      std::mutex mutex;
+      int        front = 0;
+      int        back  = 0;
+   };
+
+   std::vector<std::thread>                threads_;
+   std::vector<std::unique_ptr<TaskQueue>> queues_; // queues_[0] belongs to the caller
+
+   std::mutex              run_mutex_; // held for the duration of Run()
+   std::mutex              mutex_;     // guards the fields below
+   std::condition_variable work_ready_;
+   std::condition_variable work_done_;
+
+   const std::function<void(int)>* task_;
+   std::atomic<int>                unfinished_;
+   unsigned                        generation_;
+   bool                            stop_;
+
+   int  Pop(int self);
+   int  Steal(int self);
+   void RunTasks(int self);
+   void WorkerMain(int self);
+
+public:
+   /**
+    * Create a pool in which num_threads threads (including the caller)
+    * share the work. num_threads < 1 uses one thread per core.
+    */
+   explicit ThreadPool(int num_threads);
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+
+   /**
+    * Get the number of threads that share the work.
+    */
+   int NumThreads() const;
+
+   /**
+    * Call task(t) for every t in [0, num_tasks) and wait for all of
+    * them to finish. Tasks must not throw or call Run() on this pool.
+    */
+   void Run(int num_tasks, const std::function<void(int)>& task);
+
+   /**
+    * Split [begin, end) into at most NumThreads() contiguous chunks and
+    * call f(chunk_begin, chunk_end) for each of them in parallel.
+    */
+   template<typename F>
+   void ParallelFor(int begin, int end, F f)
+      {
+         int n = end - begin;
+         int chunks = std::min(NumThreads(), n);
+         if(chunks <= 0)
+         {
+            return;
+         }
+         else if(chunks == 1)
+         {
+            f(begin, end); // no std::function (and no allocation) needed
+            return;
+         }
+         Run(chunks, [begin, n, chunks, &f](int c)
+             {
+                f(begin + (int)((long long)n * c / chunks),
+                  begin + (int)((long long)n * (c + 1) / chunks));
+             });
+      }
+};
+
+#endif // _THREAD_POOL_HPP
@@ -14,12 +14,42 @@ private:
 
    std::vector<Transition> transition_table_;
 
+   // Result of the rule for every (self, ones, total) with self in
+   // {0,1} and total <= max_degree_. Empty if the rule has not been
+   // compiled.
+   std::vector<std::pair<int, double>> lookup_table_;
+   int max_degree_ = -1;
+
+   std::pair<int, double> Evaluate(int self, int ones, int total) const;
+   int LookupIndex(int self, int ones, int total) const;
+
 public:
+   static const int DEFAULT_MAX_DEGREE = 128;
+
    TotalisticRule() {}
    ~TotalisticRule() {}
 
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
-
+   std::pair<int, double> ApplyCount(int self, int ones, int total) const override;
+   bool IsTotalistic() const override;
+
+   /**
+    * Precompute the result of the rule for binary states and every
+    * neighborhood of up to max_degree neighbors so that applying the
+    * rule is a single table lookup. Larger neighborhoods (and
+    * non-binary states) fall back to searching the transition table.
+    */
+   void Compile(int max_degree);
+
+   /**
+    * The largest neighborhood covered by the lookup table, or -1 if
+    * the rule has not been compiled.
+    */
+   int MaxDegree() const;
+
+   /**
+    * Read a rule file. The rule is compiled with DEFAULT_MAX_DEGREE.
+    */
    friend std::istream& operator>>(std::istream& str, TotalisticRule& rule);
 };
 
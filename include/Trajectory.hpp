@@ -0,0 +1,184 @@
+#ifndef _TRAJECTORY_HPP
+#define _TRAJECTORY_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "Point.hpp"
+#include "Heading.hpp"
+#include "AgentStore.hpp"
+#include "Network.hpp"
+#include "Model.hpp"
+
+/**
+ * Binary trajectory files.
+ *
+ * A trajectory file is a 32 byte header followed by one frame per
+ * recorded time step. All values are stored in the byte order of the
+ * machine that wrote the file.
+ *
+ *   header: char     magic[8]     "LCATRAJ" followed by '\0'
+ *           uint32   version      currently 1
+ *           uint32   flags        bit 0 set if frames hold edges
+ *           uint32   num_agents
+ *           uint32   reserved
+ *           double   arena_size
+ *
+ *   frame:  uint64   num_edges    0 if the file holds no edges
+ *           double   x[num_agents]
+ *           double   y[num_agents]
+ *           double   heading[num_agents]   (radians)
+ *           uint8    state[num_agents]
+ *           uint8    dark[num_agents]
+ *                    zero padding to a multiple of 8 bytes
+ *           uint32   edges[2*num_edges]    (u, v) pairs with u < v
+ *
+ * Every frame starts on an 8 byte boundary. The size of a frame only
+ * depends on num_agents and num_edges, so a reader can find every
+ * frame by reading one word per frame.
+ */
+namespace trajectory
+{
+   const char          MAGIC[8]    = {'L', 'C', 'A', 'T', 'R', 'A', 'J', '\0'};
+   const std::uint32_t VERSION     = 1;
+   const std::uint32_t FLAG_EDGES  = 1;
+   const std::size_t   HEADER_SIZE = 32;
+
+   /**
+    * Get the size in bytes of a frame.
+    */
+   std::size_t FrameSize(int num_agents, std::uint64_t num_edges);
+}
+
+/**
+ * Appends the state of a model to a trajectory file once per call.
+ */
+class TrajectoryWriter
+{
+private:
+   std::ofstream              out_;
+   int                        num_agents_;
+   bool                       record_edges_;
+   int                        num_frames_;
+   std::vector<unsigned char> buffer_; // the frame being written
+
+public:
+   /**
+    * Create (or truncate) the file at path and write the header.
+    * Throws std::runtime_error if the file can't be opened.
+    * @param record_edges if true every frame holds the edges of the
+    * interaction network.
+    */
+   TrajectoryWriter(const std::string& path, int num_agents, double arena_size,
+                    bool record_edges = false);
+   ~TrajectoryWriter();
+
+   /**
+    * Append the current positions, headings, states and modes of the
+    * model's agents, and the current network if edges are recorded.
+    */
+   void Write(const Model& model);
+
+   /**
+    * Append a frame. network may be null if edges are not recorded.
+    * Throws std::invalid_argument if the number of agents or states
+    * is wrong.
+    */
+   void Write(const AgentStore& agents, const std::vector<int>& states,
+              const NetworkSnapshot* network);
+
+   /**
+    * Flush the frames written so far to the file.
+    */
+   void Flush();
+
+   int NumFrames() const;
+};
+
+/**
+ * A view of one frame of a trajectory file. The frame's arrays point
+ * directly into the reader's memory mapping, so a frame is only valid
+ * while the reader that made it exists.
+ */
+class TrajectoryFrame
+{
+private:
+   int                  num_agents_;
+   std::uint64_t        num_edges_;
+   const double*        x_;
+   const double*        y_;
+   const double*        heading_;
+   const std::uint8_t*  states_;
+   const std::uint8_t*  dark_;
+   const std::uint32_t* edges_;
+
+public:
+   TrajectoryFrame(int num_agents, const unsigned char* data);
+
+   int     NumAgents() const;
+   Point   Position(int i) const;
+   Heading GetHeading(int i) const;
+   int     State(int i) const;
+   bool    IsDark(int i) const;
+
+   /**
+    * Get the fraction of agents in state 1.
+    */
+   double Density() const;
+
+   /**
+    * Get the number of recorded edges.
+    */
+   std::uint64_t NumEdges() const;
+   std::pair<int,int> Edge(std::uint64_t e) const;
+
+   /**
+    * Build the interaction network from the recorded edges.
+    */
+   std::shared_ptr<NetworkSnapshot> GetNetwork() const;
+};
+
+/**
+ * Reads a trajectory file through a read-only memory mapping, so
+ * frames are only paged in as they are used and a file much larger
+ * than memory can be scanned.
+ */
+class TrajectoryReader
+{
+private:
+   int                        fd_;
+   const unsigned char*       data_;
+   std::size_t                size_;
+   int                        num_agents_;
+   double                     arena_size_;
+   bool                       has_edges_;
+   std::vector<std::size_t>   frame_offsets_;
+
+public:
+   /**
+    * Open and map the file at path. A partly written last frame (e.g.
+    * if the writer was killed) is ignored. Throws std::runtime_error
+    * if the file can't be read or is not a trajectory file.
+    */
+   explicit TrajectoryReader(const std::string& path);
+   ~TrajectoryReader();
+
+   TrajectoryReader(const TrajectoryReader&) = delete;
+   TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+   int    NumAgents() const;
+   double ArenaSize() const;
+   bool   HasEdges() const;
+   int    NumFrames() const;
+
+   /**
+    * Get frame t. Throws std::out_of_range if there is no such frame.
+    */
+   TrajectoryFrame GetFrame(int t) const;
+};
+
+#endif // _TRAJECTORY_HPP
@@ -0,0 +1,96 @@
+#ifndef _TRIANGULAR_BIT_MATRIX_HPP
+#define _TRIANGULAR_BIT_MATRIX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * The bits (i, j), i < j, above the diagonal of a square matrix, packed
+ * 64 to a word, one row after another. A size n matrix takes
+ * n(n-1)/2 bits, half of a full BitMatrix.
+ */
+class TriangularBitMatrix
+{
+private:
+   int                        size_;
+   std::vector<std::uint64_t> words_;
+
+   /**
+    * Get the position of bit (i, j), i < j.
+    */
+   std::size_t Index(int i, int j) const
+      {
+         return (std::size_t)i * (2 * (std::size_t)size_ - i - 1) / 2 + (j - i - 1);
+      }
+
+public:
+   TriangularBitMatrix(int size = 0) :
+      size_(size),
+      words_(((std::size_t)size * (size > 0 ? size - 1 : 0) / 2 + 63) / 64, 0)
+      {}
+
+   int Size() const { return size_; }
+
+   /**
+    * Test bit (i, j), i < j.
+    */
+   bool Test(int i, int j) const
+      {
+         std::size_t b = Index(i, j);
+         return (words_[b / 64] >> (b % 64)) & 1;
+      }
+
+   /**
+    * Set bit (i, j), i < j. Returns true if it was not already set.
+    */
+   bool Set(int i, int j)
+      {
+         std::size_t    b    = Index(i, j);
+         std::uint64_t& word = words_[b / 64];
+         std::uint64_t  bit  = (std::uint64_t)1 << (b % 64);
+         bool was_set = (word & bit) != 0;
+         word |= bit;
+         return !was_set;
+      }
+
+   /**
+    * Clear every bit.
+    */
+   void Clear()
+      {
+         std::fill(words_.begin(), words_.end(), 0);
+      }
+
+   /**
+    * Call f(j) for every bit (i, j) set in row i, in increasing j.
+    */
+   template<typename F>
+   void ForEachInRow(int i, F f) const
+      {
+         if(i >= size_ - 1)
+         {
+            return;
+         }
+         const std::size_t begin = Index(i, i + 1);
+         const std::size_t end   = begin + (size_ - i - 1);
+         for(std::size_t w = begin / 64; w <= (end - 1) / 64; w++)
+         {
+            std::uint64_t bits = words_[w];
+            if(w == begin / 64)
+            {
+               bits &= ~(std::uint64_t)0 << (begin % 64);
+            }
+            if(w == (end - 1) / 64 && end % 64 != 0)
+            {
+               bits &= ~(~(std::uint64_t)0 << (end % 64));
+            }
+            for(; bits != 0; bits &= bits - 1)
+            {
+               f(i + 1 + (int)(64 * w + __builtin_ctzll(bits) - begin));
+            }
+         }
+      }
+};
+
+#endif // _TRIANGULAR_BIT_MATRIX_HPP
@@ -0,0 +1,116 @@
+#ifndef _VERLET_LIST_HPP
+#define _VERLET_LIST_HPP
+
+#include <vector>
+#include <utility>
+
+#include "Point.hpp"
+#include "ThreadPool.hpp"
+#include "CellList.hpp"
+
+/**
+ * A Verlet neighbor list: a cached list of the pairs of points within
+ * range + skin of each other, from which the pairs within range are
+ * found by filtering.
+ *
+ * As long as no point has moved more than skin/2 since the list was
+ * built, every pair now within range was within range + skin then, so
+ * the filtered list is exactly the list a full search would find. The
+ * list is rebuilt with a cell list whenever some point has moved
+ * further. With slow agents this replaces most grid searches by a
+ * linear pass over the candidates.
+ */
+class VerletList
+{
+private:
+   double arena_size_;
+   double range_;
+   double skin_;
+   double squared_range_; // see proximity::SquaredRange()
+   double squared_limit_; // of the displacement that forces a rebuild
+   int    rebuilds_;
+
+   std::vector<Point>               reference_;  // the points when the list was built
+   std::vector<std::pair<int,int>>  candidates_; // pairs within range_ + skin_ of each other
+   std::vector<unsigned char>       within_;     // whether each candidate was last within range_
+   CellList                         cells_;      // grid of range_ + skin_ cells
+
+   /**
+    * Returns true if the candidates may be missing a pair of points.
+    */
+   bool NeedsRebuild(const std::vector<Point>& points) const;
+
+   /**
+    * Rebuild the candidates if some point has moved too far. Returns
+    * true if they were rebuilt.
+    */
+   bool Update(const std::vector<Point>& points);
+   bool Update(const std::vector<Point>& points, ThreadPool& pool);
+
+   /**
+    * Find the pairs within range among the candidates, and if entered
+    * and left are not null, the candidates that came within range and
+    * went out of range since the last call.
+    */
+   void Filter(const std::vector<Point>& points,
+               std::vector<std::pair<int,int>>& pairs,
+               std::vector<std::pair<int,int>>* entered,
+               std::vector<std::pair<int,int>>* left);
+
+public:
+   VerletList(double arena_size, double range, double skin);
+   ~VerletList();
+   VerletList(const VerletList&) = default;
+   VerletList(VerletList&&) = default;
+   VerletList& operator=(const VerletList&) = default;
+   VerletList& operator=(VerletList&&) = default;
+
+   /**
+    * Drop the candidates, so the next Pairs() rebuilds them.
+    */
+   void Clear();
+
+   /**
+    * Find every pair (i, j) with i < j such that points[i] and
+    * points[j] are within range of each other, rebuilding the
+    * candidates first if needed. Gives the same pairs as
+    * CellList::Pairs(), though not always in the same order. Any
+    * existing contents of pairs are discarded.
+    */
+   void Pairs(const std::vector<Point>& points,
+              std::vector<std::pair<int,int>>& pairs);
+
+   /**
+    * Same as Pairs() but with any rebuild split over a thread pool.
+    */
+   void Pairs(const std::vector<Point>& points,
+              std::vector<std::pair<int,int>>& pairs,
+              ThreadPool& pool);
+
+   /**
+    * Same as Pairs(), and also find the pairs that
+    * came within range (entered) and went out of range (left) since the
+    * last call, so that a copy of the network can be kept up to date.
+    * Returns false if the candidates had to be rebuilt, in which case
+    * entered and left are left empty and the copy must be rebuilt from
+    * pairs.
+    */
+   bool Changes(const std::vector<Point>& points,
+                std::vector<std::pair<int,int>>& pairs,
+                std::vector<std::pair<int,int>>& entered,
+                std::vector<std::pair<int,int>>& left);
+   bool Changes(const std::vector<Point>& points,
+                std::vector<std::pair<int,int>>& pairs,
+                std::vector<std::pair<int,int>>& entered,
+                std::vector<std::pair<int,int>>& left,
+                ThreadPool& pool);
+
+   /**
+    * Get the number of times the candidate list has been built.
+    */
+   int Rebuilds() const;
+
+   double Skin() const;
+};
+
+#endif // _VERLET_LIST_HPP
@@ -0,0 +1,495 @@
+#include "AgentStore.hpp"
+
+#include <cmath> // M_PI
+#include <algorithm>
+#include <typeinfo>
+#include <stdexcept>
+
+#include "Serialize.hpp"
+
+AgentStore::AgentStore(double speed, double arena_size) :
+   speed_(speed),
+   arena_size_(arena_size),
+   steps_(0),
+   counter_rng_(false),
+   seed_(0),
+   movement_kind_(MovementKind::Straight),
+   movement_rule_(std::make_shared<MovementRule>()),
+   sigma_(0),
+   levy_mu_(0),
+   levy_max_step_(0)
+{}
+
+AgentStore::~AgentStore() {}
+
+void AgentStore::Add(Point p, Heading h, int seed)
+{
+   x_.push_back(p.GetX());
+   y_.push_back(p.GetY());
+   heading_.push_back(h);
+   previous_heading_.push_back(h + Heading(M_PI));
+   dark_.push_back(false);
+   AddMovementState();
+   if(!counter_rng_)
+   {
+      generators_.push_back(std::mt19937_64(seed));
+   }
+}
+
+void AgentStore::Clear(std::uint64_t seed)
+{
+   steps_ = 0;
+   if(counter_rng_)
+   {
+      seed_ = seed;
+   }
+   x_.clear();
+   y_.clear();
+   heading_.clear();
+   previous_heading_.clear();
+   dark_.clear();
+   generators_.clear();
+   levy_time_.clear();
+   levy_next_turn_.clear();
+   movement_rules_.clear();
+}
+
+int AgentStore::Size() const
+{
+   return x_.size();
+}
+
+Point AgentStore::Position(int i) const
+{
+   return Point(x_[i], y_[i]);
+}
+
+Heading AgentStore::GetHeading(int i) const
+{
+   return heading_[i];
+}
+
+Heading AgentStore::GetPreviousHeading(int i) const
+{
+   return previous_heading_[i];
+}
+
+void AgentStore::SetHeading(int i, Heading h)
+{
+   heading_[i] = h;
+}
+
+bool AgentStore::IsDark(int i) const
+{
+   return dark_[i];
+}
+
+bool AgentStore::IsInteractive(int i) const
+{
+   return !dark_[i];
+}
+
+void AgentStore::GoDark(int i)
+{
+   dark_[i] = true;
+}
+
+void AgentStore::GoInteractive(int i)
+{
+   dark_[i] = false;
+}
+
+const std::vector<double>& AgentStore::X() const
+{
+   return x_;
+}
+
+const std::vector<double>& AgentStore::Y() const
+{
+   return y_;
+}
+
+std::vector<Point> AgentStore::Positions() const
+{
+   std::vector<Point> positions;
+   positions.reserve(Size());
+   for(int i = 0; i < Size(); i++)
+   {
+      positions.push_back(Position(i));
+   }
+   return positions;
+}
+
+void AgentStore::Positions(std::vector<Point>& positions) const
+{
+   positions.clear();
+   for(int i = 0; i < Size(); i++)
+   {
+      positions.push_back(Position(i));
+   }
+}
+
+void AgentStore::UseCounterRng(std::uint64_t seed)
+{
+   if(movement_kind_ == MovementKind::Custom)
+   {
+      movement_rule_->CheckCounterTurn();
+   }
+   counter_rng_ = true;
+   seed_        = seed;
+   std::vector<std::mt19937_64>().swap(generators_);
+}
+
+bool AgentStore::UsesCounterRng() const
+{
+   return counter_rng_;
+}
+
+void AgentStore::AddMovementState()
+{
+   if(movement_kind_ == MovementKind::Levy)
+   {
+      const LevyWalk& levy = static_cast<const LevyWalk&>(*movement_rule_);
+      levy_time_.push_back(levy.CurrentTime());
+      levy_next_turn_.push_back(levy.NextTurn());
+   }
+   else if(movement_kind_ == MovementKind::Custom)
+   {
+      movement_rules_.push_back(movement_rule_->Clone());
+   }
+}
+
+void AgentStore::SetMovementRule(std::shared_ptr<MovementRule> rule)
+{
+   // Only exact types are specialized; a subclass may override Turn().
+   const std::type_info& type = typeid(*rule);
+   if(type == typeid(MovementRule))
+   {
+      movement_kind_ = MovementKind::Straight;
+   }
+   else if(type == typeid(RandomWalk))
+   {
+      movement_kind_ = MovementKind::Random;
+   }
+   else if(type == typeid(CorrelatedRandomWalk))
+   {
+      movement_kind_ = MovementKind::Correlated;
+      sigma_ = static_cast<const CorrelatedRandomWalk&>(*rule).Sigma();
+   }
+   else if(type == typeid(LevyWalk))
+   {
+      const LevyWalk& levy = static_cast<const LevyWalk&>(*rule);
+      movement_kind_ = MovementKind::Levy;
+      step_length_   = levy.StepLength();
+      levy_mu_       = levy.Mu();
+      levy_max_step_ = levy.MaxStep();
+   }
+   else
+   {
+      if(counter_rng_)
+      {
+         rule->CheckCounterTurn();
+      }
+      movement_kind_ = MovementKind::Custom;
+   }
+   movement_rule_ = rule->Clone();
+
+   levy_time_.clear();
+   levy_next_turn_.clear();
+   movement_rules_.clear();
+   for(int i = 0; i < Size(); i++)
+   {
+      AddMovementState();
+   }
+}
+
+AgentStore::MovementKind AgentStore::GetMovementKind() const
+{
+   return movement_kind_;
+}
+
+void AgentStore::Reflect(int i)
+{
+   // Same arithmetic as Agent::Reflect() so that the two stay
+   // bit-for-bit identical.
+   while(x_[i] < (-arena_size_ / 2) || x_[i] > (arena_size_ / 2)
+         || y_[i] < (-arena_size_ / 2) || y_[i] > (arena_size_ / 2))
+   {
+      double new_x = x_[i];
+      double new_y = y_[i];
+      if(x_[i] > arena_size_/2) {
+         new_x = arena_size_/2 - (x_[i] - arena_size_ / 2);
+         heading_[i] = Heading(M_PI) - heading_[i];
+      }
+      else if(x_[i] < -arena_size_/2) {
+         new_x = -arena_size_/2 - (x_[i] + arena_size_ / 2);
+         heading_[i] = Heading(M_PI) - heading_[i];
+      }
+
+      if(y_[i] > arena_size_/2) {
+         new_y = arena_size_/2 - (y_[i] - arena_size_/2);
+         heading_[i] = Heading(2*M_PI) - heading_[i];
+      }
+      else if(y_[i] < -arena_size_/2) {
+         new_y = -arena_size_/2 - (y_[i] + arena_size_/2);
+         heading_[i] = Heading(2*M_PI) - heading_[i];
+      }
+
+      x_[i] = new_x;
+      y_[i] = new_y;
+   }
+}
+
+void AgentStore::Step()
+{
+   ThreadPool serial(1);
+   Step(serial);
+}
+
+void AgentStore::Step(ThreadPool& pool)
+{
+   const int n = Size();
+   dx_.resize(n);
+   dy_.resize(n);
+   out_of_bounds_.resize(n);
+
+   pool.ParallelFor(0, n, [this](int begin, int end) { StepRange(begin, end); });
+   steps_++;
+}
+
+void AgentStore::StepRange(int begin, int end)
+{
+   const double half = arena_size_ / 2;
+
+   double*        x   = x_.data();
+   double*        y   = y_.data();
+   double*        dx  = dx_.data();
+   double*        dy  = dy_.data();
+   unsigned char* out = out_of_bounds_.data();
+
+   // The loops below have no dependencies between agents, so any
+   // range of agents can be stepped independently of the rest. The move
+   // and bounds loops are plain arithmetic and are vectorized by the
+   // compiler; the trig loop is too when a vector math library is
+   // available (e.g. glibc's libmvec with -ffast-math), which we do
+   // not enable so that results stay reproducible.
+   for(int i = begin; i < end; i++)
+   {
+      double h = heading_[i].Radians();
+      dx[i] = speed_ * cos(h);
+      dy[i] = speed_ * sin(h);
+   }
+
+   for(int i = begin; i < end; i++)
+   {
+      x[i] = x[i] + dx[i];
+      y[i] = y[i] + dy[i];
+   }
+
+   for(int i = begin; i < end; i++)
+   {
+      out[i] = (x[i] < -half) | (x[i] > half) | (y[i] < -half) | (y[i] > half);
+   }
+
+   // Only a few agents hit a wall on any step.
+   for(int i = begin; i < end; i++)
+   {
+      if(out[i])
+      {
+         Reflect(i);
+      }
+   }
+
+   std::copy(heading_.begin() + begin, heading_.begin() + end, previous_heading_.begin() + begin);
+
+   // One loop per rule so that each turn is inlined.
+   switch(movement_kind_)
+   {
+   case MovementKind::Straight:
+      break;
+
+   case MovementKind::Random:
+      TurnRange(begin, end, [](int, auto& gen) { return RandomWalk::TurnWith(gen); });
+      break;
+
+   case MovementKind::Correlated:
+      TurnRange(begin, end, [this](int i, auto& gen)
+                {
+                   return CorrelatedRandomWalk::TurnWith(heading_[i], sigma_, gen);
+                });
+      break;
+
+   case MovementKind::Levy:
+      TurnRange(begin, end, [this](int i, auto& gen)
+                {
+                   return LevyWalk::TurnWith(levy_time_[i], levy_next_turn_[i], *step_length_,
+                                             heading_[i], gen);
+                });
+      break;
+
+   case MovementKind::Custom:
+      TurnRange(begin, end, [this](int i, auto& gen)
+                {
+                   return movement_rules_[i]->Turn(Position(i), heading_[i], gen);
+                });
+      break;
+   }
+}
+
+template<typename Turn>
+void AgentStore::TurnRange(int begin, int end, Turn turn)
+{
+   if(counter_rng_)
+   {
+      for(int i = begin; i < end; i++)
+      {
+         if(!dark_[i]) // only turn if in interactive mode.
+         {
+            Philox gen(seed_, i, steps_, MovementStream);
+            heading_[i] = turn(i, gen);
+         }
+      }
+   }
+   else
+   {
+      for(int i = begin; i < end; i++)
+      {
+         if(!dark_[i])
+         {
+            heading_[i] = turn(i, generators_[i]);
+         }
+      }
+   }
+}
+
+Agent AgentStore::GetAgent(int i) const
+{
+   Agent agent(Position(i), heading_[i], speed_, arena_size_, 0);
+   agent._previous_heading = previous_heading_[i];
+   agent.dark_             = dark_[i];
+   if(movement_kind_ == MovementKind::Custom)
+   {
+      agent._movement_rule = movement_rules_[i]->Clone();
+   }
+   else
+   {
+      agent._movement_rule = movement_rule_->Clone();
+      if(movement_kind_ == MovementKind::Levy)
+      {
+         std::static_pointer_cast<LevyWalk>(agent._movement_rule)->SetTurnState(levy_time_[i],
+                                                                                levy_next_turn_[i]);
+      }
+   }
+   if(!counter_rng_)
+   {
+      agent._gen = generators_[i];
+   }
+   return agent;
+}
+
+std::vector<Agent> AgentStore::Agents() const
+{
+   std::vector<Agent> agents;
+   agents.reserve(Size());
+   for(int i = 0; i < Size(); i++)
+   {
+      agents.push_back(GetAgent(i));
+   }
+   return agents;
+}
+
+void AgentStore::Save(std::ostream& out) const
+{
+   std::vector<double> heading;
+   std::vector<double> previous_heading;
+   for(int i = 0; i < Size(); i++)
+   {
+      heading.push_back(heading_[i].Radians());
+      previous_heading.push_back(previous_heading_[i].Radians());
+   }
+
+   serialize::WriteTag(out, "LCAAGENT");
+   serialize::Write(out, speed_);
+   serialize::Write(out, arena_size_);
+   serialize::Write<std::int32_t>(out, steps_);
+   serialize::Write<std::uint8_t>(out, counter_rng_);
+   serialize::Write(out, seed_);
+   serialize::Write<std::int32_t>(out, (int)movement_kind_);
+   serialize::Write(out, sigma_);
+   serialize::Write(out, levy_mu_);
+   serialize::Write<std::int32_t>(out, levy_max_step_);
+   serialize::WriteVector(out, x_);
+   serialize::WriteVector(out, y_);
+   serialize::WriteVector(out, heading);
+   serialize::WriteVector(out, previous_heading);
+   serialize::WriteVector(out, dark_);
+   serialize::WriteVector(out, levy_time_);
+   serialize::WriteVector(out, levy_next_turn_);
+   serialize::Write<std::uint64_t>(out, generators_.size());
+   for(const std::mt19937_64& gen : generators_)
+   {
+      serialize::WriteEngine(out, gen);
+   }
+}
+
+void AgentStore::Load(std::istream& in)
+{
+   serialize::ReadTag(in, "LCAAGENT");
+   double speed      = serialize::Read<double>(in);
+   double arena_size = serialize::Read<double>(in);
+   int    steps      = serialize::Read<std::int32_t>(in);
+   bool   counter    = serialize::Read<std::uint8_t>(in);
+   std::uint64_t seed = serialize::Read<std::uint64_t>(in);
+   MovementKind kind = (MovementKind)serialize::Read<std::int32_t>(in);
+   double sigma         = serialize::Read<double>(in);
+   double levy_mu       = serialize::Read<double>(in);
+   int    levy_max_step = serialize::Read<std::int32_t>(in);
+   if(speed != speed_ || arena_size != arena_size_ || kind != movement_kind_ || sigma != sigma_ ||
+      levy_mu != levy_mu_ || levy_max_step != levy_max_step_)
+   {
+      throw std::runtime_error("AgentStore::Load: saved with a different speed, arena or movement rule");
+   }
+
+   std::vector<double>        x                = serialize::ReadVector<double>(in);
+   std::vector<double>        y                = serialize::ReadVector<double>(in);
+   std::vector<double>        heading          = serialize::ReadVector<double>(in);
+   std::vector<double>        previous_heading = serialize::ReadVector<double>(in);
+   std::vector<unsigned char> dark             = serialize::ReadVector<unsigned char>(in);
+   std::vector<unsigned int>  levy_time        = serialize::ReadVector<unsigned int>(in);
+   std::vector<unsigned int>  levy_next_turn   = serialize::ReadVector<unsigned int>(in);
+   std::uint64_t num_generators = serialize::Read<std::uint64_t>(in);
+   const std::size_t n = Size();
+   const std::size_t n_levy = (kind == MovementKind::Levy) ? n : 0;
+   if(x.size() != n || y.size() != n || heading.size() != n || previous_heading.size() != n ||
+      dark.size() != n || levy_time.size() != n_levy || levy_next_turn.size() != n_levy ||
+      num_generators != (counter ? 0 : n))
+   {
+      throw std::runtime_error("AgentStore::Load: saved with a different number of agents");
+   }
+   std::vector<std::mt19937_64> generators(num_generators);
+   for(std::mt19937_64& gen : generators)
+   {
+      serialize::ReadEngine(in, gen);
+   }
+
+   x_.swap(x);
+   y_.swap(y);
+   heading_.assign(heading.begin(), heading.end());
+   previous_heading_.assign(previous_heading.begin(), previous_heading.end());
+   dark_.swap(dark);
+   levy_time_.swap(levy_time);
+   levy_next_turn_.swap(levy_next_turn);
+   generators_.swap(generators);
+   steps_       = steps;
+   counter_rng_ = counter;
+   seed_        = seed;
+
+   movement_rules_.clear();
+   if(movement_kind_ == MovementKind::Custom)
+   {
+      for(std::size_t i = 0; i < n; i++)
+      {
+         AddMovementState();
+      }
+   }
+}
@@ -0,0 +1,183 @@
+#include "AggregateNetwork.hpp"
+
+#include <stdexcept>
+#include <algorithm> // std::fill
+
+#include "Serialize.hpp"
+
+const int AggregateNetwork::MAX_MATRIX_VERTICES;
+
+AggregateNetwork::AggregateNetwork(int num_vertices) :
+   num_vertices_(num_vertices),
+   edge_count_(0),
+   degrees_(num_vertices, 0),
+   degree_histogram_(num_vertices + 1, 0),
+   use_matrix_(num_vertices <= MAX_MATRIX_VERTICES),
+   adjacency_(num_vertices <= MAX_MATRIX_VERTICES ? num_vertices : 0)
+{
+   degree_histogram_[0] = num_vertices;
+}
+
+AggregateNetwork::~AggregateNetwork() {}
+
+bool AggregateNetwork::InsertEdge(int u, int v)
+{
+   if(use_matrix_)
+   {
+      return adjacency_.Set(u, v);
+   }
+   return edges_.insert((std::uint64_t)u * num_vertices_ + v).second;
+}
+
+void AggregateNetwork::Clear()
+{
+   edge_count_ = 0;
+   std::fill(degrees_.begin(), degrees_.end(), 0);
+   std::fill(degree_histogram_.begin(), degree_histogram_.end(), 0);
+   degree_histogram_[0] = num_vertices_;
+   adjacency_.Clear();
+   edges_.clear();
+}
+
+int AggregateNetwork::Add(const NetworkSnapshot& snapshot)
+{
+   if(snapshot.Size() != num_vertices_)
+   {
+      throw std::invalid_argument("AggregateNetwork::Add");
+   }
+
+   int new_edges = 0;
+   for(int u = 0; u < num_vertices_; u++)
+   {
+      for(int v : snapshot.GetNeighbors(u))
+      {
+         if(u < v && InsertEdge(u, v))
+         {
+            for(int w : {u, v})
+            {
+               degree_histogram_[degrees_[w]]--;
+               degrees_[w]++;
+               degree_histogram_[degrees_[w]]++;
+            }
+            new_edges++;
+         }
+      }
+   }
+   edge_count_ += new_edges;
+   return new_edges;
+}
+
+bool AggregateNetwork::HasEdge(int u, int v) const
+{
+   if(u > v)
+   {
+      std::swap(u, v);
+   }
+   if(u < 0 || v >= num_vertices_ || u == v)
+   {
+      return false;
+   }
+   if(use_matrix_)
+   {
+      return adjacency_.Test(u, v);
+   }
+   return edges_.count((std::uint64_t)u * num_vertices_ + v) != 0;
+}
+
+int AggregateNetwork::Size() const
+{
+   return num_vertices_;
+}
+
+long long AggregateNetwork::EdgeCount() const
+{
+   return edge_count_;
+}
+
+int AggregateNetwork::Degree(int v) const
+{
+   return degrees_.at(v);
+}
+
+double AggregateNetwork::Density() const
+{
+   double n = 2 * edge_count_;
+   return n / ((double)num_vertices_ * (num_vertices_-1));
+}
+
+double AggregateNetwork::AverageDegree() const
+{
+   return (double)(2 * edge_count_) / num_vertices_;
+}
+
+double AggregateNetwork::DegreeVariance() const
+{
+   double avg = AverageDegree();
+   double variance = 0.0;
+   for(int degree : degrees_)
+   {
+      variance += (avg - degree)*(avg - degree);
+   }
+   return variance/num_vertices_;
+}
+
+int AggregateNetwork::KthDegree(int k) const
+{
+   for(int degree = 0; degree < degree_histogram_.size(); degree++)
+   {
+      k -= degree_histogram_[degree];
+      if(k < 0)
+      {
+         return degree;
+      }
+   }
+   return degree_histogram_.size() - 1;
+}
+
+double AggregateNetwork::MedianDegree() const
+{
+   if(num_vertices_ % 2 == 0)
+   {
+      // then sum the middle two and divide by 2.
+      return (double)(KthDegree(num_vertices_/2) + KthDegree(num_vertices_/2 - 1)) / 2.0;
+   }
+   else
+   {
+      return (double)KthDegree(num_vertices_/2);
+   }
+}
+
+std::vector<std::pair<int,int>> AggregateNetwork::Edges() const
+{
+   std::vector<std::pair<int,int>> edges;
+   edges.reserve(edge_count_);
+   if(use_matrix_)
+   {
+      for(int u = 0; u < num_vertices_; u++)
+      {
+         adjacency_.ForEachInRow(u, [&edges, u](int v) { edges.push_back(std::make_pair(u, v)); });
+      }
+   }
+   else
+   {
+      for(std::uint64_t id : edges_)
+      {
+         edges.push_back(std::make_pair(id / num_vertices_, id % num_vertices_));
+      }
+   }
+   return edges;
+}
+
+void AggregateNetwork::Save(std::ostream& out) const
+{
+   serialize::Write<std::int32_t>(out, num_vertices_);
+   serialize::WriteEdges(out, Edges());
+}
+
+void AggregateNetwork::Load(std::istream& in)
+{
+   int num_vertices = serialize::Read<std::int32_t>(in);
+   std::vector<std::pair<int,int>> edges = serialize::ReadEdges(in);
+   *this = AggregateNetwork(num_vertices);
+   Add(NetworkSnapshot(num_vertices, edges));
+}
@@ -0,0 +1,76 @@
+#include "AliasTable.hpp"
+
+#include <numeric>   // std::accumulate
+#include <stdexcept>
+
+AliasTable::AliasTable(const std::vector<double>& weights) :
+   probability_(weights.size(), 1.0),
+   alias_(weights.size())
+{
+   double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+   if(weights.empty() || !(total > 0))
+   {
+      throw std::invalid_argument("AliasTable: weights must have a positive sum");
+   }
+
+   // scale so that the average column holds exactly 1.
+   const int n = weights.size();
+   std::vector<double> scaled(n);
+   std::vector<int> small, large;
+   for(int i = 0; i < n; i++)
+   {
+      if(weights[i] < 0)
+      {
+         throw std::invalid_argument("AliasTable: negative weight");
+      }
+      scaled[i] = weights[i] * n / total;
+      alias_[i] = i;
+      (scaled[i] < 1.0 ? small : large).push_back(i);
+   }
+
+   // fill each under-full column from an over-full one.
+   while(!small.empty() && !large.empty())
+   {
+      int s = small.back();
+      int l = large.back();
+      small.pop_back();
+      large.pop_back();
+
+      probability_[s] = scaled[s];
+      alias_[s]       = l;
+      scaled[l]       = (scaled[l] + scaled[s]) - 1.0;
+      (scaled[l] < 1.0 ? small : large).push_back(l);
+   }
+
+   // anything left over is full up to rounding error.
+   for(int i : small)
+   {
+      probability_[i] = 1.0;
+   }
+   for(int i : large)
+   {
+      probability_[i] = 1.0;
+   }
+}
+
+AliasTable::~AliasTable() {}
+
+int AliasTable::Size() const
+{
+   return probability_.size();
+}
+
+double AliasTable::Probability(int i) const
+{
+   // the column's own share plus every share aliased to i.
+   const int n = probability_.size();
+   double p = probability_.at(i);
+   for(int j = 0; j < n; j++)
+   {
+      if(alias_[j] == i && j != i)
+      {
+         p += 1.0 - probability_[j];
+      }
+   }
+   return p / n;
+}
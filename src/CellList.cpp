@@ -0,0 +1,173 @@
+#include "CellList.hpp"
+#include "Proximity.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+CellList::CellList(double arena_size, double range) :
+   arena_size_(arena_size),
+   range_(range),
+   squared_range_(proximity::SquaredRange(range)),
+   cells_per_side_(1),
+   cell_size_(arena_size)
+{}
+
+CellList::~CellList() {}
+
+void CellList::Resize(int num_points)
+{
+   // Cells must be at least range_ wide. There is no point in having
+   // (many) more cells than points, so cap the grid at roughly four
+   // cells per point to keep small ranges from blowing up the grid.
+   int max_cells_per_side = std::max(1, (int)ceil(2.0 * sqrt((double)num_points)));
+   int cells_per_side = max_cells_per_side;
+   if(range_ > 0 && arena_size_ / range_ < max_cells_per_side)
+   {
+      cells_per_side = std::max(1, (int)floor(arena_size_ / range_));
+   }
+
+   cells_per_side_ = cells_per_side;
+   cell_size_      = arena_size_ / cells_per_side_;
+}
+
+int CellList::CellIndex(double coordinate) const
+{
+   if(cells_per_side_ == 1 || !(cell_size_ > 0))
+   {
+      return 0;
+   }
+
+   double cell = floor((coordinate + arena_size_ / 2) / cell_size_);
+   if(cell < 0)
+   {
+      return 0;
+   }
+   else if(cell >= cells_per_side_)
+   {
+      return cells_per_side_ - 1;
+   }
+   return (int)cell;
+}
+
+void CellList::Build(const std::vector<Point>& points)
+{
+   Resize(points.size());
+
+   int num_cells = cells_per_side_ * cells_per_side_;
+   cell_start_.assign(num_cells + 1, 0);
+   point_cell_.resize(points.size());
+   cell_points_.resize(points.size());
+   cell_x_.resize(points.size());
+   cell_y_.resize(points.size());
+
+   // counting sort of the points by cell.
+   for(int i = 0; i < points.size(); i++)
+   {
+      int cell = CellIndex(points[i].GetY()) * cells_per_side_ + CellIndex(points[i].GetX());
+      point_cell_[i] = cell;
+      cell_start_[cell + 1]++;
+   }
+
+   for(int c = 0; c < num_cells; c++)
+   {
+      cell_start_[c + 1] += cell_start_[c];
+   }
+
+   next_.assign(cell_start_.begin(), cell_start_.end() - 1);
+   for(int i = 0; i < points.size(); i++)
+   {
+      int slot = next_[point_cell_[i]]++;
+      cell_points_[slot] = i;
+      cell_x_[slot]      = points[i].GetX();
+      cell_y_[slot]      = points[i].GetY();
+   }
+}
+
+void CellList::Pairs(const std::vector<Point>& points,
+                     std::vector<std::pair<int,int>>& pairs) const
+{
+   pairs.clear();
+   RowPairs(points, 0, cells_per_side_, pairs);
+}
+
+void CellList::Pairs(const std::vector<Point>& points,
+                     std::vector<std::pair<int,int>>& pairs,
+                     ThreadPool& pool) const
+{
+   if(pool.NumThreads() == 1)
+   {
+      Pairs(points, pairs);
+      return;
+   }
+
+   // Rows hold different numbers of points, so use a few chunks per
+   // thread to even out the load.
+   int chunks = std::min(cells_per_side_, 4 * pool.NumThreads());
+   std::vector<std::vector<std::pair<int,int>>> chunk_pairs(chunks);
+   pool.Run(chunks, [this, &points, &chunk_pairs, chunks](int c)
+            {
+               RowPairs(points,
+                        cells_per_side_ * c / chunks,
+                        cells_per_side_ * (c + 1) / chunks,
+                        chunk_pairs[c]);
+            });
+
+   // concatenate in row order to get the same list as the serial search.
+   pairs.clear();
+   for(auto& chunk : chunk_pairs)
+   {
+      pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+   }
+}
+
+void CellList::RowPairs(const std::vector<Point>& points, int first_row, int last_row,
+                        std::vector<std::pair<int,int>>& pairs) const
+{
+   // one buffer per thread, reused by every search.
+   thread_local std::vector<int> hits;
+   hits.resize(std::max(hits.size(), points.size()));
+
+   auto add_pairs = [this, &pairs](int a, int begin, int end)
+      {
+         int i     = cell_points_[a];
+         int count = proximity::Within(cell_x_[a], cell_y_[a], cell_x_.data() + begin,
+                                       cell_y_.data() + begin, end - begin, squared_range_, hits.data());
+         for(int h = 0; h < count; h++)
+         {
+            pairs.push_back(std::minmax(i, cell_points_[begin + hits[h]]));
+         }
+      };
+
+   // Only look at half of the neighboring cells so that each pair of
+   // cells is examined exactly once: the rest of the point's own cell
+   // and the cell to its right, which follow it in cell order, and the
+   // three cells above, which are next to each other in cell order.
+   for(int cy = first_row; cy < last_row; cy++)
+   {
+      for(int cx = 0; cx < cells_per_side_; cx++)
+      {
+         int cell      = cy * cells_per_side_ + cx;
+         int right_end = cell_start_[cx + 1 < cells_per_side_ ? cell + 2 : cell + 1];
+
+         int above_begin = 0;
+         int above_end   = 0;
+         if(cy + 1 < cells_per_side_)
+         {
+            int row     = (cy + 1) * cells_per_side_;
+            above_begin = cell_start_[row + std::max(cx - 1, 0)];
+            above_end   = cell_start_[row + std::min(cx + 1, cells_per_side_ - 1) + 1];
+         }
+
+         for(int a = cell_start_[cell]; a < cell_start_[cell + 1]; a++)
+         {
+            add_pairs(a, a + 1, right_end);
+            add_pairs(a, above_begin, above_end);
+         }
+      }
+   }
+}
+
+int CellList::CellsPerSide() const
+{
+   return cells_per_side_;
+}
@@ -0,0 +1,154 @@
+#include "ConvergenceDetector.hpp"
+
+#include <algorithm> // std::minmax_element
+#include <stdexcept>
+
+const int ConvergenceDetector::DEFAULT_REPEATS;
+
+ConvergenceDetector::ConvergenceDetector() :
+   consensus_(true),
+   max_period_(0),
+   repeats_(DEFAULT_REPEATS),
+   plateau_window_(0),
+   plateau_tolerance_(0)
+{
+   Reset();
+}
+
+ConvergenceDetector::~ConvergenceDetector() {}
+
+void ConvergenceDetector::DetectConsensus(bool detect)
+{
+   consensus_ = detect;
+}
+
+void ConvergenceDetector::DetectCycles(int max_period, int repeats)
+{
+   if(max_period < 0 || repeats < 1)
+   {
+      throw std::invalid_argument("ConvergenceDetector::DetectCycles");
+   }
+   max_period_ = max_period;
+   repeats_    = repeats;
+   Reset();
+}
+
+void ConvergenceDetector::DetectPlateau(int window, double tolerance)
+{
+   if(window < 0 || tolerance < 0)
+   {
+      throw std::invalid_argument("ConvergenceDetector::DetectPlateau");
+   }
+   plateau_window_    = window;
+   plateau_tolerance_ = tolerance;
+   Reset();
+}
+
+void ConvergenceDetector::Reset()
+{
+   outcome_  = Outcome::Undecided;
+   period_   = 0;
+   observed_ = 0;
+   hashes_.assign(max_period_ > 0 ? max_period_ + 1 : 0, 0);
+   matches_.assign(max_period_ + 1, 0);
+   densities_.assign(plateau_window_, 0.0);
+}
+
+std::uint64_t ConvergenceDetector::Hash(const std::vector<int>& states)
+{
+   // FNV-1a over the states.
+   std::uint64_t hash = 14695981039346656037ULL;
+   for(int state : states)
+   {
+      hash ^= (std::uint32_t)state;
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+ConvergenceDetector::Outcome ConvergenceDetector::Observe(const std::vector<int>& states,
+                                                          int ones)
+{
+   if(outcome_ == Outcome::Undecided)
+   {
+      outcome_ = Decide(states, ones);
+   }
+   observed_++;
+   return outcome_;
+}
+
+ConvergenceDetector::Outcome ConvergenceDetector::Decide(const std::vector<int>& states,
+                                                         int ones)
+{
+   const int t = observed_;
+   const int n = states.size();
+
+   if(consensus_ && (ones == 0 || ones == n))
+   {
+      return Outcome::Consensus;
+   }
+
+   if(max_period_ > 0)
+   {
+      const int ring = max_period_ + 1;
+      std::uint64_t hash = Hash(states);
+      hashes_[t % ring] = hash;
+      for(int p = 1; p <= max_period_; p++)
+      {
+         matches_[p] = (t >= p && hashes_[(t - p) % ring] == hash) ? matches_[p] + 1 : 0;
+         if(matches_[p] >= p * repeats_)
+         {
+            period_ = p;
+            return p == 1 ? Outcome::FixedPoint : Outcome::Cycle;
+         }
+      }
+   }
+
+   if(plateau_window_ > 0)
+   {
+      densities_[t % plateau_window_] = (double)ones / n;
+      if(t + 1 >= plateau_window_)
+      {
+         auto range = std::minmax_element(densities_.begin(), densities_.end());
+         if(*range.second - *range.first <= plateau_tolerance_)
+         {
+            return Outcome::Plateau;
+         }
+      }
+   }
+
+   return Outcome::Undecided;
+}
+
+ConvergenceDetector::Outcome ConvergenceDetector::GetOutcome() const
+{
+   return outcome_;
+}
+
+bool ConvergenceDetector::IsDecided() const
+{
+   return outcome_ != Outcome::Undecided;
+}
+
+int ConvergenceDetector::Period() const
+{
+   return period_;
+}
+
+int ConvergenceDetector::Observed() const
+{
+   return observed_;
+}
+
+const char* ConvergenceDetector::Name(Outcome outcome)
+{
+   switch(outcome)
+   {
+   case Outcome::Undecided:  return "undecided";
+   case Outcome::Consensus:  return "consensus";
+   case Outcome::FixedPoint: return "fixed-point";
+   case Outcome::Cycle:      return "cycle";
+   case Outcome::Plateau:    return "plateau";
+   }
+   return "unknown";
+}
@@ -0,0 +1,12 @@
+#include "EnsembleRunner.hpp"
+
+EnsembleRunner::EnsembleRunner(int num_threads) :
+   pool_(num_threads)
+{}
+
+EnsembleRunner::~EnsembleRunner() {}
+
+int EnsembleRunner::NumThreads() const
+{
+   return pool_.NumThreads();
+}
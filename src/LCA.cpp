@@ -4,10 +4,36 @@ LCA::LCA(const Model& model, std::shared_ptr<Rule> rule, int max_time) :
    model_(std::make_unique<Model>(model)),
    max_time_(max_time),
    update_rule_(rule)
+{
+   model_->Reserve(max_time);
+}
+
+LCA::LCA(Model&& model, std::shared_ptr<Rule> rule, int max_time) :
+   LCA(std::make_unique<Model>(std::move(model)), rule, max_time)
 {}
 
+LCA::LCA(std::unique_ptr<Model> model, std::shared_ptr<Rule> rule, int max_time) :
+   model_(std::move(model)),
+   max_time_(max_time),
+   update_rule_(rule)
+{
+   model_->Reserve(max_time);
+}
+
 LCA::~LCA() {}
 
+void LCA::Reset(int seed, double initial_density)
+{
+   model_->Reset(seed, initial_density);
+   model_->Reserve(max_time_);
+   convergence_.Reset();
+}
+
+void LCA::SetPositionalState(double initial_density)
+{
+   model_->SetPositionalState(initial_density);
+}
+
 void LCA::Run()
 {
    for(int i = 0; i < max_time_; i++)
@@ -28,6 +54,40 @@ int LCA::Run(std::function<bool(const ModelStats&)> early_stop)
    return max_time_;
 }
 
+int LCA::RunUntilDecided()
+{
+   convergence_.Reset();
+   for(int i = 0; i < max_time_; i++)
+   {
+      if(convergence_.Observe(model_->GetStates(), model_->CurrentOnes())
+         != ConvergenceDetector::Outcome::Undecided)
+      {
+         return i;
+      }
+      model_->Step(update_rule_.get());
+   }
+   return max_time_;
+}
+
+void LCA::SetConvergence(const ConvergenceDetector& detector)
+{
+   convergence_ = detector;
+   convergence_.Reset();
+}
+
+const ConvergenceDetector& LCA::GetConvergence() const
+{
+   return convergence_;
+}
+
+void LCA::Resume()
+{
+   for(int i = model_->Steps(); i < max_time_; i++)
+   {
+      model_->Step(update_rule_.get());
+   }
+}
+
 void LCA::Run(int k)
 {
    for(int i = 0; i < k; i++)
@@ -36,7 +96,7 @@ void LCA::Run(int k)
    }
 }
 
-const std::vector<Agent>& LCA::GetAgents() const
+std::vector<Agent> LCA::GetAgents() const
 {
    return model_->GetAgents();
 }
@@ -56,12 +116,37 @@ const ModelStats& LCA::GetStats() const
    return model_->GetStats();
 }
 
+const Model& LCA::GetModel() const
+{
+   return *model_;
+}
+
+const StepProfile& LCA::GetProfile() const
+{
+   return model_->GetProfile();
+}
+
 double LCA::CurrentDensity() const
 {
    return model_->CurrentDensity();
 }
 
+void LCA::StreamStats(int window)
+{
+   model_->StreamStats(window);
+}
+
 void LCA::MinimizeMemory()
 {
    model_->RecordNetworkDensityOnly();
 }
+
+void LCA::Save(std::ostream& out) const
+{
+   model_->Save(out);
+}
+
+void LCA::Load(std::istream& in)
+{
+   model_->Load(in);
+}
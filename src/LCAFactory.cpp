@@ -2,11 +2,14 @@
 
 #include <getopt.h>
 #include <limits>
+#include <algorithm> // std::min
 #include <sstream>
 #include <streambuf>
 #include <fstream>
+#include <iostream>
 
 #include "TotalisticRule.hpp"
+#include "Philox.hpp"
 
 LCAFactory::LCAFactory() :
    num_agents_(255),
@@ -14,6 +17,7 @@ LCAFactory::LCAFactory() :
    arena_size_(100),
    speed_(1),
    seed_(-1),
+   base_seed_(0),
    max_time_(5000),
    init_(Uniform)
 {
@@ -25,6 +29,15 @@ LCAFactory::LCAFactory() :
 int LCAFactory::Init(int argc, char** argv)
 {
    int by_position = 0;
+   int all_pairs   = 0;
+   int counter_rng = 0;
+   int profile     = 0;
+   std::string checkpoint_path;
+   int    max_period        = 0;
+   int    period_repeats    = ConvergenceDetector::DEFAULT_REPEATS;
+   int    plateau_window    = 0;
+   double plateau_tolerance = 0;
+   std::string signature = SweepCheckpoint::Signature(argc, argv); // before getopt reorders argv
 
    static struct option long_options[] =
       {
@@ -39,13 +52,24 @@ int LCAFactory::Init(int argc, char** argv)
          {"rule",                required_argument, 0,            'R'},
          {"pdark",               required_argument, 0,            'd'},
          {"pinteractive",        required_argument, 0,            'i'},
+         {"all-pairs",           no_argument,       &all_pairs,   'A'},
+         {"rule-max-degree",     required_argument, 0,            'D'},
+         {"counter-rng",         no_argument,       &counter_rng, 'C'},
+         {"threads",             required_argument, 0,            'j'},
+         {"profile",             no_argument,       &profile,     'P'},
+         {"verlet-skin",         required_argument, 0,            'V'},
+         {"checkpoint",          required_argument, 0,            'K'},
+         {"max-period",          required_argument, 0,            'Y'},
+         {"period-repeats",      required_argument, 0,            'y'},
+         {"plateau-window",      required_argument, 0,            'W'},
+         {"plateau-tolerance",   required_argument, 0,            'w'},
          {0,0,0,0}
       };
    int option_index = 0;
    char opt_char;
    std::ifstream file;
    TotalisticRule r;
-   while((opt_char = getopt_long(argc, argv, "r:n:a:s:S:c:R:T:",
+   while((opt_char = getopt_long(argc, argv, "r:n:a:s:S:c:R:T:j:V:K:Y:y:W:w:",
                                  long_options, &option_index)) != -1)
    {
       std::stringstream message;
@@ -83,6 +107,39 @@ int LCAFactory::Init(int argc, char** argv)
          max_time_ = atoi(optarg);
          break;
 
+      case 'D':
+         rule_max_degree_ = atoi(optarg);
+         break;
+
+      case 'j':
+         threads_ = atoi(optarg);
+         break;
+
+      case 'V':
+         verlet_skin_     = atof(optarg);
+         neighbor_search_ = Model::NeighborSearch::Verlet;
+         break;
+
+      case 'K':
+         checkpoint_path = optarg;
+         break;
+
+      case 'Y':
+         max_period = atoi(optarg);
+         break;
+
+      case 'y':
+         period_repeats = atoi(optarg);
+         break;
+
+      case 'W':
+         plateau_window = atoi(optarg);
+         break;
+
+      case 'w':
+         plateau_tolerance = atof(optarg);
+         break;
+
       case 'c':
          movement_rule_ = std::make_shared<CorrelatedRandomWalk>(atof(optarg));
          break;
@@ -111,42 +168,124 @@ int LCAFactory::Init(int argc, char** argv)
       init_ = ByPosition;
    }
 
+   // An agent can never have more than num_agents_-1 neighbors, so
+   // there is no need for a larger table. Rule files are already
+   // compiled with the default size.
+   std::shared_ptr<TotalisticRule> totalistic = std::dynamic_pointer_cast<TotalisticRule>(rule_);
+   int max_degree = std::min(num_agents_ - 1, rule_max_degree_);
+   if(totalistic && totalistic->MaxDegree() != max_degree)
+   {
+      totalistic->Compile(max_degree);
+   }
+
+   if(all_pairs != 0)
+   {
+      neighbor_search_ = Model::NeighborSearch::AllPairs;
+   }
+
+   counter_rng_ = (counter_rng != 0);
+
+   convergence_.DetectCycles(max_period, period_repeats);
+   convergence_.DetectPlateau(plateau_window, plateau_tolerance);
+
+   profile_ = (profile != 0);
+   if(profile_ && !StepProfile::Enabled())
+   {
+      std::cerr << "warning: --profile has no effect, rebuild with -DLCA_PROFILE=On" << std::endl;
+   }
+
    if(seed_ != -1)
    {
-      random_engine_.seed(seed_);
+      base_seed_ = seed_;
    }
    else
    {
       std::random_device rd;
-      random_engine_.seed(rd());
+      base_seed_ = rd();
    }
 
+   if(!checkpoint_path.empty())
+   {
+      checkpoint_ = std::make_unique<SweepCheckpoint>(checkpoint_path, signature, base_seed_);
+      base_seed_  = checkpoint_->Seed();
+   }
+   random_engine_.seed(base_seed_);
+
    return optind;
 }
 
 std::unique_ptr<LCA> LCAFactory::Create(double initial_density)
 {
-   // lock so multiple threads can produce new LCAs at once
-   std::lock_guard<std::mutex> lock(new_lca_mutex_);
+   int seed;
+   {
+      // lock so multiple threads can produce new LCAs at once
+      std::lock_guard<std::mutex> lock(new_lca_mutex_);
+      seed = seed_distribution_(random_engine_);
+   }
+   return Create(initial_density, seed);
+}
 
-   int seed = seed_distribution_(random_engine_);
+std::unique_ptr<LCA> LCAFactory::Create(double initial_density, int seed) const
+{
+   // build the model in place; the LCA takes it over.
+   std::unique_ptr<Model> model = std::make_unique<Model>(arena_size_,
+                                                          num_agents_,
+                                                          communication_range_,
+                                                          seed,
+                                                          initial_density,
+                                                          speed_);
+   if(counter_rng_)
+   {
+      model->UseCounterRng();
+   }
+   model->SetMovementRule(movement_rule_);
+   model->SetPDark(pdark_);
+   model->SetPInteractive(pinteractive_);
+   model->SetNeighborSearch(neighbor_search_);
+   if(neighbor_search_ == Model::NeighborSearch::Verlet)
+   {
+      model->SetVerletSkin(verlet_skin_);
+   }
+   if(threads_ != 1)
+   {
+      model->SetThreads(threads_);
+   }
 
-   Model model(arena_size_,
-               num_agents_,
-               communication_range_,
-               seed,
-               initial_density,
-               speed_);
-   model.SetMovementRule(movement_rule_);
-   model.SetPDark(pdark_);
-   model.SetPInteractive(pinteractive_);
+   if(init_ == ByPosition)
+   {
+      model->SetPositionalState(initial_density);
+   }
+
+   std::unique_ptr<LCA> lca = std::make_unique<LCA>(std::move(model), rule_, max_time_);
+   lca->SetConvergence(convergence_);
+   return lca;
+}
 
+void LCAFactory::Reset(LCA& lca, double initial_density, int seed) const
+{
+   lca.Reset(seed, initial_density);
    if(init_ == ByPosition)
    {
-      model.SetPositionalState(initial_density);
+      lca.SetPositionalState(initial_density);
    }
+   lca.SetConvergence(convergence_);
+}
 
-   return std::make_unique<LCA>(model, rule_, max_time_);
+int LCAFactory::Seed(int parameter, int replica) const
+{
+   Philox gen(base_seed_, parameter, replica);
+   std::uniform_int_distribution<int> seed_distribution(seed_distribution_.param());
+   return seed_distribution(gen);
+}
+
+bool LCAFactory::Profile() const
+{
+   return profile_;
+}
+
+SweepCheckpoint* LCAFactory::Checkpoint() const
+{
+   return checkpoint_.get();
 }
 
 double LCAFactory::ArenaSize() const
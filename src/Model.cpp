@@ -1,7 +1,52 @@
 #include "Model.hpp"
+#include "Serialize.hpp"
 
 #include <numeric>   // std::accumulate
-#include <algorithm> // std::for_each
+#include <algorithm> // std::for_each, std::min
+#include <stdexcept>
+#include <atomic>
+
+namespace
+{
+   int CountCommonScalar(const std::uint64_t* a, const std::uint64_t* b, int words)
+   {
+      int count = 0;
+      for(int w = 0; w < words; w++)
+      {
+         count += __builtin_popcountll(a[w] & b[w]);
+      }
+      return count;
+   }
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+   __attribute__((target("popcnt")))
+   int CountCommonPopcnt(const std::uint64_t* a, const std::uint64_t* b, int words)
+   {
+      int count = 0;
+      for(int w = 0; w < words; w++)
+      {
+         count += __builtin_popcountll(a[w] & b[w]);
+      }
+      return count;
+   }
+#endif
+
+   /**
+    * Count the bits set in both a and b, with the popcnt instruction
+    * where the CPU has it.
+    */
+   int CountCommon(const std::uint64_t* a, const std::uint64_t* b, int words)
+   {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+      static const bool popcnt = __builtin_cpu_supports("popcnt");
+      if(popcnt)
+      {
+         return CountCommonPopcnt(a, b, words);
+      }
+#endif
+      return CountCommonScalar(a, b, words);
+   }
+}
 
 Model::Model(double arena_size,
              int num_agents,
@@ -10,14 +55,30 @@ Model::Model(double arena_size,
              double initial_density,
              double agent_speed) :
    _communication_range(communication_range),
+   _steps(0),
+   _seed(seed),
    _rng(seed),
+   _counter_rng(false),
    _stats(num_agents),
    _noise(0.0),
+   _noise_probability(0.0),
    _arena_size(arena_size),
+   _agents(agent_speed, arena_size),
+   _thread_pool(std::make_shared<ThreadPool>(1)),
    go_interactive_(1.0),
-   go_dark_(0.0)
+   go_dark_(0.0),
+   _network_builder(arena_size, communication_range, std::min(communication_range / 2, 10 * agent_speed)),
+   _packed_states(true),
+   _initial_dark(false)
+{
+   Populate(num_agents, initial_density);
+}
+
+Model::~Model() {}
+
+void Model::Populate(int num_agents, double initial_density)
 {
-   std::uniform_real_distribution<double> coordinate_distribution(-arena_size/2, arena_size/2);
+   std::uniform_real_distribution<double> coordinate_distribution(-_arena_size/2, _arena_size/2);
    std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
    std::bernoulli_distribution state_distribution(initial_density);
    std::uniform_int_distribution<int> seed_distribution;
@@ -26,8 +87,7 @@ Model::Model(double arena_size,
    {
       Point initial_position(coordinate_distribution(_rng), coordinate_distribution(_rng));
       Heading initial_heading(heading_distribution(_rng));
-      Agent a(initial_position, initial_heading, agent_speed, arena_size, seed_distribution(_rng));
-      _agents.push_back(a);
+      _agents.Add(initial_position, initial_heading, seed_distribution(_rng));
       if(state_distribution(_rng))
       {
          _agent_states.push_back(1);
@@ -39,18 +99,39 @@ Model::Model(double arena_size,
    }
    _turn_distribution = heading_distribution;
    _step_distribution = std::uniform_int_distribution<int>(1,1);
-   _stats.PushState(CurrentDensity(), CurrentNetwork());
+   CountOnes();
+   _stats.PushCount(_ones, NextNetwork());
 }
 
-Model::~Model() {}
+void Model::Reset(int seed, double initial_density)
+{
+   const int num_agents = _agents.Size();
+   _steps   = 0;
+   _seed    = seed;
+   _rng.seed(seed);
+   _profile = StepProfile();
+   _noise.reset();
+   go_dark_.reset();
+   go_interactive_.reset();
+
+   _agents.Clear(seed);
+   _agent_states.clear();
+   _stats.Clear();
+   _network_builder.Clear();
+   Populate(num_agents, initial_density);
+   if(_initial_dark)
+   {
+      DrawInitialModes();
+   }
+}
 
 void Model::SetPositionalState(double initial_density)
 {
    double x_threshold = (_arena_size / 2.0) - (_arena_size * (1.0 - initial_density));
-   _stats = ModelStats(_agents.size());
-   for(int i = 0; i < _agents.size(); i++)
+   _stats.Clear();
+   for(int i = 0; i < _agents.Size(); i++)
    {
-      if(_agents[i].Position().GetX() <= x_threshold)
+      if(_agents.Position(i).GetX() <= x_threshold)
       {
          _agent_states[i] = 1;
       }
@@ -59,7 +140,8 @@ void Model::SetPositionalState(double initial_density)
          _agent_states[i] = 0;
       }
    }
-   _stats.PushState(CurrentDensity(), CurrentNetwork());
+   CountOnes();
+   _stats.PushCount(_ones, StepNetwork());
 }
 
 void Model::RecordNetworkDensityOnly()
@@ -67,25 +149,40 @@ void Model::RecordNetworkDensityOnly()
    _stats.NetworkSummaryOnly();
 }
 
+void Model::StreamStats(int window)
+{
+   _stats.Streaming(window);
+}
+
 double Model::CurrentDensity() const
 {
-   return std::accumulate(_agent_states.begin(), _agent_states.end(), 0.0) / _agent_states.size();
+   return (double)_ones / _agent_states.size();
+}
+
+int Model::CurrentOnes() const
+{
+   return _ones;
+}
+
+void Model::CountOnes()
+{
+   _ones = std::accumulate(_agent_states.begin(), _agent_states.end(), 0);
+}
+
+std::shared_ptr<NetworkSnapshot> Model::StepNetwork() const
+{
+   return _network_builder.Network();
 }
 
 std::shared_ptr<NetworkSnapshot> Model::CurrentNetwork() const
 {
-   std::shared_ptr<NetworkSnapshot> snapshot = std::make_shared<NetworkSnapshot>(_agents.size());
-   for(int i = 0; i < _agents.size(); i++)
-   {
-      for(int j = i+1; j < _agents.size(); j++)
-      {
-         if(_agents[i].Position().Within(_communication_range, _agents[j].Position()))
-         {
-            snapshot->AddEdge(i, j);
-         }
-      }
-   }
-   return snapshot;
+   return _network_builder.Search(_agents.Positions());
+}
+
+std::shared_ptr<NetworkSnapshot> Model::NextNetwork()
+{
+   _agents.Positions(_positions);
+   return _network_builder.Build(_positions, *_thread_pool);
 }
 
 const ModelStats& Model::GetStats() const
@@ -93,7 +190,12 @@ const ModelStats& Model::GetStats() const
    return _stats;
 }
 
-const std::vector<Agent>& Model::GetAgents() const
+std::vector<Agent> Model::GetAgents() const
+{
+   return _agents.Agents();
+}
+
+const AgentStore& Model::GetAgentStore() const
 {
    return _agents;
 }
@@ -103,12 +205,34 @@ const std::vector<int>& Model::GetStates() const
    return _agent_states;
 }
 
+void Model::Reserve(int steps)
+{
+   _stats.Reserve(steps);
+}
+
 void Model::SetMovementRule(std::shared_ptr<MovementRule> rule)
 {
-   for(auto& agent : _agents)
-   {
-      agent.SetMovementRule(rule->Clone());
-   }
+   _agents.SetMovementRule(rule);
+}
+
+void Model::SetNeighborSearch(NeighborSearch method)
+{
+   _network_builder.SetMethod(method);
+}
+
+void Model::SetVerletSkin(double skin)
+{
+   _network_builder.SetVerletSkin(skin);
+}
+
+int Model::VerletRebuilds() const
+{
+   return _network_builder.VerletRebuilds();
+}
+
+void Model::UsePackedStates(bool use)
+{
+   _packed_states = use;
 }
 
 void Model::SetNoise(double p)
@@ -119,13 +243,18 @@ void Model::SetNoise(double p)
 
 void Model::SetPDark(double p)
 {
-   go_dark_ = std::bernoulli_distribution(fabs(p));
+   go_dark_      = std::bernoulli_distribution(fabs(p));
+   _initial_dark = true;
+   DrawInitialModes();
+}
 
-   for(auto& agent : _agents)
+void Model::DrawInitialModes()
+{
+   for(int i = 0; i < _agents.Size(); i++)
    {
       if(go_dark_(_rng))
       {
-         agent.GoDark();
+         _agents.GoDark(i);
       }
    }
 }
@@ -135,9 +264,21 @@ void Model::SetPInteractive(double p)
    go_interactive_ = std::bernoulli_distribution(fabs(p));
 }
 
-int Model::Noise(int i)
+void Model::UseCounterRng()
+{
+   _counter_rng = true;
+   _agents.UseCounterRng(_seed);
+}
+
+void Model::SetThreads(int num_threads)
+{
+   _thread_pool = std::make_shared<ThreadPool>(num_threads);
+}
+
+template<typename Generator>
+int Model::Noise(int i, Generator& gen)
 {
-   if(_noise(_rng))
+   if(_noise(gen))
    {
       return 1 - i;
    }
@@ -147,54 +288,303 @@ int Model::Noise(int i)
    }
 }
 
-void Model::Step(const Rule* rule)
+template<typename Generator>
+void Model::UpdateMode(int i, Generator& gen)
 {
-   for(Agent& agent : _agents)
+   if(_agents.IsInteractive(i) && go_dark_(gen))
+   {
+      _agents.GoDark(i);
+   }
+   else if(_agents.IsDark(i) && go_interactive_(gen))
    {
-      agent.Step();
-      if(agent.IsInteractive() && go_dark_(_rng))
+      _agents.GoInteractive(i);
+   }
+}
+
+template<typename Generator, typename F>
+void Model::ForEachNeighborState(const NeighborView& neighbors, Generator& gen, F f)
+{
+   for(int n : neighbors)
+   {
+      if(_agents.IsInteractive(n))
       {
-         agent.GoDark();
+         if(_counter_rng && _noise_probability == 0.0)
+         {
+            // each agent has its own noise stream, so there is no need
+            // to make draws that can never flip a state.
+            f(_agent_states[n]);
+         }
+         else if(_noise_probability < 0.0) {
+            if(!_noise(gen))
+            {
+               f(_agent_states[n]);
+            }
+         }
+         else
+         {
+            f(Noise(_agent_states[n], gen));
+         }
       }
-      else if(agent.IsDark() && go_interactive_(_rng))
+   }
+}
+
+template<typename Generator>
+std::pair<int, double> Model::Update(const Rule* rule, bool totalistic, int a,
+                                     const NetworkSnapshot& network, Generator& gen)
+{
+   if(totalistic)
+   {
+      int ones  = 0;
+      int total = 0;
+      ForEachNeighborState(network.GetNeighbors(a), gen,
+                           [&ones, &total](int state) { ones += state; total++; });
+      return rule->ApplyCount(_agent_states[a], ones, total);
+   }
+   else
+   {
+      // one buffer per thread, reused for every agent.
+      thread_local std::vector<int> thread_neighbor_states;
+      std::vector<int>& neighbor_states = thread_neighbor_states;
+      neighbor_states.clear();
+      ForEachNeighborState(network.GetNeighbors(a), gen,
+                           [&neighbor_states](int state) { neighbor_states.push_back(state); });
+      return rule->Apply(_agent_states[a], neighbor_states);
+   }
+}
+
+std::pair<int, double> Model::UpdatePacked(const Rule* rule, const BitMatrix& adjacency, int a) const
+{
+   const std::uint64_t* row   = adjacency.Row(a);
+   const int            words = adjacency.WordsPerRow();
+   int ones  = CountCommon(row, _packed_ones.data(), words);
+   int total = CountCommon(row, _packed_interactive.data(), words);
+   return rule->ApplyCount(_agent_states[a], ones, total);
+}
+
+const BitMatrix* Model::PackStates(const Rule* rule)
+{
+   const BitMatrix* adjacency = _network_builder.Adjacency();
+   if(adjacency == nullptr || !rule->IsTotalistic())
+   {
+      return nullptr;
+   }
+
+   const int n = _agents.Size();
+   _packed_ones.assign(adjacency->WordsPerRow(), 0);
+   _packed_interactive.assign(adjacency->WordsPerRow(), 0);
+   for(int i = 0; i < n; i++)
+   {
+      if(_agent_states[i] != 0 && _agent_states[i] != 1)
+      {
+         return nullptr;
+      }
+      if(_agents.IsInteractive(i))
+      {
+         _packed_ones[i / 64]        |= (std::uint64_t)_agent_states[i] << (i % 64);
+         _packed_interactive[i / 64] |= (std::uint64_t)1 << (i % 64);
+      }
+   }
+   return adjacency;
+}
+
+void Model::UpdateModes(int begin, int end)
+{
+   for(int i = begin; i < end; i++)
+   {
+      if(_counter_rng)
+      {
+         Philox gen(_seed, i, _steps, AgentStore::ModeStream);
+         UpdateMode(i, gen);
+      }
+      else
       {
-         agent.GoInteractive();
+         UpdateMode(i, _rng);
       }
    }
+}
 
-   std::shared_ptr<NetworkSnapshot> current_network = CurrentNetwork();
-   std::vector<int> new_states(_agents.size());
-   for(int a = 0; a < _agent_states.size(); a++)
+int Model::UpdateStates(const Rule* rule, const NetworkSnapshot& network, const BitMatrix* adjacency,
+                        std::vector<int>& new_states, int begin, int end)
+{
+   bool totalistic = rule->IsTotalistic();
+   int  change     = 0;
+   for(int a = begin; a < end; a++)
    {
-      if(_agents[a].IsInteractive())
+      if(_agents.IsInteractive(a))
       {
-         auto neighbors = current_network->GetNeighbors(a);
-         std::vector<int> neighbor_states;
-         for(int n : neighbors)
+         std::pair<int, double> update;
+         if(adjacency != nullptr)
          {
-            if(_agents[n].IsInteractive())
-            {
-               if(_noise_probability < 0.0) {
-                  if(!_noise(_rng))
-                  {
-                     neighbor_states.push_back(_agent_states[n]);
-                  }
-               }
-               else
-               {
-                  neighbor_states.push_back(Noise(_agent_states[n]));
-               }
-            }
+            update = UpdatePacked(rule, *adjacency, a);
+         }
+         else if(_counter_rng)
+         {
+            Philox gen(_seed, a, _steps, AgentStore::NoiseStream);
+            update = Update(rule, totalistic, a, network, gen);
+         }
+         else
+         {
+            update = Update(rule, totalistic, a, network, _rng);
          }
-         std::pair<int, double> update = rule->Apply(_agent_states[a], neighbor_states);
          new_states[a] = update.first;
-         _agents[a].SetHeading(_agents[a].GetHeading() + Heading(update.second));
+         change += update.first - _agent_states[a];
+         _agents.SetHeading(a, _agents.GetHeading(a) + Heading(update.second));
       }
       else
       {
          new_states[a] = _agent_states[a];
       }
    }
-   _agent_states = new_states;
-   _stats.PushState(CurrentDensity(), current_network);
+   return change;
+}
+
+void Model::Step(const Rule* rule)
+{
+   LCA_PROFILE_ONLY(long long allocations = StepProfile::ThreadAllocations());
+   const int n = _agents.Size();
+
+   {
+      LCA_PROFILE_SCOPE(_profile.move_seconds);
+      // Each agent only uses its own random number generator to move, so
+      // moving all the agents before any of them change mode consumes the
+      // model's generator in the same order as stepping them one by one.
+      _agents.Step(*_thread_pool);
+   }
+
+   {
+      LCA_PROFILE_SCOPE(_profile.mode_seconds);
+      // Without counter-based streams all agents share _rng, so the draws
+      // have to be made in agent order.
+      if(_counter_rng)
+      {
+         _thread_pool->ParallelFor(0, n, [this](int begin, int end) { UpdateModes(begin, end); });
+      }
+      else
+      {
+         UpdateModes(0, n);
+      }
+   }
+
+   std::shared_ptr<NetworkSnapshot> current_network;
+   {
+      LCA_PROFILE_SCOPE(_profile.network_seconds);
+      // Only worth keeping the adjacency rows if PackStates() can use
+      // them.
+      _network_builder.KeepAdjacency(_packed_states && _counter_rng && _noise_probability == 0.0 &&
+                                     rule->IsTotalistic());
+      current_network = NextNetwork();
+   }
+
+   {
+      LCA_PROFILE_SCOPE(_profile.update_seconds);
+      _new_states.resize(n);
+      const BitMatrix* adjacency = PackStates(rule);
+      if(_counter_rng)
+      {
+         std::atomic<int> change(0);
+         _thread_pool->ParallelFor(0, n, [this, rule, &current_network, adjacency, &change](int begin, int end)
+                                   {
+                                      change += UpdateStates(rule, *current_network, adjacency, _new_states,
+                                                             begin, end);
+                                   });
+         _ones += change;
+      }
+      else
+      {
+         _ones += UpdateStates(rule, *current_network, adjacency, _new_states, 0, n);
+      }
+      _agent_states.swap(_new_states);
+   }
+   _steps++;
+
+   {
+      LCA_PROFILE_SCOPE(_profile.stats_seconds);
+      _stats.PushCount(_ones, current_network);
+   }
+
+   LCA_PROFILE_ONLY(
+      _profile.steps++;
+      _profile.edges += current_network->EdgeCount();
+      for(int a = 0; a < n; a++)
+      {
+         _profile.rule_applications += _agents.IsInteractive(a);
+      }
+      _profile.allocations += StepProfile::ThreadAllocations() - allocations);
+}
+
+const StepProfile& Model::GetProfile() const
+{
+   return _profile;
+}
+
+int Model::Steps() const
+{
+   return _steps;
+}
+
+void Model::Save(std::ostream& out) const
+{
+   serialize::WriteTag(out, "LCAMODEL");
+   serialize::Write<std::uint32_t>(out, 2); // version
+   serialize::Write<std::int32_t>(out, _steps);
+   serialize::Write<std::int32_t>(out, _seed);
+   serialize::Write(out, _communication_range);
+   serialize::Write<std::uint8_t>(out, _counter_rng);
+   serialize::Write(out, _noise_probability);
+   serialize::Write(out, go_dark_.p());
+   serialize::Write(out, go_interactive_.p());
+   serialize::WriteEngine(out, _rng);
+   serialize::WriteVector(out, _agent_states);
+   _agents.Save(out);
+   _stats.Save(out);
+   if(!out)
+   {
+      throw std::runtime_error("Model::Save: write failed");
+   }
+}
+
+void Model::Load(std::istream& in)
+{
+   serialize::ReadTag(in, "LCAMODEL");
+   if(serialize::Read<std::uint32_t>(in) != 2)
+   {
+      throw std::runtime_error("Model::Load: unknown version");
+   }
+   int    steps = serialize::Read<std::int32_t>(in);
+   int    seed  = serialize::Read<std::int32_t>(in);
+   double range = serialize::Read<double>(in);
+   if(range != _communication_range)
+   {
+      throw std::runtime_error("Model::Load: saved with a different communication range");
+   }
+   bool   counter_rng  = serialize::Read<std::uint8_t>(in);
+   double noise        = serialize::Read<double>(in);
+   double pdark        = serialize::Read<double>(in);
+   double pinteractive = serialize::Read<double>(in);
+   std::mt19937_64 rng;
+   serialize::ReadEngine(in, rng);
+   std::vector<int> states = serialize::ReadVector<int>(in);
+   if(states.size() != _agent_states.size())
+   {
+      throw std::runtime_error("Model::Load: saved with a different number of agents");
+   }
+
+   // Load into copies so a bad stream leaves the model unchanged.
+   AgentStore agents = _agents;
+   ModelStats stats  = _stats;
+   agents.Load(in);
+   stats.Load(in);
+
+   _steps          = steps;
+   _seed           = seed;
+   _counter_rng    = counter_rng;
+   _rng            = rng;
+   _agent_states   = states;
+   CountOnes();
+   _agents         = agents;
+   _stats          = stats;
+   SetNoise(noise);
+   go_dark_        = std::bernoulli_distribution(pdark);
+   go_interactive_ = std::bernoulli_distribution(pinteractive);
+   _network_builder.SetNetwork(CurrentNetwork());
 }
@@ -0,0 +1,510 @@
+#include "ModelBatch.hpp"
+#include "AgentStore.hpp"
+#include "Philox.hpp"
+
+#include <cmath>     // M_PI
+#include <algorithm> // std::min
+#include <typeinfo>
+#include <stdexcept>
+
+ModelBatch::ModelBatch(double arena_size,
+                       int num_agents,
+                       double communication_range,
+                       const std::vector<int>& seeds,
+                       double initial_density,
+                       double agent_speed) :
+   num_agents_(num_agents),
+   num_replicas_(seeds.size()),
+   arena_size_(arena_size),
+   speed_(agent_speed),
+   seeds_(seeds),
+   steps_(seeds.size(), 0),
+   active_(seeds.size(), true),
+   stats_(seeds.size(), ModelStats(num_agents)),
+   ones_(seeds.size(), 0),
+   x_(num_agents * seeds.size()),
+   y_(num_agents * seeds.size()),
+   heading_(num_agents * seeds.size()),
+   dark_(num_agents * seeds.size(), false),
+   states_(num_agents * seeds.size()),
+   noise_(0.0),
+   go_dark_(0.0),
+   go_interactive_(1.0),
+   noise_probability_(0.0),
+   thread_pool_(std::make_shared<ThreadPool>(1)),
+   builders_(seeds.size(), NetworkBuilder(arena_size, communication_range,
+                                          std::min(communication_range / 2, 10 * agent_speed))),
+   positions_(seeds.size()),
+   replica_states_(seeds.size()),
+   replica_dark_(seeds.size()),
+   neighbor_states_(seeds.size())
+{
+   // Same draws, in the same order, as the Model constructor.
+   std::uniform_real_distribution<double> coordinate_distribution(-arena_size/2, arena_size/2);
+   std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
+   std::bernoulli_distribution state_distribution(initial_density);
+   std::uniform_int_distribution<int> seed_distribution;
+
+   for(int r = 0; r < num_replicas_; r++)
+   {
+      generators_.push_back(std::mt19937_64(seeds[r]));
+      std::mt19937_64& gen = generators_.back();
+      for(int i = 0; i < num_agents_; i++)
+      {
+         int k = Index(i, r);
+         // Built the same way as in Model so that the unspecified
+         // order of the two draws is the same too.
+         Point initial_position(coordinate_distribution(gen), coordinate_distribution(gen));
+         x_[k]       = initial_position.GetX();
+         y_[k]       = initial_position.GetY();
+         heading_[k] = Heading(heading_distribution(gen));
+         seed_distribution(gen); // the seed of the agent's own generator
+         states_[k]  = state_distribution(gen) ? 1 : 0;
+         ones_[r]   += states_[k];
+      }
+   }
+
+   movement_rules_.resize(x_.size());
+   SetMovementRule(std::make_shared<MovementRule>());
+
+   for(int r = 0; r < num_replicas_; r++)
+   {
+      stats_[r].PushCount(ones_[r], NextNetwork(r));
+   }
+}
+
+ModelBatch::~ModelBatch() {}
+
+int ModelBatch::Index(int agent, int replica) const
+{
+   return agent * num_replicas_ + replica;
+}
+
+int ModelBatch::NumAgents() const
+{
+   return num_agents_;
+}
+
+int ModelBatch::NumReplicas() const
+{
+   return num_replicas_;
+}
+
+void ModelBatch::SetMovementRule(std::shared_ptr<MovementRule> rule)
+{
+   straight_ = typeid(*rule) == typeid(MovementRule);
+   if(!straight_)
+   {
+      rule->CheckCounterTurn();
+   }
+   for(auto& movement_rule : movement_rules_)
+   {
+      movement_rule = rule->Clone();
+   }
+}
+
+void ModelBatch::SetNoise(double p)
+{
+   noise_probability_ = p;
+   noise_ = std::bernoulli_distribution(fabs(p));
+}
+
+void ModelBatch::SetPDark(double p)
+{
+   go_dark_ = std::bernoulli_distribution(fabs(p));
+
+   for(int r = 0; r < num_replicas_; r++)
+   {
+      for(int i = 0; i < num_agents_; i++)
+      {
+         if(go_dark_(generators_[r]))
+         {
+            dark_[Index(i, r)] = true;
+         }
+      }
+   }
+}
+
+void ModelBatch::SetPInteractive(double p)
+{
+   go_interactive_ = std::bernoulli_distribution(fabs(p));
+}
+
+void ModelBatch::SetThreads(int num_threads)
+{
+   thread_pool_ = std::make_shared<ThreadPool>(num_threads);
+}
+
+void ModelBatch::RecordNetworkDensityOnly()
+{
+   for(ModelStats& stats : stats_)
+   {
+      stats.NetworkSummaryOnly();
+   }
+}
+
+void ModelBatch::Reserve(int steps)
+{
+   for(ModelStats& stats : stats_)
+   {
+      stats.Reserve(steps);
+   }
+}
+
+void ModelBatch::SetNeighborSearch(NetworkBuilder::Method method)
+{
+   for(NetworkBuilder& builder : builders_)
+   {
+      builder.SetMethod(method);
+   }
+}
+
+void ModelBatch::SetVerletSkin(double skin)
+{
+   for(NetworkBuilder& builder : builders_)
+   {
+      builder.SetVerletSkin(skin);
+   }
+}
+
+int ModelBatch::VerletRebuilds(int r) const
+{
+   return builders_.at(r).VerletRebuilds();
+}
+
+void ModelBatch::Reflect(int k)
+{
+   // Same arithmetic as AgentStore::Reflect().
+   while(x_[k] < (-arena_size_ / 2) || x_[k] > (arena_size_ / 2)
+         || y_[k] < (-arena_size_ / 2) || y_[k] > (arena_size_ / 2))
+   {
+      double new_x = x_[k];
+      double new_y = y_[k];
+      if(x_[k] > arena_size_/2) {
+         new_x = arena_size_/2 - (x_[k] - arena_size_ / 2);
+         heading_[k] = Heading(M_PI) - heading_[k];
+      }
+      else if(x_[k] < -arena_size_/2) {
+         new_x = -arena_size_/2 - (x_[k] + arena_size_ / 2);
+         heading_[k] = Heading(M_PI) - heading_[k];
+      }
+
+      if(y_[k] > arena_size_/2) {
+         new_y = arena_size_/2 - (y_[k] - arena_size_/2);
+         heading_[k] = Heading(2*M_PI) - heading_[k];
+      }
+      else if(y_[k] < -arena_size_/2) {
+         new_y = -arena_size_/2 - (y_[k] + arena_size_/2);
+         heading_[k] = Heading(2*M_PI) - heading_[k];
+      }
+
+      x_[k] = new_x;
+      y_[k] = new_y;
+   }
+}
+
+void ModelBatch::Move()
+{
+   const int    n    = x_.size();
+   const int    K    = num_replicas_;
+   const double half = arena_size_ / 2;
+   dx_.resize(n);
+   dy_.resize(n);
+   out_of_bounds_.resize(n);
+
+   double*              x      = x_.data();
+   double*              y      = y_.data();
+   double*              dx     = dx_.data();
+   double*              dy     = dy_.data();
+   unsigned char*       out    = out_of_bounds_.data();
+   const unsigned char* active = active_.data();
+
+   // Stopped replicas move by zero and are never out of bounds, which
+   // keeps these loops free of branches.
+   for(int k = 0; k < n; k++)
+   {
+      double h = heading_[k].Radians();
+      double s = active[k % K] ? speed_ : 0.0;
+      dx[k] = s * cos(h);
+      dy[k] = s * sin(h);
+   }
+
+   for(int k = 0; k < n; k++)
+   {
+      x[k] = x[k] + dx[k];
+      y[k] = y[k] + dy[k];
+   }
+
+   for(int k = 0; k < n; k++)
+   {
+      out[k] = (x[k] < -half) | (x[k] > half) | (y[k] < -half) | (y[k] > half);
+   }
+
+   for(int k = 0; k < n; k++)
+   {
+      if(out[k])
+      {
+         Reflect(k);
+      }
+   }
+
+   // A plain MovementRule never turns, so skip the draws and calls.
+   for(int i = 0; i < num_agents_ && !straight_; i++)
+   {
+      for(int r = 0; r < K; r++)
+      {
+         int k = Index(i, r);
+         if(active[r] && !dark_[k])
+         {
+            Philox gen(seeds_[r], i, steps_[r], AgentStore::MovementStream);
+            heading_[k] = movement_rules_[k]->Turn(Point(x[k], y[k]), heading_[k], gen);
+         }
+      }
+   }
+
+   for(int i = 0; i < num_agents_; i++)
+   {
+      for(int r = 0; r < K; r++)
+      {
+         int k = Index(i, r);
+         if(!active[r])
+         {
+            continue;
+         }
+         Philox gen(seeds_[r], i, steps_[r], AgentStore::ModeStream);
+         if(!dark_[k] && go_dark_(gen))
+         {
+            dark_[k] = true;
+         }
+         else if(dark_[k] && go_interactive_(gen))
+         {
+            dark_[k] = false;
+         }
+      }
+   }
+}
+
+std::shared_ptr<NetworkSnapshot> ModelBatch::NextNetwork(int r)
+{
+   std::vector<Point>& positions = positions_[r];
+   positions.clear();
+   for(int i = 0; i < num_agents_; i++)
+   {
+      positions.push_back(Point(x_[Index(i, r)], y_[Index(i, r)]));
+   }
+   return builders_[r].Build(positions);
+}
+
+int ModelBatch::UpdateStates(const Rule* rule, int r)
+{
+   const NetworkSnapshot& network = *NextNetwork(r);
+
+   // Neighbors are looked up at random, and in the batch layout each
+   // lookup would touch its own cache line, so copy the replica's
+   // states and modes out first.
+   std::vector<int>&           states = replica_states_[r];
+   std::vector<unsigned char>& dark   = replica_dark_[r];
+   states.resize(num_agents_);
+   dark.resize(num_agents_);
+   for(int i = 0; i < num_agents_; i++)
+   {
+      states[i] = states_[Index(i, r)];
+      dark[i]   = dark_[Index(i, r)];
+   }
+
+   // Same as Model::Update() with counter-based streams.
+   bool              totalistic      = rule->IsTotalistic();
+   std::vector<int>& neighbor_states = neighbor_states_[r];
+   int               change          = 0;
+   for(int a = 0; a < num_agents_; a++)
+   {
+      int k = Index(a, r);
+      if(dark[a])
+      {
+         new_states_[k] = states[a];
+         continue;
+      }
+
+      Philox gen(seeds_[r], a, steps_[r], AgentStore::NoiseStream);
+      int ones  = 0;
+      int total = 0;
+      neighbor_states.clear();
+      for(int n : network.GetNeighbors(a))
+      {
+         if(dark[n])
+         {
+            continue;
+         }
+
+         int state;
+         if(noise_probability_ == 0.0)
+         {
+            // no draw can flip a state, as in Model.
+            state = states[n];
+         }
+         else if(noise_probability_ < 0.0)
+         {
+            if(noise_(gen))
+            {
+               continue;
+            }
+            state = states[n];
+         }
+         else
+         {
+            state = noise_(gen) ? 1 - states[n] : states[n];
+         }
+         ones += state;
+         total++;
+         if(!totalistic)
+         {
+            neighbor_states.push_back(state);
+         }
+      }
+
+      std::pair<int, double> update = totalistic
+         ? rule->ApplyCount(states[a], ones, total)
+         : rule->Apply(states[a], neighbor_states);
+      new_states_[k] = update.first;
+      heading_[k]    = heading_[k] + Heading(update.second);
+      change        += update.first - states[a];
+   }
+   return change;
+}
+
+void ModelBatch::Step(const Rule* rule)
+{
+   Move();
+
+   // Each task only touches the lanes of its own replica.
+   new_states_.resize(states_.size());
+   thread_pool_->Run(num_replicas_, [this, rule](int r)
+                     {
+                        if(active_[r])
+                        {
+                           ones_[r] += UpdateStates(rule, r);
+                        }
+                     });
+
+   const int n = states_.size();
+   for(int k = 0; k < n; k++)
+   {
+      if(active_[k % num_replicas_])
+      {
+         states_[k] = new_states_[k];
+      }
+   }
+
+   for(int r = 0; r < num_replicas_; r++)
+   {
+      if(active_[r])
+      {
+         steps_[r]++;
+         stats_[r].PushCount(ones_[r], builders_[r].Network());
+      }
+   }
+}
+
+std::vector<int> ModelBatch::Run(const Rule* rule, int max_time,
+                                 std::function<bool(const ModelStats&)> early_stop)
+{
+   for(int t = 0; t < max_time && NumActive() > 0; t++)
+   {
+      for(int r = 0; r < num_replicas_; r++)
+      {
+         if(active_[r] && early_stop(stats_[r]))
+         {
+            Stop(r);
+         }
+      }
+      if(NumActive() > 0)
+      {
+         Step(rule);
+      }
+   }
+   return steps_;
+}
+
+void ModelBatch::Stop(int r)
+{
+   active_.at(r) = false;
+}
+
+bool ModelBatch::IsActive(int r) const
+{
+   return active_.at(r);
+}
+
+int ModelBatch::NumActive() const
+{
+   int active = 0;
+   for(unsigned char a : active_)
+   {
+      active += a;
+   }
+   return active;
+}
+
+int ModelBatch::Steps(int r) const
+{
+   return steps_.at(r);
+}
+
+const ModelStats& ModelBatch::GetStats(int r) const
+{
+   return stats_.at(r);
+}
+
+double ModelBatch::CurrentDensity(int r) const
+{
+   return (double)CurrentOnes(r) / num_agents_;
+}
+
+int ModelBatch::CurrentOnes(int r) const
+{
+   return ones_.at(r);
+}
+
+std::vector<int> ModelBatch::GetStates(int r) const
+{
+   if(r < 0 || r >= num_replicas_)
+   {
+      throw std::out_of_range("ModelBatch::GetStates: no such replica");
+   }
+   std::vector<int> states(num_agents_);
+   for(int i = 0; i < num_agents_; i++)
+   {
+      states[i] = states_[Index(i, r)];
+   }
+   return states;
+}
+
+std::vector<Point> ModelBatch::Positions(int r) const
+{
+   if(r < 0 || r >= num_replicas_)
+   {
+      throw std::out_of_range("ModelBatch::Positions: no such replica");
+   }
+   std::vector<Point> positions;
+   positions.reserve(num_agents_);
+   for(int i = 0; i < num_agents_; i++)
+   {
+      positions.push_back(Point(x_[Index(i, r)], y_[Index(i, r)]));
+   }
+   return positions;
+}
+
+std::vector<Heading> ModelBatch::Headings(int r) const
+{
+   if(r < 0 || r >= num_replicas_)
+   {
+      throw std::out_of_range("ModelBatch::Headings: no such replica");
+   }
+   std::vector<Heading> headings;
+   headings.reserve(num_agents_);
+   for(int i = 0; i < num_agents_; i++)
+   {
+      headings.push_back(heading_[Index(i, r)]);
+   }
+   return headings;
+}
@@ -1,21 +1,91 @@
 #include "ModelStats.hpp"
 
 #include <cmath>
+#include <algorithm> // std::min, std::max
+
+#include "Serialize.hpp"
+
+const int ModelStats::DEFAULT_WINDOW;
 
 ModelStats::ModelStats(int num_agents) :
-   _aggregate_network(num_agents)
+   _aggregate_network(num_agents),
+   _num_agents(num_agents)
 {}
 
 ModelStats::~ModelStats() {}
 
+void ModelStats::CheckNotStreaming(const char* what) const
+{
+   if(_streaming)
+   {
+      throw std::logic_error(std::string(what) + " is not kept by streaming ModelStats");
+   }
+}
+
+void ModelStats::PushCount(int ones, std::shared_ptr<NetworkSnapshot> snapshot)
+{
+   PushState((double)ones / _num_agents, snapshot);
+   _current_ones = ones;
+   _consensus    = (ones == 0 || ones == _num_agents);
+}
+
 void ModelStats::PushState(double density, std::shared_ptr<NetworkSnapshot> snapshot)
 {
-   if(!_network_summary_only) {
-      _network.AppendSnapshot(snapshot);
+   _current_ones = lround(density * _num_agents);
+   _consensus    = (density == 0.0 || density == 1.0);
+   if(_elapsed_time == 0)
+   {
+      _first_density = density;
+      _min_density   = density;
+      _max_density   = density;
+      _density_sum   = 0;
    }
-   _aggregate_network.Union(*snapshot);
-   _network_density.push_back(_aggregate_network.Density());
-   _ca_density.push_back(density);
+   _min_density  = std::min(_min_density, density);
+   _max_density  = std::max(_max_density, density);
+   _density_sum += density;
+   if(density == 0.0 && _first_zero < 0)
+   {
+      _first_zero = _elapsed_time;
+   }
+   if(density == 1.0 && _first_one < 0)
+   {
+      _first_one = _elapsed_time;
+   }
+
+   if(_streaming)
+   {
+      if(_ca_density.size() < _window)
+      {
+         _ca_density.push_back(density);
+      }
+      else
+      {
+         _ca_density[_elapsed_time % _window] = density;
+      }
+   }
+   else
+   {
+      if(!_network_summary_only) {
+         _network.AppendSnapshot(snapshot);
+      }
+      _aggregate_network.Add(*snapshot);
+      _network_density.push_back(_aggregate_network.Density());
+      _ca_density.push_back(density);
+   }
+   _elapsed_time++;
+}
+
+void ModelStats::Clear()
+{
+   _network = Network();
+   _ca_density.clear();
+   _network_density.clear();
+   _aggregate_network.Clear();
+   _current_ones = 0;
+   _consensus    = false;
+   _elapsed_time = 0;
+   _first_zero   = -1;
+   _first_one    = -1;
 }
 
 void ModelStats::NetworkSummaryOnly()
@@ -23,69 +93,229 @@ void ModelStats::NetworkSummaryOnly()
    _network_summary_only = true;
 }
 
+void ModelStats::Streaming(int window)
+{
+   if(window < 3)
+   {
+      throw std::invalid_argument("ModelStats::Streaming: window must be at least 3");
+   }
+   if(_streaming)
+   {
+      return;
+   }
+
+   // keep the last window densities, each at its slot in the ring.
+   std::vector<double> recent(std::min<unsigned int>(_elapsed_time, window));
+   for(unsigned int t = _elapsed_time - recent.size(); t < _elapsed_time; t++)
+   {
+      recent[t % window] = _ca_density[t];
+   }
+   _ca_density.swap(recent);
+
+   std::vector<double>().swap(_network_density);
+   _network           = Network();
+   _aggregate_network = AggregateNetwork(0);
+   _network_summary_only = true;
+   _streaming            = true;
+   _window               = window;
+}
+
+bool ModelStats::IsStreaming() const
+{
+   return _streaming;
+}
+
+void ModelStats::Reserve(int steps)
+{
+   if(_streaming)
+   {
+      return;
+   }
+   _ca_density.reserve(_ca_density.size() + steps);
+   _network_density.reserve(_network_density.size() + steps);
+   if(!_network_summary_only)
+   {
+      _network.Reserve(steps);
+   }
+}
+
 const Network& ModelStats::GetNetwork() const
 {
+   CheckNotStreaming("the network");
    return _network;
 }
 
 unsigned int ModelStats::ElapsedTime() const
 {
-   return _network.Size();
+   return _elapsed_time;
 }
 
 bool ModelStats::IsCorrect() const
 {
-   if(_ca_density.size() == 0)
+   if(_elapsed_time == 0)
    {
       return false;
    }
-   else if(_ca_density[0] >= 0.5)
+   else if(_first_density >= 0.5)
    {
-      return _ca_density.back() == 1.0;
+      return CurrentCADensity() == 1.0;
    }
    else
    {
-      return _ca_density.back() == 0.0;
+      return CurrentCADensity() == 0.0;
    }
 }
 
 bool ModelStats::IsSynchronized() const
 {
-   if(_ca_density.size() < 2)
+   if(_elapsed_time < 3)
    {
       return false;
    }
 
-   return _ca_density.back() == 1 - *(_ca_density.rbegin()+1)
-      && _ca_density.back() == *(_ca_density.rbegin()+2);
+   return RecentCADensity(0) == 1 - RecentCADensity(1)
+      && RecentCADensity(0) == RecentCADensity(2);
 }
 
 const std::vector<double>& ModelStats::GetDensityHistory() const
 {
+   CheckNotStreaming("the density history");
    return _ca_density;
 }
 
 std::vector<double> ModelStats::AggregateDensityHistory() const
 {
+   CheckNotStreaming("the aggregate density history");
    return _network_density;
 }
 
 double ModelStats::AverageAggregateDegree() const
 {
+   CheckNotStreaming("the aggregate network");
    return _aggregate_network.AverageDegree();
 }
 
 double ModelStats::AggregateDegreeStdDev() const
 {
+   CheckNotStreaming("the aggregate network");
    return sqrt(_aggregate_network.DegreeVariance());
 }
 
 double ModelStats::MedianAggregateDegree() const
 {
+   CheckNotStreaming("the aggregate network");
    return _aggregate_network.MedianDegree();
 }
 
 double ModelStats::CurrentCADensity() const
 {
-   return _ca_density.back();
+   return RecentCADensity(0);
+}
+
+int ModelStats::CurrentOnes() const
+{
+   return _current_ones;
+}
+
+bool ModelStats::IsConsensus() const
+{
+   return _consensus;
+}
+
+double ModelStats::RecentCADensity(int k) const
+{
+   if(k < 0 || k >= _elapsed_time || (_streaming && k >= _window))
+   {
+      throw std::out_of_range("ModelStats::RecentCADensity");
+   }
+
+   unsigned int t = _elapsed_time - 1 - k;
+   return _streaming ? _ca_density[t % _window] : _ca_density[t];
+}
+
+double ModelStats::InitialCADensity() const
+{
+   if(_elapsed_time == 0)
+   {
+      throw std::out_of_range("ModelStats::InitialCADensity");
+   }
+   return _first_density;
+}
+
+double ModelStats::MinCADensity() const
+{
+   return _elapsed_time == 0 ? 0.0 : _min_density;
+}
+
+double ModelStats::MaxCADensity() const
+{
+   return _elapsed_time == 0 ? 0.0 : _max_density;
+}
+
+double ModelStats::MeanCADensity() const
+{
+   return _elapsed_time == 0 ? 0.0 : _density_sum / _elapsed_time;
+}
+
+int ModelStats::FirstPassageTime(int state) const
+{
+   return state == 0 ? _first_zero : _first_one;
+}
+
+void ModelStats::Save(std::ostream& out) const
+{
+   serialize::WriteTag(out, "LCASTATS");
+   serialize::Write<std::uint8_t>(out, _network_summary_only);
+   serialize::Write<std::uint8_t>(out, _streaming);
+   serialize::Write<std::int32_t>(out, _window);
+   serialize::Write<std::uint32_t>(out, _elapsed_time);
+   serialize::Write(out, _first_density);
+   serialize::Write(out, _min_density);
+   serialize::Write(out, _max_density);
+   serialize::Write(out, _density_sum);
+   serialize::Write<std::int32_t>(out, _first_zero);
+   serialize::Write<std::int32_t>(out, _first_one);
+   serialize::Write<std::int32_t>(out, _num_agents);
+   serialize::Write<std::int32_t>(out, _current_ones);
+   serialize::Write<std::uint8_t>(out, _consensus);
+   serialize::WriteVector(out, _ca_density);
+   serialize::WriteVector(out, _network_density);
+   _aggregate_network.Save(out);
+
+   serialize::Write<std::uint32_t>(out, _network.Size());
+   for(unsigned int t = 0; t < _network.Size(); t++)
+   {
+      std::shared_ptr<NetworkSnapshot> snapshot = _network.GetSnapshot(t);
+      serialize::Write<std::int32_t>(out, snapshot->Size());
+      serialize::WriteEdges(out, *snapshot);
+   }
+}
+
+void ModelStats::Load(std::istream& in)
+{
+   serialize::ReadTag(in, "LCASTATS");
+   _network_summary_only = serialize::Read<std::uint8_t>(in);
+   _streaming            = serialize::Read<std::uint8_t>(in);
+   _window               = serialize::Read<std::int32_t>(in);
+   _elapsed_time         = serialize::Read<std::uint32_t>(in);
+   _first_density        = serialize::Read<double>(in);
+   _min_density          = serialize::Read<double>(in);
+   _max_density          = serialize::Read<double>(in);
+   _density_sum          = serialize::Read<double>(in);
+   _first_zero           = serialize::Read<std::int32_t>(in);
+   _first_one            = serialize::Read<std::int32_t>(in);
+   _num_agents           = serialize::Read<std::int32_t>(in);
+   _current_ones         = serialize::Read<std::int32_t>(in);
+   _consensus            = serialize::Read<std::uint8_t>(in);
+   _ca_density           = serialize::ReadVector<double>(in);
+   _network_density      = serialize::ReadVector<double>(in);
+   _aggregate_network.Load(in);
+
+   _network = Network();
+   unsigned int snapshots = serialize::Read<std::uint32_t>(in);
+   for(unsigned int t = 0; t < snapshots; t++)
+   {
+      int num_vertices = serialize::Read<std::int32_t>(in);
+      _network.AppendSnapshot(std::make_shared<NetworkSnapshot>(num_vertices, serialize::ReadEdges(in)));
+   }
 }
@@ -2,39 +2,87 @@
 
 #include <cmath> // M_PI
 
+namespace
+{
+   /**
+    * The weights of k = 1..max_step-1 steps between turns: the mass of
+    * a continuous power law with exponent mu on [k, k+1).
+    */
+   std::vector<double> power_law_weights(double mu, int max_step)
+   {
+      std::vector<double> weights;
+      for(int k = 1; k < max_step; k++)
+      {
+         if(mu == 1.0)
+         {
+            weights.push_back(log((k + 1.0) / k));
+         }
+         else
+         {
+            weights.push_back(fabs(pow(k + 1.0, 1 - mu) - pow((double)k, 1 - mu)));
+         }
+      }
+      if(weights.empty())
+      {
+         weights.push_back(1.0); // max_step <= 1 always gives one step
+      }
+      return weights;
+   }
+}
+
 LevyWalk::LevyWalk(double mu, int max_step) :
    mu(mu),
    max_step(max_step),
    next_turn(0),
    current_time(0),
-   heading_distribution(0, 2*M_PI)
+   step_length(std::make_shared<AliasTable>(power_law_weights(mu, max_step)))
 {}
 
 LevyWalk::~LevyWalk() {}
 
-int gen_power_law(double mu, int max_step, std::mt19937_64& gen)
+Heading LevyWalk::Turn(const Point&     current_position,
+                       const Heading&   current_heading,
+                       std::mt19937_64& gen)
 {
-   std::uniform_real_distribution<double> u(0.0,1.0);
-   double pmin = powf(1.0, -mu+1);
-   double pmax = powf((double)max_step, -mu+1);
-   double z    = powf((pmax - pmin)*u(gen) + pmin, 1.0/(-mu+1));
-   return floor(z);
+   return TurnWith(current_time, next_turn, *step_length, current_heading, gen);
 }
 
 Heading LevyWalk::Turn(const Point&     current_position,
                        const Heading&   current_heading,
-                       std::mt19937_64& gen)
+                       Philox&          gen)
 {
-   current_time++;
-   if(current_time >= next_turn)
-   {
-      next_turn = current_time+gen_power_law(mu, max_step, gen);
-      return Heading(heading_distribution(gen));
-   }
-   else
-   {
-      return current_heading;
-   }
+   return TurnWith(current_time, next_turn, *step_length, current_heading, gen);
+}
+
+std::shared_ptr<const AliasTable> LevyWalk::StepLength() const
+{
+   return step_length;
+}
+
+double LevyWalk::Mu() const
+{
+   return mu;
+}
+
+int LevyWalk::MaxStep() const
+{
+   return max_step;
+}
+
+unsigned int LevyWalk::CurrentTime() const
+{
+   return current_time;
+}
+
+unsigned int LevyWalk::NextTurn() const
+{
+   return next_turn;
+}
+
+void LevyWalk::SetTurnState(unsigned int current_time, unsigned int next_turn)
+{
+   this->current_time = current_time;
+   this->next_turn    = next_turn;
 }
 
 std::shared_ptr<MovementRule> LevyWalk::Clone() const
@@ -42,14 +90,21 @@ std::shared_ptr<MovementRule> LevyWalk::Clone() const
    return std::make_shared<LevyWalk>(*this);
 }
 
-RandomWalk::RandomWalk() : heading_distribution(0, 2*M_PI) {}
+RandomWalk::RandomWalk() {}
 RandomWalk::~RandomWalk() {}
 
 Heading RandomWalk::Turn(const Point& current_position,
                          const Heading& current_heading,
                          std::mt19937_64& gen)
 {
-   return Heading(heading_distribution(gen));
+   return TurnWith(gen);
+}
+
+Heading RandomWalk::Turn(const Point& current_position,
+                         const Heading& current_heading,
+                         Philox& gen)
+{
+   return TurnWith(gen);
 }
 
 std::shared_ptr<MovementRule> RandomWalk::Clone() const
@@ -67,8 +122,19 @@ Heading CorrelatedRandomWalk::Turn(const Point& current_position,
                   const Heading& current_heading,
                   std::mt19937_64& gen)
 {
-   std::normal_distribution<double> heading_rv(current_heading.Radians(), _sigma);
-   return Heading(heading_rv(gen));
+   return TurnWith(current_heading, _sigma, gen);
+}
+
+Heading CorrelatedRandomWalk::Turn(const Point& current_position,
+                  const Heading& current_heading,
+                  Philox& gen)
+{
+   return TurnWith(current_heading, _sigma, gen);
+}
+
+double CorrelatedRandomWalk::Sigma() const
+{
+   return _sigma;
 }
 
 std::shared_ptr<MovementRule> CorrelatedRandomWalk::Clone() const
@@ -1,56 +1,151 @@
 #include "Network.hpp"
 
 #include <algorithm>
+#include <iterator> // std::back_inserter
 
 /// NetworkSnapshot functions
 
 NetworkSnapshot::NetworkSnapshot(int num_vertices) :
    _num_vertices(num_vertices),
-   _adjacency_list(num_vertices)
+   _offsets(num_vertices + 1, 0)
 {}
 
+NetworkSnapshot::NetworkSnapshot(int num_vertices, const std::vector<std::pair<int,int>>& edges) :
+   _num_vertices(num_vertices)
+{
+   SetEdges(edges);
+}
+
 NetworkSnapshot::~NetworkSnapshot() {}
 
-void NetworkSnapshot::AddEdge(int i, int j)
+void NetworkSnapshot::CheckEdge(int i, int j) const
 {
-   // reject invalid input
    if(i == j || i < 0 || j < 0 || i >= _num_vertices || j >= _num_vertices)
    {
       throw(std::out_of_range("NetworkSnapshot::AddEdge()"));
    }
-   else
+}
+
+void NetworkSnapshot::Build(const std::vector<std::pair<int,int>>& edges) const
+{
+   // counting sort of the edge endpoints by vertex.
+   _offsets.assign(_num_vertices + 1, 0);
+   for(auto& e : edges)
+   {
+      _offsets[e.first + 1]++;
+      _offsets[e.second + 1]++;
+   }
+   for(int v = 0; v < _num_vertices; v++)
    {
-      _adjacency_list[i].insert(j);
-      _adjacency_list[j].insert(i);
+      _offsets[v + 1] += _offsets[v];
    }
+
+   _neighbors.resize(_offsets[_num_vertices]);
+   _cursor.assign(_offsets.begin(), _offsets.end() - 1);
+   for(auto& e : edges)
+   {
+      _neighbors[_cursor[e.first]++]  = e.second;
+      _neighbors[_cursor[e.second]++] = e.first;
+   }
+
+   // sort each neighbor list and squeeze out duplicate edges.
+   int out = 0;
+   for(int v = 0; v < _num_vertices; v++)
+   {
+      auto first = _neighbors.begin() + _offsets[v];
+      auto last  = _neighbors.begin() + _offsets[v + 1];
+      std::sort(first, last);
+      auto unique_last = std::unique(first, last);
+      _offsets[v] = out;
+      out = std::copy(first, unique_last, _neighbors.begin() + out) - _neighbors.begin();
+   }
+   _offsets[_num_vertices] = out;
+   _neighbors.resize(out);
 }
 
-double NetworkSnapshot::Density() const
+void NetworkSnapshot::Compact() const
+{
+   if(_pending.empty())
+   {
+      return;
+   }
+
+   for(int u = 0; u < _num_vertices; u++)
+   {
+      for(int k = _offsets[u]; k < _offsets[u + 1]; k++)
+      {
+         if(u < _neighbors[k])
+         {
+            _pending.push_back(std::make_pair(u, _neighbors[k]));
+         }
+      }
+   }
+   Build(_pending);
+   _pending.clear();
+}
+
+void NetworkSnapshot::SetEdges(const std::vector<std::pair<int,int>>& edges)
 {
-   double n = 0;
-   for(auto& v : _adjacency_list)
+   for(auto& e : edges)
    {
-      n += v.size();
+      CheckEdge(e.first, e.second);
    }
+   _pending.clear();
+   Build(edges);
+}
+
+void NetworkSnapshot::SetAdjacency(const BitMatrix& adjacency)
+{
+   if(adjacency.Size() != _num_vertices)
+   {
+      throw std::invalid_argument("NetworkSnapshot::SetAdjacency: wrong size");
+   }
+   _pending.clear();
+   _neighbors.clear();
+   _offsets.resize(_num_vertices + 1);
+   _offsets[0] = 0;
+   for(int v = 0; v < _num_vertices; v++)
+   {
+      const std::uint64_t* row = adjacency.Row(v);
+      for(int w = 0; w < adjacency.WordsPerRow(); w++)
+      {
+         for(std::uint64_t bits = row[w]; bits != 0; bits &= bits - 1)
+         {
+            _neighbors.push_back(64 * w + __builtin_ctzll(bits));
+         }
+      }
+      _offsets[v + 1] = _neighbors.size();
+   }
+}
+
+void NetworkSnapshot::AddEdge(int i, int j)
+{
+   // reject invalid input
+   CheckEdge(i, j);
+   _pending.push_back(std::make_pair(i, j));
+}
+
+double NetworkSnapshot::Density() const
+{
+   Compact();
+   double n = _neighbors.size();
    return n / (_num_vertices * (_num_vertices-1)); // XXX
 }
 
-std::set<int> NetworkSnapshot::GetNeighbors(int v) const
+NeighborView NetworkSnapshot::GetNeighbors(int v) const
 {
    if(v < 0 || v >= _num_vertices)
    {
       throw std::out_of_range("Network::GetNeighbors");
    }
-   return _adjacency_list[v];
+   Compact();
+   return NeighborView(_neighbors.data() + _offsets[v], _neighbors.data() + _offsets[v + 1]);
 }
 
 double NetworkSnapshot::AverageDegree() const
 {
-   unsigned int total_degree = 0;
-   for(auto& adjacencies : _adjacency_list)
-   {
-      total_degree += adjacencies.size();
-   }
+   Compact();
+   unsigned int total_degree = _neighbors.size();
    return (double)total_degree / _num_vertices;
 }
 
@@ -58,9 +153,9 @@ double NetworkSnapshot::DegreeVariance() const
 {
    double avg = AverageDegree();
    double variance = 0.0;
-   for(auto adjacencies : _adjacency_list)
+   for(int v = 0; v < _num_vertices; v++)
    {
-      variance += (avg - adjacencies.size())*(avg - adjacencies.size());
+      variance += (avg - Degree(v))*(avg - Degree(v));
    }
    return variance/_num_vertices;
 }
@@ -68,9 +163,9 @@ double NetworkSnapshot::DegreeVariance() const
 double NetworkSnapshot::MedianDegree() const
 {
    std::vector<unsigned int> degrees;
-   for(auto adjacencies : _adjacency_list)
+   for(int v = 0; v < _num_vertices; v++)
    {
-      degrees.push_back(adjacencies.size());
+      degrees.push_back(Degree(v));
    }
    std::sort(degrees.begin(), degrees.end());
 
@@ -89,9 +184,9 @@ std::vector<unsigned int> NetworkSnapshot::DegreeDistribution() const
 {
    std::vector<unsigned int> degree_distribution(_num_vertices);
    std::fill(degree_distribution.begin(), degree_distribution.end(), 0);
-   for(auto& al : _adjacency_list)
+   for(int v = 0; v < _num_vertices; v++)
    {
-      unsigned int degree = al.size();
+      unsigned int degree = Degree(v);
       degree_distribution[degree] += 1;
    }
    return degree_distribution;
@@ -109,36 +204,47 @@ std::vector<double> NetworkSnapshot::NormalizedDegreeDistribution() const
 
 int NetworkSnapshot::EdgeCount() const
 {
-   int n = 0;
-   for(auto& al : _adjacency_list)
-   {
-      n += al.size();
-   }
-   return n / 2;
+   Compact();
+   return _neighbors.size() / 2;
 }
 
 void NetworkSnapshot::Union(const NetworkSnapshot& s)
 {
-   for(int i = 0; i < _adjacency_list.size(); i++)
+   Compact();
+   s.Compact();
+
+   std::vector<int> offsets(_num_vertices + 1, 0);
+   std::vector<int> neighbors;
+   neighbors.reserve(std::max(_neighbors.size(), s._neighbors.size()));
+   for(int v = 0; v < _num_vertices; v++)
    {
-      _adjacency_list[i].insert(s._adjacency_list[i].begin(),
-                                s._adjacency_list[i].end());
+      offsets[v] = neighbors.size();
+      std::set_union(_neighbors.begin() + _offsets[v], _neighbors.begin() + _offsets[v + 1],
+                     s._neighbors.begin() + s._offsets[v], s._neighbors.begin() + s._offsets[v + 1],
+                     std::back_inserter(neighbors));
    }
+   offsets[_num_vertices] = neighbors.size();
+
+   _offsets.swap(offsets);
+   _neighbors.swap(neighbors);
 }
 
 int NetworkSnapshot::Size() const
 {
-   return _adjacency_list.size();
+   return _num_vertices;
 }
 
 int NetworkSnapshot::Degree(int v) const
 {
-   return _adjacency_list[v].size();
+   Compact();
+   return _offsets[v + 1] - _offsets[v];
 }
 
 bool operator== (const NetworkSnapshot& s, const NetworkSnapshot& g)
 {
-   return s._adjacency_list == g._adjacency_list;
+   s.Compact();
+   g.Compact();
+   return s._offsets == g._offsets && s._neighbors == g._neighbors;
 }
 
 std::ostream& operator<< (std::ostream& out, const NetworkSnapshot& s)
@@ -146,10 +252,10 @@ std::ostream& operator<< (std::ostream& out, const NetworkSnapshot& s)
    // output the snapshot as dot.
    out << "graph {" << std::endl
        << "  node[shape=point,label=\"\"]" << std::endl;
-   for(int u = 0; u < s._adjacency_list.size(); u++)
+   for(int u = 0; u < s.Size(); u++)
    {
       out << "  " << u << std::endl;
-      for(int v : s._adjacency_list[u])
+      for(int v : s.GetNeighbors(u))
       {
          if(u < v) {
             out << "  " << u << " -- " << v << std::endl;
@@ -170,6 +276,11 @@ void Network::AppendSnapshot(std::shared_ptr<NetworkSnapshot> snapshot)
    _snapshots.push_back(snapshot);
 }
 
+void Network::Reserve(int n)
+{
+   _snapshots.reserve(_snapshots.size() + n);
+}
+
 std::shared_ptr<NetworkSnapshot> Network::GetSnapshot(unsigned int t) const
 {
    if(t > _snapshots.size())
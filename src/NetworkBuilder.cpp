@@ -0,0 +1,198 @@
+#include "NetworkBuilder.hpp"
+#include "Proximity.hpp"
+
+NetworkBuilder::NetworkBuilder(double arena_size, double range, double verlet_skin) :
+   arena_size_(arena_size),
+   range_(range),
+   method_(Method::CellList),
+   cells_(arena_size, range),
+   verlet_(arena_size, range, verlet_skin),
+   keep_adjacency_(false),
+   adjacency_current_(false)
+{}
+
+NetworkBuilder::~NetworkBuilder() {}
+
+void NetworkBuilder::SetMethod(Method method)
+{
+   method_ = method;
+}
+
+NetworkBuilder::Method NetworkBuilder::GetMethod() const
+{
+   return method_;
+}
+
+void NetworkBuilder::SetVerletSkin(double skin)
+{
+   verlet_ = VerletList(arena_size_, range_, skin);
+}
+
+int NetworkBuilder::VerletRebuilds() const
+{
+   return verlet_.Rebuilds();
+}
+
+void NetworkBuilder::Clear()
+{
+   verlet_.Clear();
+}
+
+void NetworkBuilder::UpdateAdjacency(bool incremental, int num_points)
+{
+   const int words = (num_points + 63) / 64;
+   if(2 * (long long)pairs_.size() < (long long)ADJACENCY_DEGREE_PER_WORD * words * num_points)
+   {
+      adjacency_current_ = false;
+      return;
+   }
+
+   if(incremental && adjacency_current_ && adjacency_.Size() == num_points)
+   {
+      for(const std::pair<int,int>& pair : left_)
+      {
+         adjacency_.Reset(pair.first, pair.second);
+         adjacency_.Reset(pair.second, pair.first);
+      }
+      for(const std::pair<int,int>& pair : entered_)
+      {
+         adjacency_.Set(pair.first, pair.second);
+         adjacency_.Set(pair.second, pair.first);
+      }
+      return;
+   }
+
+   if(adjacency_.Size() != num_points)
+   {
+      adjacency_ = BitMatrix(num_points);
+   }
+   else
+   {
+      adjacency_.Clear();
+   }
+   for(const std::pair<int,int>& pair : pairs_)
+   {
+      adjacency_.Set(pair.first, pair.second);
+      adjacency_.Set(pair.second, pair.first);
+   }
+   adjacency_current_ = true;
+}
+
+void NetworkBuilder::DropAdjacency()
+{
+   if(adjacency_.Size() != 0)
+   {
+      adjacency_ = BitMatrix();
+   }
+   adjacency_current_ = false;
+}
+
+std::shared_ptr<NetworkSnapshot> NetworkBuilder::Build(const std::vector<Point>& points)
+{
+   if(method_ == Method::Verlet && keep_adjacency_)
+   {
+      bool incremental = verlet_.Changes(points, pairs_, entered_, left_);
+      UpdateAdjacency(incremental, points.size());
+      return Snapshot(points.size());
+   }
+
+   if(method_ == Method::AllPairs)
+   {
+      proximity::AllPairs(points, range_, pairs_);
+   }
+   else if(method_ == Method::Verlet)
+   {
+      verlet_.Pairs(points, pairs_);
+   }
+   else
+   {
+      cells_.Build(points);
+      cells_.Pairs(points, pairs_);
+   }
+   DropAdjacency();
+   return Snapshot(points.size());
+}
+
+std::shared_ptr<NetworkSnapshot> NetworkBuilder::Build(const std::vector<Point>& points, ThreadPool& pool)
+{
+   if(method_ == Method::Verlet && keep_adjacency_)
+   {
+      bool incremental = verlet_.Changes(points, pairs_, entered_, left_, pool);
+      UpdateAdjacency(incremental, points.size());
+      return Snapshot(points.size());
+   }
+
+   if(method_ == Method::AllPairs)
+   {
+      proximity::AllPairs(points, range_, pairs_);
+   }
+   else if(method_ == Method::Verlet)
+   {
+      verlet_.Pairs(points, pairs_, pool);
+   }
+   else
+   {
+      cells_.Build(points);
+      cells_.Pairs(points, pairs_, pool);
+   }
+   DropAdjacency();
+   return Snapshot(points.size());
+}
+
+std::shared_ptr<NetworkSnapshot> NetworkBuilder::Snapshot(int num_points)
+{
+   if(!network_ || network_.use_count() != 1 || network_->Size() != num_points)
+   {
+      network_ = std::make_shared<NetworkSnapshot>(num_points);
+   }
+   if(adjacency_current_)
+   {
+      network_->SetAdjacency(adjacency_);
+   }
+   else
+   {
+      network_->SetEdges(pairs_);
+   }
+   return network_;
+}
+
+void NetworkBuilder::KeepAdjacency(bool keep)
+{
+   keep_adjacency_ = keep;
+   if(!keep)
+   {
+      DropAdjacency();
+   }
+}
+
+const BitMatrix* NetworkBuilder::Adjacency() const
+{
+   return adjacency_current_ ? &adjacency_ : nullptr;
+}
+
+std::shared_ptr<NetworkSnapshot> NetworkBuilder::Network() const
+{
+   return network_;
+}
+
+void NetworkBuilder::SetNetwork(std::shared_ptr<NetworkSnapshot> network)
+{
+   network_           = network;
+   adjacency_current_ = false;
+}
+
+std::shared_ptr<NetworkSnapshot> NetworkBuilder::Search(const std::vector<Point>& points) const
+{
+   std::vector<std::pair<int,int>> pairs;
+   if(method_ == Method::AllPairs)
+   {
+      proximity::AllPairs(points, range_, pairs);
+   }
+   else
+   {
+      CellList cells(arena_size_, range_);
+      cells.Build(points);
+      cells.Pairs(points, pairs);
+   }
+   return std::make_shared<NetworkSnapshot>(points.size(), pairs);
+}
@@ -1,6 +1,7 @@
 #include "OneDLattice.hpp"
 #include "Point.hpp"
 #include <algorithm>
+#include <numeric> // std::accumulate
 
 OneDLattice::OneDLattice(int num_cells, int radius) :
    _lattice(num_cells),
@@ -68,28 +69,29 @@ void OneDLattice::Step(const Rule& rule)
 {
    // XXX: This is (almost) duplicate code from Model::Step
    //      - should refactor!
+   bool totalistic = rule.IsTotalistic();
    std::vector<int> new_states(_states.size());
    for(int i = 0; i < _states.size(); i++)
    {
       auto neighbors = _lattice.GetNeighbors(i);
-      std::vector<int> neighbor_states;
-      for(int n : neighbors)
+      if(totalistic)
       {
-         neighbor_states.push_back(_states[n]);
-      }
-      std::vector<Point> neighbor_positions;
-      for(int i = 0; i < neighbors.size(); i++)
-      {
-         if(i < neighbors.size()/2)
+         int ones = 0;
+         for(int n : neighbors)
          {
-            neighbor_positions.push_back(Point(-1, 0));
+            ones += _states[n];
          }
-         else
+         new_states[i] = rule.ApplyCount(_states[i], ones, neighbors.size()).first;
+      }
+      else
+      {
+         std::vector<int> neighbor_states;
+         for(int n : neighbors)
          {
-            neighbor_positions.push_back(Point(1, 0));
+            neighbor_states.push_back(_states[n]);
          }
+         new_states[i] = rule.Apply(_states[i], neighbor_states).first;
       }
-      new_states[i] = rule.Apply(_states[i], neighbor_states);
    }
    _old_states = _states;
    _states = new_states;
@@ -0,0 +1,189 @@
+#include "PackedLattice.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+const int PackedLattice::REPLICAS;
+
+PackedLattice::PackedLattice(int num_cells, int radius, bool flip) :
+   num_cells_(num_cells),
+   radius_(radius),
+   window_(std::min(2 * radius + 1, num_cells)),
+   flip_(flip),
+   steps_(0),
+   states_(num_cells, 0),
+   next_(num_cells, 0),
+   changed_(~(std::uint64_t)0)
+{
+   if(num_cells < 1 || radius < 0)
+   {
+      throw std::invalid_argument("PackedLattice");
+   }
+
+   int bits = 1;
+   while((1 << bits) <= window_)
+   {
+      bits++;
+   }
+   count_.resize(bits);
+}
+
+PackedLattice::~PackedLattice() {}
+
+int PackedLattice::NumCells() const
+{
+   return num_cells_;
+}
+
+void PackedLattice::SetDensity(double density, std::mt19937_64& gen)
+{
+   std::uniform_real_distribution<double> uniform(0.0, 1.0);
+   for(std::uint64_t& cell : states_)
+   {
+      cell = 0;
+      for(int r = 0; r < REPLICAS; r++)
+      {
+         if(uniform(gen) < density)
+         {
+            cell |= (std::uint64_t)1 << r;
+         }
+      }
+   }
+   steps_   = 0;
+   changed_ = ~(std::uint64_t)0;
+}
+
+void PackedLattice::SetStates(int replica, const std::vector<int>& states)
+{
+   if(replica < 0 || replica >= REPLICAS || states.size() != num_cells_)
+   {
+      throw std::out_of_range("PackedLattice::SetStates");
+   }
+
+   std::uint64_t bit = (std::uint64_t)1 << replica;
+   for(int i = 0; i < num_cells_; i++)
+   {
+      states_[i] = states[i] ? (states_[i] | bit) : (states_[i] & ~bit);
+   }
+   steps_   = 0;
+   changed_ = ~(std::uint64_t)0;
+}
+
+std::vector<int> PackedLattice::GetStates(int replica) const
+{
+   std::vector<int> states(num_cells_);
+   for(int i = 0; i < num_cells_; i++)
+   {
+      states[i] = (states_[i] >> replica) & 1;
+   }
+   return states;
+}
+
+int PackedLattice::Ones(int replica) const
+{
+   int ones = 0;
+   for(std::uint64_t cell : states_)
+   {
+      ones += (cell >> replica) & 1;
+   }
+   return ones;
+}
+
+double PackedLattice::GetDensity(int replica) const
+{
+   return (double)Ones(replica) / (double)num_cells_;
+}
+
+void PackedLattice::Add(std::uint64_t bits)
+{
+   // ripple-carry increment of each replica's count
+   for(std::uint64_t& plane : count_)
+   {
+      std::uint64_t carry = plane & bits;
+      plane ^= bits;
+      bits = carry;
+   }
+}
+
+void PackedLattice::Subtract(std::uint64_t bits)
+{
+   for(std::uint64_t& plane : count_)
+   {
+      std::uint64_t borrow = ~plane & bits;
+      plane ^= bits;
+      bits = borrow;
+   }
+}
+
+std::uint64_t PackedLattice::AtLeast(int c) const
+{
+   // count >= c iff count - c does not borrow.
+   std::uint64_t borrow = 0;
+   for(int b = 0; b < count_.size(); b++)
+   {
+      if((c >> b) & 1)
+      {
+         borrow = ~count_[b] | borrow;
+      }
+      else
+      {
+         borrow = ~count_[b] & borrow;
+      }
+   }
+   return (c >> count_.size()) ? 0 : ~borrow;
+}
+
+std::uint64_t PackedLattice::Equal(int c) const
+{
+   std::uint64_t equal = ~(std::uint64_t)0;
+   for(int b = 0; b < count_.size(); b++)
+   {
+      equal &= ((c >> b) & 1) ? count_[b] : ~count_[b];
+   }
+   return (c >> count_.size()) ? 0 : equal;
+}
+
+void PackedLattice::Step()
+{
+   // Same decision as MajorityRule::ApplyCount with n = ones + self
+   // and total + 1 = window_: 1 if 2n > window_, the tie rule if
+   // 2n == window_, otherwise 0.
+   const int  majority = window_ / 2 + 1;
+   const bool can_tie  = window_ % 2 == 0;
+
+   std::fill(count_.begin(), count_.end(), 0);
+   for(int k = -radius_; k < -radius_ + window_; k++)
+   {
+      Add(states_[((k % num_cells_) + num_cells_) % num_cells_]);
+   }
+
+   std::uint64_t changed = 0;
+   for(int i = 0; i < num_cells_; i++)
+   {
+      std::uint64_t self = states_[i];
+      std::uint64_t next = AtLeast(majority);
+      if(can_tie)
+      {
+         next |= Equal(window_ / 2) & (flip_ ? ~self : self);
+      }
+      next_[i] = next;
+      changed |= next ^ self;
+
+      // slide the window one cell to the right, unless it already
+      // covers the whole ring.
+      if(window_ < num_cells_)
+      {
+         Add(states_[(i + radius_ + 1) % num_cells_]);
+         Subtract(states_[((i - radius_) % num_cells_ + num_cells_) % num_cells_]);
+      }
+   }
+
+   states_.swap(next_);
+   steps_++;
+   changed_ = (steps_ <= 1) ? ~(std::uint64_t)0 : changed;
+}
+
+std::uint64_t PackedLattice::Changing() const
+{
+   return changed_;
+}
@@ -0,0 +1,190 @@
+#include "Proximity.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LCA_X86 1
+#endif
+
+namespace
+{
+   typedef int (*Kernel)(double, double, const double*, const double*, int, double, int*);
+
+   // Same arithmetic as Point::Distance() without the square root:
+   // pow(d, 2) is exactly d*d. Nothing here may be fused into an FMA,
+   // which would round differently, so none of these functions are
+   // built for a target with FMA.
+   int WithinScalar(double x, double y, const double* xs, const double* ys, int n,
+                    double squared_range, int* hits)
+   {
+      int count = 0;
+      for(int k = 0; k < n; k++)
+      {
+         double dx = xs[k] - x;
+         double dy = ys[k] - y;
+         if(dx * dx + dy * dy <= squared_range)
+         {
+            hits[count++] = k;
+         }
+      }
+      return count;
+   }
+
+#if defined(LCA_X86) && defined(__SSE2__)
+   int WithinSse2(double x, double y, const double* xs, const double* ys, int n,
+                  double squared_range, int* hits)
+   {
+      const __m128d px    = _mm_set1_pd(x);
+      const __m128d py    = _mm_set1_pd(y);
+      const __m128d limit = _mm_set1_pd(squared_range);
+
+      int count = 0;
+      int k     = 0;
+      for(; k + 2 <= n; k += 2)
+      {
+         __m128d dx   = _mm_sub_pd(_mm_loadu_pd(xs + k), px);
+         __m128d dy   = _mm_sub_pd(_mm_loadu_pd(ys + k), py);
+         __m128d d2   = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+         int     mask = _mm_movemask_pd(_mm_cmple_pd(d2, limit));
+         for(; mask != 0; mask &= mask - 1)
+         {
+            hits[count++] = k + __builtin_ctz(mask);
+         }
+      }
+      int tail = WithinScalar(x, y, xs + k, ys + k, n - k, squared_range, hits + count);
+      for(int h = count; h < count + tail; h++)
+      {
+         hits[h] += k;
+      }
+      return count + tail;
+   }
+#endif
+
+#if defined(LCA_X86) && defined(__GNUC__)
+   __attribute__((target("avx2")))
+   int WithinAvx2(double x, double y, const double* xs, const double* ys, int n,
+                  double squared_range, int* hits)
+   {
+      const __m256d px    = _mm256_set1_pd(x);
+      const __m256d py    = _mm256_set1_pd(y);
+      const __m256d limit = _mm256_set1_pd(squared_range);
+
+      int count = 0;
+      int k     = 0;
+      for(; k + 4 <= n; k += 4)
+      {
+         __m256d dx   = _mm256_sub_pd(_mm256_loadu_pd(xs + k), px);
+         __m256d dy   = _mm256_sub_pd(_mm256_loadu_pd(ys + k), py);
+         __m256d d2   = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+         int     mask = _mm256_movemask_pd(_mm256_cmp_pd(d2, limit, _CMP_LE_OQ));
+         for(; mask != 0; mask &= mask - 1)
+         {
+            hits[count++] = k + __builtin_ctz(mask);
+         }
+      }
+      int tail = WithinScalar(x, y, xs + k, ys + k, n - k, squared_range, hits + count);
+      for(int h = count; h < count + tail; h++)
+      {
+         hits[h] += k;
+      }
+      return count + tail;
+   }
+#endif
+
+   struct Selected
+   {
+      Kernel      kernel;
+      const char* name;
+   };
+
+   Selected Select()
+   {
+#if defined(LCA_X86) && defined(__GNUC__)
+      if(__builtin_cpu_supports("avx2"))
+      {
+         return {WithinAvx2, "avx2"};
+      }
+#endif
+#if defined(LCA_X86) && defined(__SSE2__)
+      return {WithinSse2, "sse2"};
+#else
+      return {WithinScalar, "scalar"};
+#endif
+   }
+
+   const Selected& Best()
+   {
+      static const Selected best = Select();
+      return best;
+   }
+}
+
+double proximity::SquaredRange(double range)
+{
+   if(!(range >= 0))
+   {
+      return -1;
+   }
+
+   double squared = range * range;
+   if(!(squared < std::numeric_limits<double>::infinity()))
+   {
+      return squared;
+   }
+
+   // sqrt is correctly rounded and so monotonic; step to the last
+   // squared distance whose root is still within range.
+   while(sqrt(squared) > range)
+   {
+      squared = nextafter(squared, 0.0);
+   }
+   while(sqrt(nextafter(squared, std::numeric_limits<double>::infinity())) <= range)
+   {
+      squared = nextafter(squared, std::numeric_limits<double>::infinity());
+   }
+   return squared;
+}
+
+int proximity::Within(double x, double y, const double* xs, const double* ys, int n,
+                      double squared_range, int* hits)
+{
+   return Best().kernel(x, y, xs, ys, n, squared_range, hits);
+}
+
+void proximity::AllPairs(const std::vector<Point>& points, double range,
+                         std::vector<std::pair<int,int>>& pairs)
+{
+   // per-thread scratch space, so repeated searches don't allocate.
+   thread_local std::vector<double> xs;
+   thread_local std::vector<double> ys;
+   thread_local std::vector<int>    hits;
+
+   const int n = points.size();
+   xs.resize(n);
+   ys.resize(n);
+   hits.resize(n);
+   for(int i = 0; i < n; i++)
+   {
+      xs[i] = points[i].GetX();
+      ys[i] = points[i].GetY();
+   }
+
+   double squared_range = SquaredRange(range);
+   pairs.clear();
+   for(int i = 0; i < n; i++)
+   {
+      int count = Within(xs[i], ys[i], xs.data() + i + 1, ys.data() + i + 1, n - i - 1,
+                         squared_range, hits.data());
+      for(int h = 0; h < count; h++)
+      {
+         pairs.push_back(std::make_pair(i, i + 1 + hits[h]));
+      }
+   }
+}
+
+const char* proximity::KernelName()
+{
+   return Best().name;
+}
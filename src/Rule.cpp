@@ -1,6 +1,19 @@
 #include "Rule.hpp"
 
-#include <numeric> // std::accumulate
+#include <numeric>   // std::accumulate
+#include <algorithm> // std::fill
+
+std::pair<int, double> Rule::ApplyCount(int self, int ones, int total) const
+{
+   std::vector<int> neighbors(total, 0);
+   std::fill(neighbors.begin(), neighbors.begin() + std::min(ones, total), 1);
+   return Apply(self, neighbors);
+}
+
+bool Rule::IsTotalistic() const
+{
+   return false;
+}
 
 Identity::Identity() {}
 Identity::~Identity() {}
@@ -10,18 +23,33 @@ std::pair<int, double> Identity::Apply(int self, const std::vector<int>& neighbo
    return std::make_pair(self, 0);
 }
 
+std::pair<int, double> Identity::ApplyCount(int self, int ones, int total) const
+{
+   return std::make_pair(self, 0);
+}
+
+bool Identity::IsTotalistic() const
+{
+   return true;
+}
+
 MajorityRule::MajorityRule() {}
 MajorityRule::MajorityRule(bool f) : flip(f) {}
 MajorityRule::~MajorityRule() {}
 
 std::pair<int, double> MajorityRule::Apply(int self, const std::vector<int>& neighbors) const
 {
-   int n = std::accumulate(neighbors.begin(), neighbors.end(), 0) + self;
-   if((double)n > ((double)neighbors.size()+1) / 2.0)
+   return ApplyCount(self, std::accumulate(neighbors.begin(), neighbors.end(), 0), neighbors.size());
+}
+
+std::pair<int, double> MajorityRule::ApplyCount(int self, int ones, int total) const
+{
+   int n = ones + self;
+   if((double)n > ((double)total+1) / 2.0)
    {
       return std::make_pair(1, 0);
    }
-   else if((double)n == (double)(neighbors.size()+1) / 2.0)
+   else if((double)n == (double)(total+1) / 2.0)
    {
       return std::make_pair(flip ? 1 - self : self, 0);
    }
@@ -31,6 +59,11 @@ std::pair<int, double> MajorityRule::Apply(int self, const std::vector<int>& nei
    }
 }
 
+bool MajorityRule::IsTotalistic() const
+{
+   return true;
+}
+
 Constant::Constant(int c) : state(c) {}
 Constant::~Constant() {}
 
@@ -39,6 +72,16 @@ std::pair<int, double> Constant::Apply(int self, const std::vector<int>& neighbo
    return std::make_pair(state, 0);
 }
 
+std::pair<int, double> Constant::ApplyCount(int self, int ones, int total) const
+{
+   return std::make_pair(state, 0);
+}
+
+bool Constant::IsTotalistic() const
+{
+   return true;
+}
+
 /**
  * Utility function to compute the density in the neighborhood
  * including self.
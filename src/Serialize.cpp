@@ -0,0 +1,75 @@
+#include "Serialize.hpp"
+#include "Network.hpp"
+
+#include <cstring> // std::memcmp
+
+void serialize::WriteTag(std::ostream& out, const char tag[8])
+{
+   out.write(tag, 8);
+}
+
+void serialize::ReadTag(std::istream& in, const char tag[8])
+{
+   char read[8];
+   if(!in.read(read, 8) || std::memcmp(read, tag, 8) != 0)
+   {
+      throw std::runtime_error("serialize::ReadTag: expected " + std::string(tag, 8));
+   }
+}
+
+void serialize::WriteString(std::ostream& out, const std::string& s)
+{
+   Write<std::uint64_t>(out, s.size());
+   out.write(s.data(), s.size());
+}
+
+std::string serialize::ReadString(std::istream& in)
+{
+   std::string s(Read<std::uint64_t>(in), '\0');
+   if(!in.read(&s[0], s.size()))
+   {
+      throw std::runtime_error("serialize::ReadString: unexpected end of stream");
+   }
+   return s;
+}
+
+void serialize::WriteEdges(std::ostream& out, const std::vector<std::pair<int,int>>& edges)
+{
+   std::vector<std::uint32_t> ends;
+   ends.reserve(2 * edges.size());
+   for(const std::pair<int,int>& edge : edges)
+   {
+      ends.push_back(edge.first);
+      ends.push_back(edge.second);
+   }
+   WriteVector(out, ends);
+}
+
+void serialize::WriteEdges(std::ostream& out, const NetworkSnapshot& snapshot)
+{
+   std::vector<std::pair<int,int>> edges;
+   edges.reserve(snapshot.EdgeCount());
+   for(int u = 0; u < snapshot.Size(); u++)
+   {
+      for(int v : snapshot.GetNeighbors(u))
+      {
+         if(u < v)
+         {
+            edges.push_back(std::make_pair(u, v));
+         }
+      }
+   }
+   WriteEdges(out, edges);
+}
+
+std::vector<std::pair<int,int>> serialize::ReadEdges(std::istream& in)
+{
+   std::vector<std::uint32_t> ends = ReadVector<std::uint32_t>(in);
+   std::vector<std::pair<int,int>> edges;
+   edges.reserve(ends.size() / 2);
+   for(std::size_t e = 0; e + 1 < ends.size(); e += 2)
+   {
+      edges.push_back(std::make_pair(ends[e], ends[e + 1]));
+   }
+   return edges;
+}
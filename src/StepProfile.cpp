@@ -0,0 +1,89 @@
+#include "StepProfile.hpp"
+
+#include <cstdlib> // std::malloc
+#include <new>     // std::bad_alloc
+
+#ifdef LCA_PROFILE
+
+namespace
+{
+   thread_local long long thread_allocations = 0;
+}
+
+// Count every allocation made through the global operator new. The
+// array and nothrow forms call this one, and the default operator
+// delete frees memory from malloc.
+void* operator new(std::size_t size)
+{
+   thread_allocations++;
+   void* p = std::malloc(size == 0 ? 1 : size);
+   if(p == nullptr)
+   {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+bool StepProfile::Enabled()
+{
+   return true;
+}
+
+long long StepProfile::ThreadAllocations()
+{
+   return thread_allocations;
+}
+
+#else
+
+bool StepProfile::Enabled()
+{
+   return false;
+}
+
+long long StepProfile::ThreadAllocations()
+{
+   return 0;
+}
+
+#endif // LCA_PROFILE
+
+double StepProfile::TotalSeconds() const
+{
+   return move_seconds + mode_seconds + network_seconds + update_seconds + stats_seconds;
+}
+
+StepProfile& StepProfile::operator+= (const StepProfile& p)
+{
+   move_seconds      += p.move_seconds;
+   mode_seconds      += p.mode_seconds;
+   network_seconds   += p.network_seconds;
+   update_seconds    += p.update_seconds;
+   stats_seconds     += p.stats_seconds;
+   steps             += p.steps;
+   edges             += p.edges;
+   rule_applications += p.rule_applications;
+   allocations       += p.allocations;
+   return *this;
+}
+
+std::ostream& operator<< (std::ostream& out, const StepProfile& p)
+{
+   double total = p.TotalSeconds();
+   auto phase = [&out, total](const char* name, double seconds)
+      {
+         out << name << seconds << " s ("
+             << (total > 0 ? 100 * seconds / total : 0) << "%)" << std::endl;
+      };
+
+   out << "steps:             " << p.steps << std::endl;
+   phase("move:              ", p.move_seconds);
+   phase("mode:              ", p.mode_seconds);
+   phase("network:           ", p.network_seconds);
+   phase("update:            ", p.update_seconds);
+   phase("stats:             ", p.stats_seconds);
+   out << "edges:             " << p.edges << std::endl
+       << "rule applications: " << p.rule_applications << std::endl
+       << "allocations:       " << p.allocations << std::endl;
+   return out;
+}
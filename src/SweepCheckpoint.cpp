@@ -0,0 +1,120 @@
+#include "SweepCheckpoint.hpp"
+
+#include <stdexcept>
+#include <iterator>
+#include <cstdio> // std::rename
+
+namespace
+{
+   const std::string HEADER = "lca-checkpoint";
+}
+
+SweepCheckpoint::SweepCheckpoint(const std::string& path, const std::string& signature,
+                                 std::uint64_t seed) :
+   path_(path),
+   seed_(seed)
+{
+   std::ifstream in(path);
+   std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   in.close();
+
+   // only complete lines count.
+   std::size_t end      = contents.rfind('\n');
+   std::size_t complete = (end == std::string::npos) ? 0 : end + 1;
+
+   std::istringstream lines(contents.substr(0, complete));
+   std::string line;
+   if(std::getline(lines, line))
+   {
+      std::istringstream header(line);
+      std::string tag;
+      std::string saved_signature;
+      if(!(header >> tag >> seed_) || tag != HEADER)
+      {
+         throw std::runtime_error("SweepCheckpoint: " + path + " is not a checkpoint");
+      }
+      std::getline(header >> std::ws, saved_signature);
+      if(saved_signature != signature)
+      {
+         throw std::runtime_error("SweepCheckpoint: " + path + " was written by a different sweep ("
+                                  + saved_signature + ")");
+      }
+
+      while(std::getline(lines, line))
+      {
+         std::istringstream cell(line);
+         int parameter;
+         int replica;
+         std::string result;
+         if(cell >> parameter >> replica && std::getline(cell >> std::ws, result))
+         {
+            results_[std::make_pair(parameter, replica)] = result;
+         }
+      }
+   }
+
+   if(complete == 0 || complete < contents.size())
+   {
+      // Start over from the complete lines (or just the header) in a new
+      // file, renamed over the old one so it is never left half written.
+      std::string temporary = path + ".tmp";
+      std::ofstream out(temporary, std::ios::trunc);
+      if(complete == 0)
+      {
+         out << HEADER << " " << seed_ << " " << signature << "\n";
+      }
+      out << contents.substr(0, complete) << std::flush;
+      if(!out || std::rename(temporary.c_str(), path.c_str()) != 0)
+      {
+         throw std::runtime_error("SweepCheckpoint: can't write " + path);
+      }
+   }
+
+   out_.open(path, std::ios::app);
+   if(!out_)
+   {
+      throw std::runtime_error("SweepCheckpoint: can't open " + path);
+   }
+}
+
+SweepCheckpoint::~SweepCheckpoint() {}
+
+std::string SweepCheckpoint::Signature(int argc, char** argv)
+{
+   std::string signature;
+   for(int i = 1; i < argc; i++)
+   {
+      signature += (i > 1 ? " " : "") + std::string(argv[i]);
+   }
+   return signature;
+}
+
+std::uint64_t SweepCheckpoint::Seed() const
+{
+   return seed_;
+}
+
+int SweepCheckpoint::Size() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return results_.size();
+}
+
+std::string SweepCheckpoint::Find(int parameter, int replica, bool& found) const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = results_.find(std::make_pair(parameter, replica));
+   found = it != results_.end();
+   return found ? it->second : std::string();
+}
+
+void SweepCheckpoint::Append(int parameter, int replica, const std::string& result)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   results_[std::make_pair(parameter, replica)] = result;
+   out_ << parameter << " " << replica << " " << result << "\n" << std::flush;
+   if(!out_)
+   {
+      throw std::runtime_error("SweepCheckpoint: can't write " + path_);
+   }
+}
@@ -0,0 +1,159 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int num_threads) :
+   task_(nullptr),
+   unfinished_(0),
+   generation_(0),
+   stop_(false)
+{
+   if(num_threads < 1)
+   {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+   }
+
+   for(int i = 0; i < num_threads; i++)
+   {
+      queues_.push_back(std::make_unique<TaskQueue>());
+   }
+
+   // the calling thread is the first thread.
+   for(int i = 1; i < num_threads; i++)
+   {
+      threads_.push_back(std::thread(&ThreadPool::WorkerMain, this, i));
+   }
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+   }
+   work_ready_.notify_all();
+   for(auto& thread : threads_)
+   {
+      thread.join();
+   }
+}
+
+int ThreadPool::NumThreads() const
+{
+   return queues_.size();
+}
+
+void ThreadPool::Run(int num_tasks, const std::function<void(int)>& task)
+{
+   if(threads_.empty() || num_tasks <= 1)
+   {
+      for(int t = 0; t < num_tasks; t++)
+      {
+         task(t);
+      }
+      return;
+   }
+
+   // models sharing a pool may step from different threads.
+   std::lock_guard<std::mutex> run_lock(run_mutex_);
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      unfinished_ = num_tasks;
+      const int n = NumThreads();
+      for(int i = 0; i < n; i++)
+      {
+         std::lock_guard<std::mutex> queue_lock(queues_[i]->mutex);
+         queues_[i]->front = (int)((long long)num_tasks * i / n);
+         queues_[i]->back  = (int)((long long)num_tasks * (i + 1) / n);
+      }
+      generation_++;
+   }
+   work_ready_.notify_all();
+
+   RunTasks(0);
+
+   std::unique_lock<std::mutex> lock(mutex_);
+   work_done_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+int ThreadPool::Pop(int self)
+{
+   TaskQueue& queue = *queues_[self];
+   std::lock_guard<std::mutex> lock(queue.mutex);
+   if(queue.front < queue.back)
+   {
+      return queue.front++;
+   }
+   return -1;
+}
+
+int ThreadPool::Steal(int self)
+{
+   const int n = NumThreads();
+   for(int k = 1; k < n; k++)
+   {
+      TaskQueue& victim = *queues_[(self + k) % n];
+      int first, last;
+      {
+         std::lock_guard<std::mutex> lock(victim.mutex);
+         int remaining = victim.back - victim.front;
+         if(remaining <= 0)
+         {
+            continue;
+         }
+         // take the back half, rounded up.
+         last  = victim.back;
+         first = victim.back - (remaining + 1) / 2;
+         victim.back = first;
+      }
+
+      // run the first stolen task now and queue the rest.
+      TaskQueue& queue = *queues_[self];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.front = first + 1;
+      queue.back  = last;
+      return first;
+   }
+   return -1;
+}
+
+void ThreadPool::RunTasks(int self)
+{
+   while(true)
+   {
+      int t = Pop(self);
+      if(t < 0)
+      {
+         t = Steal(self);
+      }
+      if(t < 0)
+      {
+         return;
+      }
+
+      (*task_)(t);
+
+      if(--unfinished_ == 0)
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         work_done_.notify_all();
+      }
+   }
+}
+
+void ThreadPool::WorkerMain(int self)
+{
+   unsigned seen = 0;
+   std::unique_lock<std::mutex> lock(mutex_);
+   while(true)
+   {
+      work_ready_.wait(lock, [this, &seen] { return stop_ || generation_ != seen; });
+      if(stop_)
+      {
+         return;
+      }
+      seen = generation_;
+      lock.unlock();
+      RunTasks(self);
+      lock.lock();
+   }
+}
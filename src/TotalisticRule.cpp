@@ -4,6 +4,9 @@
 #include <numeric>
 #include <iostream>
 #include <utility>
+#include <algorithm> // std::max
+
+const int TotalisticRule::DEFAULT_MAX_DEGREE;
 
 std::istream& operator>>(std::istream& stream, TotalisticRule& rule)
 {
@@ -25,30 +28,28 @@ std::istream& operator>>(std::istream& stream, TotalisticRule& rule)
       line_number++;
    }
 
+   temp.Compile(TotalisticRule::DEFAULT_MAX_DEGREE);
    rule = std::move(temp);
    return stream;
 }
 
-double density(const std::vector<int>& neighborhood)
-{
-   return ((double)std::accumulate(neighborhood.begin(), neighborhood.end(), 0)
-           / (double)neighborhood.size());
-}
-
-bool matches(Transition& t, int self, const std::vector<int>& neighbors)
+/**
+ * Test whether transition t applies to an agent in state self whose
+ * neighbors' states sum to ones out of total neighbors.
+ */
+bool matches(const Transition& t, int self, int ones, int total)
 {
    if(t.any_state || self == t.pre_state)
    {
       double neighborhood_density;
-
-      std::vector<int> neighborhood(neighbors.size());
-      std::copy(neighbors.begin(), neighbors.end(), neighborhood.begin());
       if(t.include_self)
       {
-         neighborhood.push_back(self);
+         neighborhood_density = (double)(ones + self) / (double)(total + 1);
+      }
+      else
+      {
+         neighborhood_density = (double)ones / (double)total;
       }
-
-      neighborhood_density = density(neighborhood);
 
       if(t.range.Contains(neighborhood_density))
       {
@@ -58,19 +59,62 @@ bool matches(Transition& t, int self, const std::vector<int>& neighbors)
    return false;
 }
 
-std::pair<int, double> apply(Transition t, int self)
+std::pair<int, double> apply(const Transition& t, int self)
 {
    if(t.result_self) return std::make_pair(self, t.heading_change);
    else return std::make_pair(t.result_state, t.heading_change);
 }
 
 std::pair<int, double> TotalisticRule::Apply(int self, const std::vector<int>& neighbors) const
+{
+   return ApplyCount(self, std::accumulate(neighbors.begin(), neighbors.end(), 0), neighbors.size());
+}
+
+int TotalisticRule::LookupIndex(int self, int ones, int total) const
+{
+   // The table holds a triangle of (total, ones) entries for each
+   // state: total+1 possible values of ones for each total.
+   int triangle = (max_degree_ + 1) * (max_degree_ + 2) / 2;
+   return self * triangle + total * (total + 1) / 2 + ones;
+}
+
+void TotalisticRule::Compile(int max_degree)
+{
+   max_degree_ = std::max(max_degree, -1);
+   lookup_table_.resize(2 * (max_degree_ + 1) * (max_degree_ + 2) / 2);
+   for(int self = 0; self <= 1; self++)
+   {
+      for(int total = 0; total <= max_degree_; total++)
+      {
+         for(int ones = 0; ones <= total; ones++)
+         {
+            lookup_table_[LookupIndex(self, ones, total)] = Evaluate(self, ones, total);
+         }
+      }
+   }
+}
+
+int TotalisticRule::MaxDegree() const
+{
+   return max_degree_;
+}
+
+std::pair<int, double> TotalisticRule::ApplyCount(int self, int ones, int total) const
+{
+   if(total <= max_degree_ && (self == 0 || self == 1) && ones >= 0 && ones <= total)
+   {
+      return lookup_table_[LookupIndex(self, ones, total)];
+   }
+   return Evaluate(self, ones, total);
+}
+
+std::pair<int, double> TotalisticRule::Evaluate(int self, int ones, int total) const
 {
    // Look for rules that match the current state
    // Apply the first rule that matches
-   for(Transition t : transition_table_)
+   for(const Transition& t : transition_table_)
    {
-      if(matches(t, self, neighbors))
+      if(matches(t, self, ones, total))
       {
          return apply(t, self);
       }
@@ -79,3 +123,8 @@ std::pair<int, double> TotalisticRule::Apply(int self, const std::vector<int>& n
    // If no rule applies then state remains unchanged.
    return std::make_pair(self, 0); // XXX: is this the right thing to do.
 }
+
+bool TotalisticRule::IsTotalistic() const
+{
+   return true;
+}
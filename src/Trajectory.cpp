@@ -0,0 +1,309 @@
+#include "Trajectory.hpp"
+
+#include <cstring>   // std::memcpy, std::memcmp
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+   std::size_t PadTo8(std::size_t n)
+   {
+      return (n + 7) & ~(std::size_t)7;
+   }
+
+   template<typename T>
+   void Put(unsigned char*& p, const T& value)
+   {
+      std::memcpy(p, &value, sizeof(T));
+      p += sizeof(T);
+   }
+}
+
+std::size_t trajectory::FrameSize(int num_agents, std::uint64_t num_edges)
+{
+   return sizeof(std::uint64_t)
+      + 3 * sizeof(double) * num_agents
+      + PadTo8(2 * num_agents)
+      + 2 * sizeof(std::uint32_t) * num_edges;
+}
+
+/// TrajectoryWriter
+
+TrajectoryWriter::TrajectoryWriter(const std::string& path, int num_agents, double arena_size,
+                                   bool record_edges) :
+   out_(path, std::ios::binary | std::ios::trunc),
+   num_agents_(num_agents),
+   record_edges_(record_edges),
+   num_frames_(0)
+{
+   if(!out_)
+   {
+      throw std::runtime_error("TrajectoryWriter: can't open " + path);
+   }
+
+   unsigned char header[trajectory::HEADER_SIZE];
+   unsigned char* p = header;
+   std::memcpy(p, trajectory::MAGIC, sizeof(trajectory::MAGIC));
+   p += sizeof(trajectory::MAGIC);
+   Put(p, trajectory::VERSION);
+   Put(p, record_edges ? trajectory::FLAG_EDGES : (std::uint32_t)0);
+   Put(p, (std::uint32_t)num_agents);
+   Put(p, (std::uint32_t)0);
+   Put(p, arena_size);
+   out_.write((const char*)header, sizeof(header));
+}
+
+TrajectoryWriter::~TrajectoryWriter() {}
+
+void TrajectoryWriter::Write(const Model& model)
+{
+   if(record_edges_)
+   {
+      Write(model.GetAgentStore(), model.GetStates(), model.StepNetwork().get());
+   }
+   else
+   {
+      Write(model.GetAgentStore(), model.GetStates(), nullptr);
+   }
+}
+
+void TrajectoryWriter::Write(const AgentStore& agents, const std::vector<int>& states,
+                             const NetworkSnapshot* network)
+{
+   if(agents.Size() != num_agents_ || states.size() != num_agents_
+      || (network != nullptr && network->Size() != num_agents_))
+   {
+      throw std::invalid_argument("TrajectoryWriter::Write");
+   }
+
+   std::uint64_t num_edges = 0;
+   if(record_edges_ && network != nullptr)
+   {
+      num_edges = network->EdgeCount();
+   }
+
+   buffer_.assign(trajectory::FrameSize(num_agents_, num_edges), 0);
+   unsigned char* p = buffer_.data();
+   Put(p, num_edges);
+
+   std::memcpy(p, agents.X().data(), sizeof(double) * num_agents_);
+   p += sizeof(double) * num_agents_;
+   std::memcpy(p, agents.Y().data(), sizeof(double) * num_agents_);
+   p += sizeof(double) * num_agents_;
+   for(int i = 0; i < num_agents_; i++)
+   {
+      Put(p, agents.GetHeading(i).Radians());
+   }
+
+   unsigned char* flags = p;
+   for(int i = 0; i < num_agents_; i++)
+   {
+      flags[i]               = states[i];
+      flags[num_agents_ + i] = agents.IsDark(i);
+   }
+   p += PadTo8(2 * num_agents_);
+
+   if(num_edges > 0)
+   {
+      for(int u = 0; u < num_agents_; u++)
+      {
+         for(int v : network->GetNeighbors(u))
+         {
+            if(u < v)
+            {
+               Put(p, (std::uint32_t)u);
+               Put(p, (std::uint32_t)v);
+            }
+         }
+      }
+   }
+
+   out_.write((const char*)buffer_.data(), buffer_.size());
+   if(!out_)
+   {
+      throw std::runtime_error("TrajectoryWriter: write failed");
+   }
+   num_frames_++;
+}
+
+void TrajectoryWriter::Flush()
+{
+   out_.flush();
+}
+
+int TrajectoryWriter::NumFrames() const
+{
+   return num_frames_;
+}
+
+/// TrajectoryFrame
+
+TrajectoryFrame::TrajectoryFrame(int num_agents, const unsigned char* data) :
+   num_agents_(num_agents)
+{
+   std::memcpy(&num_edges_, data, sizeof(num_edges_));
+   data += sizeof(num_edges_);
+   x_       = (const double*)data;
+   y_       = x_ + num_agents;
+   heading_ = y_ + num_agents;
+   states_  = (const std::uint8_t*)(heading_ + num_agents);
+   dark_    = states_ + num_agents;
+   edges_   = (const std::uint32_t*)((const unsigned char*)states_ + PadTo8(2 * num_agents));
+}
+
+int TrajectoryFrame::NumAgents() const
+{
+   return num_agents_;
+}
+
+Point TrajectoryFrame::Position(int i) const
+{
+   return Point(x_[i], y_[i]);
+}
+
+Heading TrajectoryFrame::GetHeading(int i) const
+{
+   return Heading(heading_[i]);
+}
+
+int TrajectoryFrame::State(int i) const
+{
+   return states_[i];
+}
+
+bool TrajectoryFrame::IsDark(int i) const
+{
+   return dark_[i];
+}
+
+double TrajectoryFrame::Density() const
+{
+   int ones = 0;
+   for(int i = 0; i < num_agents_; i++)
+   {
+      ones += states_[i];
+   }
+   return (double)ones / num_agents_;
+}
+
+std::uint64_t TrajectoryFrame::NumEdges() const
+{
+   return num_edges_;
+}
+
+std::pair<int,int> TrajectoryFrame::Edge(std::uint64_t e) const
+{
+   return std::make_pair((int)edges_[2*e], (int)edges_[2*e + 1]);
+}
+
+std::shared_ptr<NetworkSnapshot> TrajectoryFrame::GetNetwork() const
+{
+   std::vector<std::pair<int,int>> edges;
+   edges.reserve(num_edges_);
+   for(std::uint64_t e = 0; e < num_edges_; e++)
+   {
+      edges.push_back(Edge(e));
+   }
+   return std::make_shared<NetworkSnapshot>(num_agents_, edges);
+}
+
+/// TrajectoryReader
+
+TrajectoryReader::TrajectoryReader(const std::string& path) :
+   fd_(-1),
+   data_(nullptr),
+   size_(0)
+{
+   fd_ = open(path.c_str(), O_RDONLY);
+   if(fd_ < 0)
+   {
+      throw std::runtime_error("TrajectoryReader: can't open " + path);
+   }
+
+   struct stat st;
+   if(fstat(fd_, &st) != 0 || st.st_size < (off_t)trajectory::HEADER_SIZE)
+   {
+      close(fd_);
+      throw std::runtime_error("TrajectoryReader: " + path + " is not a trajectory file");
+   }
+   size_ = st.st_size;
+
+   void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+   if(mapping == MAP_FAILED)
+   {
+      close(fd_);
+      throw std::runtime_error("TrajectoryReader: can't map " + path);
+   }
+   data_ = (const unsigned char*)mapping;
+   // frames are mostly read in order.
+   madvise(mapping, size_, MADV_SEQUENTIAL);
+
+   std::uint32_t version, flags, num_agents;
+   std::memcpy(&version,     data_ + 8,  sizeof(version));
+   std::memcpy(&flags,       data_ + 12, sizeof(flags));
+   std::memcpy(&num_agents,  data_ + 16, sizeof(num_agents));
+   std::memcpy(&arena_size_, data_ + 24, sizeof(arena_size_));
+   if(std::memcmp(data_, trajectory::MAGIC, sizeof(trajectory::MAGIC)) != 0
+      || version != trajectory::VERSION)
+   {
+      munmap(mapping, size_);
+      close(fd_);
+      throw std::runtime_error("TrajectoryReader: " + path + " is not a trajectory file");
+   }
+   num_agents_ = num_agents;
+   has_edges_  = (flags & trajectory::FLAG_EDGES) != 0;
+
+   // find the start of every complete frame.
+   std::size_t offset = trajectory::HEADER_SIZE;
+   while(offset + sizeof(std::uint64_t) <= size_)
+   {
+      std::uint64_t num_edges;
+      std::memcpy(&num_edges, data_ + offset, sizeof(num_edges));
+      std::size_t frame_size = trajectory::FrameSize(num_agents_, num_edges);
+      if(num_edges > size_ || offset + frame_size > size_)
+      {
+         break;
+      }
+      frame_offsets_.push_back(offset);
+      offset += frame_size;
+   }
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+   munmap((void*)data_, size_);
+   close(fd_);
+}
+
+int TrajectoryReader::NumAgents() const
+{
+   return num_agents_;
+}
+
+double TrajectoryReader::ArenaSize() const
+{
+   return arena_size_;
+}
+
+bool TrajectoryReader::HasEdges() const
+{
+   return has_edges_;
+}
+
+int TrajectoryReader::NumFrames() const
+{
+   return frame_offsets_.size();
+}
+
+TrajectoryFrame TrajectoryReader::GetFrame(int t) const
+{
+   if(t < 0 || t >= frame_offsets_.size())
+   {
+      throw std::out_of_range("TrajectoryReader::GetFrame");
+   }
+   return TrajectoryFrame(num_agents_, data_ + frame_offsets_[t]);
+}
@@ -0,0 +1,161 @@
+#include "VerletList.hpp"
+#include "Proximity.hpp"
+
+namespace
+{
+   bool Within(double squared_range, const Point& p, const Point& q)
+   {
+      double dx = p.GetX() - q.GetX();
+      double dy = p.GetY() - q.GetY();
+      return dx * dx + dy * dy <= squared_range;
+   }
+}
+
+VerletList::VerletList(double arena_size, double range, double skin) :
+   arena_size_(arena_size),
+   range_(range),
+   skin_(skin),
+   squared_range_(proximity::SquaredRange(range)),
+   // Leave a little slack for rounding in the distance computations
+   // so that a pair just inside range is never missed.
+   squared_limit_(proximity::SquaredRange(skin / 2 - 1e-9 * (range + skin))),
+   rebuilds_(0),
+   cells_(arena_size, range + skin)
+{}
+
+VerletList::~VerletList() {}
+
+bool VerletList::NeedsRebuild(const std::vector<Point>& points) const
+{
+   if(points.size() != reference_.size())
+   {
+      return true;
+   }
+
+   for(int i = 0; i < points.size(); i++)
+   {
+      if(!Within(squared_limit_, points[i], reference_[i]))
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+void VerletList::Clear()
+{
+   reference_.clear();
+   candidates_.clear();
+   within_.clear();
+   rebuilds_ = 0;
+}
+
+bool VerletList::Update(const std::vector<Point>& points)
+{
+   if(!NeedsRebuild(points))
+   {
+      return false;
+   }
+   cells_.Build(points);
+   cells_.Pairs(points, candidates_);
+   within_.reserve(candidates_.capacity()); // grow with the candidates
+   within_.assign(candidates_.size(), 0);
+   reference_ = points;
+   rebuilds_++;
+   return true;
+}
+
+bool VerletList::Update(const std::vector<Point>& points, ThreadPool& pool)
+{
+   if(!NeedsRebuild(points))
+   {
+      return false;
+   }
+   cells_.Build(points);
+   cells_.Pairs(points, candidates_, pool);
+   within_.reserve(candidates_.capacity()); // grow with the candidates
+   within_.assign(candidates_.size(), 0);
+   reference_ = points;
+   rebuilds_++;
+   return true;
+}
+
+void VerletList::Pairs(const std::vector<Point>& points,
+                       std::vector<std::pair<int,int>>& pairs)
+{
+   Update(points);
+   Filter(points, pairs, nullptr, nullptr);
+}
+
+void VerletList::Pairs(const std::vector<Point>& points,
+                       std::vector<std::pair<int,int>>& pairs,
+                       ThreadPool& pool)
+{
+   Update(points, pool);
+   Filter(points, pairs, nullptr, nullptr);
+}
+
+bool VerletList::Changes(const std::vector<Point>& points,
+                         std::vector<std::pair<int,int>>& pairs,
+                         std::vector<std::pair<int,int>>& entered,
+                         std::vector<std::pair<int,int>>& left)
+{
+   entered.clear();
+   left.clear();
+   if(Update(points))
+   {
+      Filter(points, pairs, nullptr, nullptr);
+      return false;
+   }
+   Filter(points, pairs, &entered, &left);
+   return true;
+}
+
+bool VerletList::Changes(const std::vector<Point>& points,
+                         std::vector<std::pair<int,int>>& pairs,
+                         std::vector<std::pair<int,int>>& entered,
+                         std::vector<std::pair<int,int>>& left,
+                         ThreadPool& pool)
+{
+   entered.clear();
+   left.clear();
+   if(Update(points, pool))
+   {
+      Filter(points, pairs, nullptr, nullptr);
+      return false;
+   }
+   Filter(points, pairs, &entered, &left);
+   return true;
+}
+
+void VerletList::Filter(const std::vector<Point>& points,
+                        std::vector<std::pair<int,int>>& pairs,
+                        std::vector<std::pair<int,int>>* entered,
+                        std::vector<std::pair<int,int>>* left)
+{
+   pairs.clear();
+   for(std::size_t k = 0; k < candidates_.size(); k++)
+   {
+      const std::pair<int,int>& candidate = candidates_[k];
+      const bool within = Within(squared_range_, points[candidate.first], points[candidate.second]);
+      if(within)
+      {
+         pairs.push_back(candidate);
+      }
+      if(entered != nullptr && within != (bool)within_[k])
+      {
+         (within ? entered : left)->push_back(candidate);
+      }
+      within_[k] = within;
+   }
+}
+
+int VerletList::Rebuilds() const
+{
+   return rebuilds_;
+}
+
+double VerletList::Skin() const
+{
+   return skin_;
+}
@@ -3,8 +3,6 @@
 #include <cstdlib> // atoi
 #include <functional>
 #include <cmath>
-#include <thread> // hardware_concurrency()
-#include <mutex>
 #include <chrono>
 #include <utility>
 #include <map>
@@ -13,6 +11,8 @@
 #include <getopt.h>
 
 #include "Model.hpp"
+#include "EnsembleRunner.hpp"
+#include "SweepCheckpoint.hpp"
 
 struct config {
    int    num_agents;
@@ -22,92 +22,33 @@ struct config {
    int    num_iterations;
 } model_config;
 
-std::mutex density_lock;
-double next_density = 0.05;
 const double DENSITY_STEP = 0.05;
 const double MAX_DENSITY  = 4.0;
 
-std::mutex output_lock;
-
 MajorityRule majority_rule;
 
-double evaluate_ca(int num_iterations, double speed, double initial_density, int arena_size)
-{
-   std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
-   int num_correct = 0;
-   for(int iteration = 0; iteration < num_iterations; iteration++)
-   {
-      Model m(arena_size,
-              model_config.num_agents,
-              model_config.communication_range,
-              model_config.seed+iteration,
-              initial_density,
-              speed);
-
-      m.SetMovementRule(std::make_shared<RandomWalk>());
-      m.RecordNetworkDensityOnly();
-
-      for(int step = 0; step < 2500; step++)
-      {
-         m.Step(&majority_rule);
-         if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
-         {
-            break; // done. no need to keep evaluating.
-         }
-      }
-
-      if(m.GetStats().IsCorrect())
-      {
-         num_correct++;
-      }
-   }
-
-   return (double) num_correct / num_iterations;
-}
-
-void evaluate_density(double agent_density)
+bool evaluate_ca(int seed, double speed, double initial_density, int arena_size)
 {
-   double arena_size = sqrt(model_config.num_agents / agent_density);
-   std::map<double, double> results;
-   for(double state_density = 0.0; state_density <= 1.001; state_density += 0.02)
-   {
-      double proportion_correct = evaluate_ca(model_config.num_iterations, model_config.speed,
-                                              state_density, arena_size);
-      results.emplace(state_density, proportion_correct);
-   }
+   Model m(arena_size,
+           model_config.num_agents,
+           model_config.communication_range,
+           seed,
+           initial_density,
+           speed);
 
-   output_lock.lock(); // lock to avoid interleaving output :/
-   for(auto result : results)
-   {
-      std::cout << agent_density << " "
-                << result.first  << " "
-                << result.second
-                << std::endl;
-   }
-   std::cout << std::endl;
-   output_lock.unlock();
-}
+   m.SetMovementRule(std::make_shared<RandomWalk>());
+   m.RecordNetworkDensityOnly();
 
-void thread_main()
-{
-   while(true)
+   for(int step = 0; step < 2500; step++)
    {
-      density_lock.lock();
-
-      double density = next_density;
-      next_density += DENSITY_STEP;
-
-      density_lock.unlock();
-
-      if(density <= MAX_DENSITY)
-      {
-         evaluate_density(density);
-      }
-      else
+      m.Step(&majority_rule);
+      if(m.GetStats().IsConsensus())
       {
-         return;
+         break; // done. no need to keep evaluating.
       }
    }
+
+   return m.GetStats().IsCorrect();
 }
 
 int main(int argc, char** argv)
@@ -117,6 +58,8 @@ int main(int argc, char** argv)
    double density_step    = 0.01;
    double initial_density = 0.0;
    int    save_state      = 0;
+   std::string checkpoint_path;
+   std::string signature = SweepCheckpoint::Signature(argc, argv);
 
    model_config.communication_range = 1;
    model_config.num_agents          = 100;
@@ -129,12 +72,13 @@ int main(int argc, char** argv)
          {"arena-size",          required_argument, 0,            'a'},
          {"seed",                required_argument, 0,            's'},
          {"iterations",          required_argument, 0,            'i'},
+         {"checkpoint",          required_argument, 0,            'K'},
          {0,0,0,0}
       };
 
    int option_index = 0;
 
-   while((opt_char = getopt_long(argc, argv, "m:d:n:s:",
+   while((opt_char = getopt_long(argc, argv, "m:d:n:s:K:",
                                  long_options, &option_index)) != -1)
    {
       switch(opt_char)
@@ -152,6 +96,10 @@ int main(int argc, char** argv)
          model_config.num_iterations = atoi(optarg);
          break;
 
+      case 'K':
+         checkpoint_path = optarg;
+         break;
+
       case ':':
          std::cout << "option " << long_options[option_index].name << "requires an argument" << std::endl;
          exit(-1);
@@ -170,18 +118,51 @@ int main(int argc, char** argv)
 
    model_config.speed = atof(argv[optind]);
 
-   int num_threads = std::thread::hardware_concurrency();
+   std::vector<double> agent_densities;
+   for(double agent_density = DENSITY_STEP; agent_density <= MAX_DENSITY; agent_density += DENSITY_STEP)
+   {
+      agent_densities.push_back(agent_density);
+   }
 
-   std::vector<std::thread> threads;
+   std::vector<double> state_densities;
+   for(double state_density = 0.0; state_density <= 1.001; state_density += 0.02)
+   {
+      state_densities.push_back(state_density);
+   }
 
-   for(int i = 0; i < num_threads; i++)
+   // one parameter for each (agent density, state density) pair.
+   int num_states = state_densities.size();
+   std::unique_ptr<SweepCheckpoint> checkpoint;
+   if(!checkpoint_path.empty())
    {
-      threads.push_back(std::thread(thread_main));
+      checkpoint = std::make_unique<SweepCheckpoint>(checkpoint_path, signature, model_config.seed);
    }
 
-   for(auto& t : threads)
+   EnsembleRunner runner;
+   auto correct = runner.Run(agent_densities.size() * num_states, model_config.num_iterations,
+                             [&](int parameter, int iteration)
+                             {
+                                double agent_density = agent_densities[parameter / num_states];
+                                int arena_size = sqrt(model_config.num_agents / agent_density);
+                                return evaluate_ca(model_config.seed + iteration, model_config.speed,
+                                                   state_densities[parameter % num_states], arena_size);
+                             }, checkpoint.get());
+
+   for(int a = 0; a < agent_densities.size(); a++)
    {
-      t.join();
+      for(int d = 0; d < num_states; d++)
+      {
+         int num_correct = 0;
+         for(bool c : correct[a * num_states + d])
+         {
+            num_correct += c;
+         }
+         std::cout << agent_densities[a] << " "
+                   << state_densities[d] << " "
+                   << (double) num_correct / model_config.num_iterations
+                   << std::endl;
+      }
+      std::cout << std::endl;
    }
 
    return 0;
@@ -61,16 +61,16 @@ int main(int argc, char** argv)
    int num_correct = 0;
 
    std::vector<int> times;
+   StepProfile profile;
 
    for(int i = 0; i < 100; i++)
    {
       std::unique_ptr<LCA> lca = factory.Create(initial_density);
-      lca->MinimizeMemory();
-      int time = lca->Run([](const ModelStats& s) {
-                             return (s.CurrentCADensity() == 0.0 || s.CurrentCADensity() == 1.0);
-                          });
+      lca->StreamStats();
+      int time = lca->RunUntilDecided();
 
       times.push_back(time);
+      profile += lca->GetProfile();
       if(lca->GetStats().IsCorrect())
       {
          num_correct++;
@@ -83,4 +83,9 @@ int main(int argc, char** argv)
              << median(times) << " "
              << variance(times) << " "
              << mode(times) << std::endl;
+
+   if(factory.Profile())
+   {
+      std::cerr << profile;
+   }
 }
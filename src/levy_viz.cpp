@@ -45,9 +45,10 @@ void evaluate_ca(double initial_density)
    for(int step = 0; step < 2000; step++)
    {
       m.Step(&majority_rule);
-      for(auto agent : m.GetAgents())
+      const AgentStore& agents = m.GetAgentStore();
+      for(int i = 0; i < agents.Size(); i++)
       {
-         std::cout << agent.Position().GetX() << " " << agent.Position().GetY() << " ";
+         std::cout << agents.Position(i).GetX() << " " << agents.Position(i).GetY() << " ";
       }
       std::cout << std::endl;
    }
@@ -1,10 +1,9 @@
-#include "OneDLattice.hpp"
+#include "PackedLattice.hpp"
+#include "EnsembleRunner.hpp"
+#include "Philox.hpp"
 
 #include <iostream>
-#include <future>
-#include <map>
-#include <utility>
-#include <functional> // std::bind
+#include <vector>
 
 #define NUM_REPLICAS 100
 
@@ -12,50 +11,41 @@ int num_agents;
 double density_step;
 int seed;
 
-MajorityRule majority_rule;
-
-bool evaluate_ca(OneDLattice& lattice)
+/**
+ * Run every replica in the lattice to a fixed point (or 5000 steps)
+ * and return the number of replicas among the first num_replicas that
+ * reached the correct consensus.
+ */
+int evaluate_ca(PackedLattice& lattice, int num_replicas)
 {
-   double initial_density = lattice.GetDensity();
+   std::vector<double> initial_density;
+   for(int r = 0; r < num_replicas; r++)
+   {
+      initial_density.push_back(lattice.GetDensity(r));
+   }
+
    for(int i = 0; i < 5000; i++)
    {
-      lattice.Step(majority_rule);
-      if(!lattice.IsChanging())
+      lattice.Step();
+      if(lattice.Changing() == 0)
       {
-         break; // stop evaluate if the ca state stops changing.
+         break; // stop evaluating once no replica is changing.
       }
    }
-   
-   if(initial_density < 0.5)
-   {
-      return lattice.GetDensity() == 0.0;
-   }
-   else
-   {
-      return lattice.GetDensity() == 1.0;
-   }
-}
 
-std::map<double,double> evaluate_radius(int radius)
-{
-   OneDLattice lattice(num_agents, radius);
-   lattice.Seed(seed);
-
-   std::map<double, double> results;
-   for(double density = 0.0; density <= 1.001; density += density_step)
+   int correct = 0;
+   for(int r = 0; r < num_replicas; r++)
    {
-      int correct = 0;
-      for(int i = 0; i < NUM_REPLICAS; i++)
+      if(initial_density[r] < 0.5)
+      {
+         correct += lattice.GetDensity(r) == 0.0;
+      }
+      else
       {
-         lattice.SetDensity(density);
-         if(evaluate_ca(lattice))
-         {
-            correct++;
-         }
+         correct += lattice.GetDensity(r) == 1.0;
       }
-      results.emplace(std::make_pair(density, (double)correct / (double)NUM_REPLICAS));
    }
-   return results;
+   return correct;
 }
 
 int main(int argc, char** argv)
@@ -65,19 +55,42 @@ int main(int argc, char** argv)
    density_step = atof(argv[2]);
    seed = atoi(argv[3]);
 
-   std::map<int,std::future<std::map<double,double>>> futures;
-   for(int radius = 1; radius <= num_agents/2; radius++)
+   std::vector<double> densities;
+   for(double density = 0.0; density <= 1.001; density += density_step)
    {
-      futures.emplace(std::make_pair(radius,std::async(std::launch::async | std::launch::deferred,
-                                                       std::bind(evaluate_radius, radius))));
+      densities.push_back(density);
    }
 
-   for(auto& future : futures)
+   // one task per (radius, density); each packed lattice runs 64
+   // replicas at once.
+   const int num_packs = (NUM_REPLICAS + PackedLattice::REPLICAS - 1) / PackedLattice::REPLICAS;
+   int max_radius = num_agents / 2;
+   EnsembleRunner runner;
+   auto results = runner.Run(max_radius * densities.size(), num_packs,
+                             [&densities](int parameter, int pack)
+                             {
+                                int radius  = parameter / densities.size() + 1;
+                                int density = parameter % densities.size();
+                                Philox gen(seed, parameter, pack);
+                                std::mt19937_64 lattice_gen(gen());
+
+                                PackedLattice lattice(num_agents, radius);
+                                lattice.SetDensity(densities[density], lattice_gen);
+                                int replicas = std::min(PackedLattice::REPLICAS,
+                                                        NUM_REPLICAS - pack * PackedLattice::REPLICAS);
+                                return evaluate_ca(lattice, replicas);
+                             });
+
+   for(int parameter = 0; parameter < results.size(); parameter++)
    {
-      for(auto& result : future.second.get())
+      int correct = 0;
+      for(int c : results[parameter])
       {
-         std::cout << future.first << " " << result.first << " " << result.second << std::endl;
+         correct += c;
       }
+      std::cout << parameter / densities.size() + 1 << " "
+                << densities[parameter % densities.size()] << " "
+                << (double)correct / (double)NUM_REPLICAS << std::endl;
    }
    return 0;
 }
@@ -61,7 +61,7 @@ std::vector<int> eval_network(const Rule& rule,
                               std::shared_ptr<Model> m,
                               const std::vector<int>& states)
 {
-   auto agents = m->GetAgents();
+   const AgentStore& agents = m->GetAgentStore();
    std::vector<int> new_states(states.size());
    for(int a = 0; a < states.size(); a++)
    {
@@ -72,7 +72,7 @@ std::vector<int> eval_network(const Rule& rule,
       for(int n : neighbors)
       {
          neighbor_states.push_back(states[n]);
-         neighbor_positions.push_back(agents[n].Position());
+         neighbor_positions.push_back(agents.Position(n));
       }
       new_states[a] = rule.Apply(states[a], neighbor_states);
    }
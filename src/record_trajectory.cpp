@@ -0,0 +1,50 @@
+#include "Model.hpp"
+#include "LCAFactory.hpp"
+#include "Trajectory.hpp"
+
+#include <iostream>
+#include <cstdlib>
+
+/**
+ * Run one LCA and record every time step, including the interaction
+ * network, to a binary trajectory file.
+ *
+ * usage: record_trajectory [options] <file> [initial_density]
+ */
+int main(int argc, char** argv)
+{
+   LCAFactory factory;
+   int arg_index = factory.Init(argc, argv);
+   if(arg_index >= argc)
+   {
+      std::cout << "missing required argument <file>" << std::endl;
+      return -1;
+   }
+   std::string path = argv[arg_index];
+
+   double initial_density = 0.5;
+   if(arg_index + 1 < argc)
+   {
+      initial_density = atof(argv[arg_index + 1]);
+   }
+
+   std::unique_ptr<LCA> lca = factory.Create(initial_density);
+   lca->MinimizeMemory();
+
+   const Model& model = lca->GetModel();
+   TrajectoryWriter writer(path, model.GetStates().size(), factory.ArenaSize(), true);
+
+   // the stopping condition is checked before every step, so record
+   // the state there.
+   lca->Run([&writer, &model](const ModelStats& s)
+            {
+               writer.Write(model);
+               return s.IsConsensus();
+            });
+   if(writer.NumFrames() < lca->GetStats().GetDensityHistory().size())
+   {
+      writer.Write(model); // ran until the time limit
+   }
+
+   std::cout << writer.NumFrames() << " frames written to " << path << std::endl;
+}
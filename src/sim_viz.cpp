@@ -119,22 +119,22 @@ int main(int argc, char** argv)
          }
       }
 
-      if(!done && (lca->CurrentDensity() == 0.0 || lca->CurrentDensity() == 1.0))
+      if(!done && lca->GetStats().IsConsensus())
       {
          done = true;
          std::cout << "converged at " << i << std::endl;
       }
 
       window.clear(sf::Color::White);
-      const std::vector<Agent>& agents = lca->GetAgents();
+      const AgentStore& agents = lca->GetModel().GetAgentStore();
       const std::vector<int>& states  = lca->GetStates();
-      auto network = lca->CurrentNetwork();
-      for(int i = 0; i < agents.size(); i++)
+      auto network = lca->GetModel().StepNetwork();
+      for(int i = 0; i < agents.Size(); i++)
       {
-         Point agent_i_pos = agents[i].Position();
+         Point agent_i_pos = agents.Position(i);
          for(auto& a : network->GetNeighbors(i))
          {
-            Point agent_a_pos = agents[a].Position();
+            Point agent_a_pos = agents.Position(a);
             sf::VertexArray lines(sf::Lines, 2);
             lines[0].position = sf::Vector2f(agent_i_pos.GetX()-0.5, agent_i_pos.GetY()-0.5);
             lines[0].color    = sf::Color(0,0,0,64);
@@ -144,7 +144,7 @@ int main(int argc, char** argv)
          }
       }
 
-      for(int i = 0; i < agents.size(); i++)
+      for(int i = 0; i < agents.Size(); i++)
       {
          sf::CircleShape agent_shape(0.6);
          // TODO: Add black/white option
@@ -158,8 +158,8 @@ int main(int argc, char** argv)
          // {
          //    agent_shape.setFillColor(sf::Color::Black);
          // }
-         sf::Color agent_color = sf::Color::Black; // headingToColor(agents[i].GetHeading(), states[i]);
-         if(agents[i].IsDark())
+         sf::Color agent_color = sf::Color::Black; // headingToColor(agents.GetHeading(i), states[i]);
+         if(agents.IsDark(i))
             agent_color = sf::Color(120, 120, 120);
          agent_shape.setOutlineColor(agent_color);
          agent_shape.setOutlineThickness(0.4);
@@ -172,7 +172,7 @@ int main(int argc, char** argv)
             agent_shape.setFillColor(agent_color);
          }
          agent_shape.setOrigin(1,1);
-         agent_shape.setPosition(agents[i].Position().GetX(), agents[i].Position().GetY());
+         agent_shape.setPosition(agents.Position(i).GetX(), agents.Position(i).GetY());
          window.draw(agent_shape);
       }
       window.display();
@@ -92,7 +92,7 @@ result evaluate_ca(int num_iterations, double speed, double initial_density)
    for(step = 0; step < model_config.max_time; step++)
    {
       m.Step(&majority_rule);
-      if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
+      if(m.GetStats().IsConsensus())
       {
          break; // done. no need to keep evaluating.
       }
@@ -3,8 +3,6 @@
 #include <cstdlib>
 #include <functional>
 #include <cmath>
-#include <future>
-#include <thread> // hardware_concurrency()
 #include <chrono>
 #include <utility>
 #include <map>
@@ -13,6 +11,8 @@
 #include <getopt.h>
 
 #include "Model.hpp"
+#include "EnsembleRunner.hpp"
+#include "SweepCheckpoint.hpp"
 
 struct model_config
 {
@@ -27,82 +27,35 @@ struct model_config
    std::shared_ptr<MovementRule> movement_rule;
 } model_config;
 
-std::mutex speed_lock;
-double speed = 0;
 double max_speed = 300.0;
 double max_time  = 1000.0;
 
-std::mutex results_lock;
-std::map<double, double> results;
-
 bool synchronization = false;
 
-double next_speed()
-{
-   double s;
-
-   speed_lock.lock();
-
-   s = speed;
-   speed += 1.0;
-
-   speed_lock.unlock();
-
-   return s;
-}
-
-void record_result(double initial_density, double proportion_correct)
-{
-   results_lock.lock();
-   results.emplace(initial_density, proportion_correct);
-   results_lock.unlock();
-}
-
-double evaluate_ca(int num_iterations, double speed, double initial_density)
+bool evaluate_ca(int seed, double speed, double initial_density)
 {
-   int num_correct = 0;
-   for(int iteration = 0; iteration < num_iterations; iteration++)
+   Model m(model_config.arena_size,
+           model_config.num_agents,
+           model_config.communication_range,
+           seed,
+           initial_density,
+           speed);
+
+   // m.SetMovementRule(LevyWalk(model_config.mu, model_config.arena_size/speed));
+   m.SetMovementRule(model_config.movement_rule);
+   m.RecordNetworkDensityOnly();
+   m.SetNoise(model_config.noise);
+
+   for(int step = 0; step < max_time; step++)
    {
-      Model m(model_config.arena_size,
-              model_config.num_agents,
-              model_config.communication_range,
-              model_config.seed+iteration,
-              initial_density,
-              speed);
-
-      // m.SetMovementRule(LevyWalk(model_config.mu, model_config.arena_size/speed));
-      m.SetMovementRule(model_config.movement_rule);
-      m.RecordNetworkDensityOnly();
-      m.SetNoise(model_config.noise);
-
-      for(int step = 0; step < max_time; step++)
+      m.Step(model_config.rule);
+      if(m.GetStats().IsConsensus())
       {
-         m.Step(model_config.rule);
-         if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
-         {
-            break; // done. no need to keep evaluating.
-         }
-      }
-
-      if(m.GetStats().IsCorrect())
-      {
-         num_correct++;
+         break; // done. no need to keep evaluating.
       }
    }
 
-   return (double) num_correct / num_iterations;
-}
-
-void thread_main()
-{
-   double speed;
-   while((speed = next_speed()) <= max_speed)
-   {
-      double proportion_correct = evaluate_ca(model_config.num_iterations,
-                                              speed,
-                                              0.5);
-      record_result(speed, proportion_correct);
-   }
+   return m.GetStats().IsCorrect();
 }
 
 int main(int argc, char** argv)
@@ -112,6 +65,8 @@ int main(int argc, char** argv)
    double density_step    = 0.01;
    double initial_density = 0.0;
    int    save_state      = 0;
+   std::string checkpoint_path;
+   std::string signature = SweepCheckpoint::Signature(argc, argv);
 
    model_config.communication_range = 5;
    model_config.num_agents          = 100;
@@ -131,6 +86,7 @@ int main(int argc, char** argv)
          {"arena-size",          required_argument, 0,            'a'},
          {"seed",                required_argument, 0,            's'},
          {"iterations",          required_argument, 0,            'i'},
+         {"checkpoint",          required_argument, 0,            'K'},
          {"mu",                  required_argument, 0,            'm'},
          {"correlated",          required_argument, 0,            'c'},
          {"noise",               required_argument, 0,            'N'},
@@ -142,7 +98,7 @@ int main(int argc, char** argv)
 
    int option_index = 0;
 
-   while((opt_char = getopt_long(argc, argv, "m:d:r:n:a:s:i:c:R:",
+   while((opt_char = getopt_long(argc, argv, "m:d:r:n:a:s:i:c:R:K:",
                                  long_options, &option_index)) != -1)
    {
       switch(opt_char)
@@ -204,6 +160,10 @@ int main(int argc, char** argv)
          model_config.movement_rule = std::make_shared<CorrelatedRandomWalk>(atof(optarg));
          break;
 
+      case 'K':
+         checkpoint_path = optarg;
+         break;
+
       case ':':
          std::cout << "option " << long_options[option_index].name << "requires an argument" << std::endl;
          exit(-1);
@@ -215,22 +175,33 @@ int main(int argc, char** argv)
       }
    }
 
-   int max_threads = std::thread::hardware_concurrency();
-   std::vector<std::thread> threads;
-
-   for(int i = 0; i < max_threads; i++)
+   std::vector<double> speeds;
+   for(double speed = 0; speed <= max_speed; speed += 1.0)
    {
-      threads.push_back(std::thread(thread_main));
+      speeds.push_back(speed);
    }
 
-   for(auto& thread : threads)
+   std::unique_ptr<SweepCheckpoint> checkpoint;
+   if(!checkpoint_path.empty())
    {
-      thread.join();
+      checkpoint = std::make_unique<SweepCheckpoint>(checkpoint_path, signature, model_config.seed);
    }
 
+   EnsembleRunner runner;
+   auto correct = runner.Run(speeds.size(), model_config.num_iterations,
+                             [&speeds](int s, int iteration)
+                             {
+                                return evaluate_ca(model_config.seed + iteration, speeds[s], 0.5);
+                             }, checkpoint.get());
+
    // print the results
-   for(auto result : results)
+   for(int s = 0; s < speeds.size(); s++)
    {
-      std::cout << result.first << " " << result.second << std::endl;
+      int num_correct = 0;
+      for(bool c : correct[s])
+      {
+         num_correct += c;
+      }
+      std::cout << speeds[s] << " " << (double) num_correct / model_config.num_iterations << std::endl;
    }
 }
@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "Agent.hpp"
+#include "AgentStore.hpp"
+#include "MovementRule.hpp"
+
+class AgentStoreTest : public ::testing::Test
+{
+public:
+   /**
+    * Build n agents both as stand-alone Agents and in a store.
+    */
+   void Populate(int n, double speed, double arena_size,
+                 std::vector<Agent>& agents, AgentStore& store)
+      {
+         std::mt19937_64 gen(1234);
+         std::uniform_real_distribution<double> coordinate(-arena_size/2, arena_size/2);
+         std::uniform_real_distribution<double> heading(0, 2*M_PI);
+         for(int i = 0; i < n; i++)
+         {
+            double x = coordinate(gen);
+            Point p(x, coordinate(gen));
+            Heading h(heading(gen));
+            agents.push_back(Agent(p, h, speed, arena_size, i));
+            store.Add(p, h, i);
+         }
+      }
+
+   void ExpectSame(const std::vector<Agent>& agents, const AgentStore& store)
+      {
+         ASSERT_EQ(agents.size(), store.Size());
+         for(int i = 0; i < store.Size(); i++)
+         {
+            ASSERT_EQ(agents[i].Position(), store.Position(i));
+            ASSERT_EQ(agents[i].GetHeading(), store.GetHeading(i));
+            ASSERT_EQ(agents[i].GetPreviousHeading(), store.GetPreviousHeading(i));
+            ASSERT_EQ(agents[i].IsDark(), store.IsDark(i));
+         }
+      }
+
+   void RunBoth(double speed, std::shared_ptr<MovementRule> rule)
+      {
+         std::vector<Agent> agents;
+         AgentStore store(speed, 20);
+         Populate(100, speed, 20, agents, store);
+         store.SetMovementRule(rule);
+         for(int i = 0; i < agents.size(); i++)
+         {
+            agents[i].SetMovementRule(rule->Clone());
+            if(i % 7 == 0)
+            {
+               agents[i].GoDark();
+               store.GoDark(i);
+            }
+         }
+
+         for(int t = 0; t < 200; t++)
+         {
+            for(Agent& agent : agents)
+            {
+               agent.Step();
+            }
+            store.Step();
+            ExpectSame(agents, store);
+         }
+      }
+};
+
+TEST_F(AgentStoreTest, initialState)
+{
+   std::vector<Agent> agents;
+   AgentStore store(1, 10);
+   Populate(10, 1, 10, agents, store);
+   ExpectSame(agents, store);
+}
+
+TEST_F(AgentStoreTest, randomWalkMatchesAgent)
+{
+   RunBoth(1.0, std::make_shared<RandomWalk>());
+}
+
+TEST_F(AgentStoreTest, correlatedRandomWalkMatchesAgent)
+{
+   RunBoth(0.7, std::make_shared<CorrelatedRandomWalk>(0.3));
+}
+
+TEST_F(AgentStoreTest, levyWalkMatchesAgent)
+{
+   RunBoth(1.0, std::make_shared<LevyWalk>(1.5, 50));
+}
+
+TEST_F(AgentStoreTest, highSpeedMatchesAgent)
+{
+   // several reflections per step
+   RunBoth(55.0, std::make_shared<RandomWalk>());
+}
+
+TEST_F(AgentStoreTest, getAgentCopiesState)
+{
+   std::vector<Agent> agents;
+   AgentStore store(1, 10);
+   Populate(3, 1, 10, agents, store);
+   store.GoDark(1);
+   store.Step();
+   Agent a = store.GetAgent(1);
+   EXPECT_EQ(store.Position(1), a.Position());
+   EXPECT_EQ(store.GetHeading(1), a.GetHeading());
+   EXPECT_EQ(store.GetPreviousHeading(1), a.GetPreviousHeading());
+   EXPECT_TRUE(a.IsDark());
+}
+
+/**
+ * A rule the store has no specialized loop for.
+ */
+class TurnLeft : public MovementRule
+{
+public:
+   Heading Turn(const Point&, const Heading& h, std::mt19937_64&) override
+      {
+         return h + Heading(0.1);
+      }
+   Heading Turn(const Point&, const Heading& h, Philox&) override
+      {
+         return h + Heading(0.1);
+      }
+   std::shared_ptr<MovementRule> Clone() const override
+      {
+         return std::make_shared<TurnLeft>();
+      }
+};
+
+TEST_F(AgentStoreTest, customRuleMatchesAgent)
+{
+   RunBoth(1.0, std::make_shared<TurnLeft>());
+}
+
+TEST_F(AgentStoreTest, movementKinds)
+{
+   AgentStore store(1, 10);
+   EXPECT_EQ(AgentStore::MovementKind::Straight, store.GetMovementKind());
+   store.SetMovementRule(std::make_shared<RandomWalk>());
+   EXPECT_EQ(AgentStore::MovementKind::Random, store.GetMovementKind());
+   store.SetMovementRule(std::make_shared<CorrelatedRandomWalk>(0.2));
+   EXPECT_EQ(AgentStore::MovementKind::Correlated, store.GetMovementKind());
+   store.SetMovementRule(std::make_shared<LevyWalk>(2, 10));
+   EXPECT_EQ(AgentStore::MovementKind::Levy, store.GetMovementKind());
+   store.SetMovementRule(std::make_shared<TurnLeft>());
+   EXPECT_EQ(AgentStore::MovementKind::Custom, store.GetMovementKind());
+}
+
+/**
+ * A rule written before counter-based streams, turning only with a
+ * Mersenne twister.
+ */
+class TwisterOnlyTurnLeft : public MovementRule
+{
+public:
+   Heading Turn(const Point&, const Heading& h, std::mt19937_64&) override
+      {
+         return h + Heading(0.1);
+      }
+   std::shared_ptr<MovementRule> Clone() const override
+      {
+         return std::make_shared<TwisterOnlyTurnLeft>();
+      }
+};
+
+TEST_F(AgentStoreTest, counterRngRejectsRuleWithoutCounterTurn)
+{
+   // either order of set up fails before any agent moves
+   AgentStore store(1, 10);
+   store.SetMovementRule(std::make_shared<TwisterOnlyTurnLeft>());
+   EXPECT_THROW(store.UseCounterRng(1), std::logic_error);
+   EXPECT_FALSE(store.UsesCounterRng());
+
+   AgentStore counter_store(1, 10);
+   counter_store.UseCounterRng(1);
+   EXPECT_THROW(counter_store.SetMovementRule(std::make_shared<TwisterOnlyTurnLeft>()),
+                std::logic_error);
+   EXPECT_NO_THROW(counter_store.SetMovementRule(std::make_shared<TurnLeft>()));
+   EXPECT_NO_THROW(counter_store.SetMovementRule(std::make_shared<MovementRule>()));
+}
+
+TEST_F(AgentStoreTest, getAgentCopiesLevyState)
+{
+   std::vector<Agent> agents;
+   AgentStore store(1, 20);
+   Populate(20, 1, 20, agents, store);
+   store.SetMovementRule(std::make_shared<LevyWalk>(1.5, 20));
+   for(int t = 0; t < 7; t++)
+   {
+      store.Step();
+   }
+
+   // a copy taken mid-walk continues exactly like the store
+   agents = store.Agents();
+   for(int t = 0; t < 50; t++)
+   {
+      for(Agent& agent : agents)
+      {
+         agent.Step();
+      }
+      store.Step();
+      ExpectSame(agents, store);
+   }
+}
+
+TEST_F(AgentStoreTest, loadChecksRuleParametersAndSizes)
+{
+   std::vector<Agent> agents;
+   AgentStore saved(1, 20);
+   Populate(30, 1, 20, agents, saved);
+   saved.SetMovementRule(std::make_shared<LevyWalk>(1.5, 20));
+   saved.Step();
+   std::stringstream out;
+   saved.Save(out);
+   std::string bytes = out.str();
+
+   auto load = [this, &bytes](double speed, int n, std::shared_ptr<MovementRule> rule)
+      {
+         std::vector<Agent> agents;
+         AgentStore store(speed, 20);
+         Populate(n, speed, 20, agents, store);
+         store.SetMovementRule(rule);
+         std::stringstream in(bytes);
+         store.Load(in);
+         return store;
+      };
+
+   AgentStore loaded = load(1, 30, std::make_shared<LevyWalk>(1.5, 20));
+   for(int i = 0; i < 30; i++)
+   {
+      ASSERT_EQ(saved.Position(i), loaded.Position(i));
+   }
+   EXPECT_THROW(load(1, 30, std::make_shared<LevyWalk>(2.0, 20)), std::runtime_error);
+   EXPECT_THROW(load(1, 30, std::make_shared<LevyWalk>(1.5, 10)), std::runtime_error);
+   EXPECT_THROW(load(1, 29, std::make_shared<LevyWalk>(1.5, 20)), std::runtime_error);
+   EXPECT_THROW(load(1, 31, std::make_shared<LevyWalk>(1.5, 20)), std::runtime_error);
+
+   // a corrupt generator count is rejected before anything is allocated
+   const std::size_t header = 8 + 8 + 8 + 4 + 1 + 8 + 4 + 8 + 8 + 4;
+   const std::size_t vectors = 4 * (8 + 30 * sizeof(double)) + (8 + 30) +
+                               2 * (8 + 30 * sizeof(unsigned int));
+   std::uint64_t num_generators;
+   bytes.copy((char*)&num_generators, 8, header + vectors);
+   ASSERT_EQ(30u, num_generators);
+   num_generators = ~(std::uint64_t)0 / 2;
+   bytes.replace(header + vectors, 8, (const char*)&num_generators, 8);
+   EXPECT_THROW(load(1, 30, std::make_shared<LevyWalk>(1.5, 20)), std::runtime_error);
+
+   AgentStore walk(1, 20);
+   walk.SetMovementRule(std::make_shared<CorrelatedRandomWalk>(0.2));
+   std::stringstream walk_out;
+   walk.Save(walk_out);
+   AgentStore other_sigma(1, 20);
+   other_sigma.SetMovementRule(std::make_shared<CorrelatedRandomWalk>(0.3));
+   EXPECT_THROW(other_sigma.Load(walk_out), std::runtime_error);
+}
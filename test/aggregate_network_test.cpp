@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <algorithm>
+
+#include "AggregateNetwork.hpp"
+
+/**
+ * Add random snapshots to an AggregateNetwork and check it against
+ * the union of the snapshots.
+ */
+void CheckAgainstUnion(int num_vertices, int edges_per_snapshot)
+{
+   std::mt19937_64 gen(99);
+   std::uniform_int_distribution<int> vertex(0, num_vertices - 1);
+
+   AggregateNetwork aggregate(num_vertices);
+   NetworkSnapshot  expected(num_vertices);
+   for(int t = 0; t < 20; t++)
+   {
+      std::vector<std::pair<int,int>> edges;
+      for(int e = 0; e < edges_per_snapshot; e++)
+      {
+         int u = vertex(gen);
+         int v = vertex(gen);
+         if(u != v)
+         {
+            edges.push_back(std::make_pair(u, v));
+         }
+      }
+      NetworkSnapshot snapshot(num_vertices, edges);
+
+      int before = expected.EdgeCount();
+      expected.Union(snapshot);
+      EXPECT_EQ(expected.EdgeCount() - before, aggregate.Add(snapshot));
+
+      ASSERT_EQ(expected.EdgeCount(), aggregate.EdgeCount());
+      EXPECT_EQ(expected.Density(), aggregate.Density());
+      EXPECT_EQ(expected.AverageDegree(), aggregate.AverageDegree());
+      EXPECT_EQ(expected.DegreeVariance(), aggregate.DegreeVariance());
+      EXPECT_EQ(expected.MedianDegree(), aggregate.MedianDegree());
+   }
+
+   for(int u = 0; u < std::min(num_vertices, 200); u++)
+   {
+      EXPECT_EQ(expected.Degree(u), aggregate.Degree(u));
+      for(int v : expected.GetNeighbors(u))
+      {
+         EXPECT_TRUE(aggregate.HasEdge(u, v));
+         EXPECT_TRUE(aggregate.HasEdge(v, u));
+      }
+   }
+
+   std::vector<std::pair<int,int>> expected_edges;
+   for(int u = 0; u < num_vertices; u++)
+   {
+      for(int v : expected.GetNeighbors(u))
+      {
+         if(u < v)
+         {
+            expected_edges.push_back(std::make_pair(u, v));
+         }
+      }
+   }
+   std::vector<std::pair<int,int>> edges = aggregate.Edges();
+   std::sort(expected_edges.begin(), expected_edges.end());
+   std::sort(edges.begin(), edges.end());
+   EXPECT_EQ(expected_edges, edges);
+}
+
+TEST(AggregateNetworkTest, empty)
+{
+   AggregateNetwork aggregate(10);
+   EXPECT_EQ(0, aggregate.EdgeCount());
+   EXPECT_EQ(0.0, aggregate.Density());
+   EXPECT_EQ(0.0, aggregate.MedianDegree());
+   EXPECT_FALSE(aggregate.HasEdge(1, 2));
+}
+
+TEST(AggregateNetworkTest, matchesUnion)
+{
+   CheckAgainstUnion(10, 5);
+   CheckAgainstUnion(101, 300);
+   CheckAgainstUnion(129, 2000);
+}
+
+TEST(AggregateNetworkTest, matchesUnionWithoutMatrix)
+{
+   CheckAgainstUnion(AggregateNetwork::MAX_MATRIX_VERTICES + 1, 5000);
+}
+
+TEST(AggregateNetworkTest, rejectsWrongSize)
+{
+   AggregateNetwork aggregate(10);
+   EXPECT_THROW(aggregate.Add(NetworkSnapshot(11)), std::invalid_argument);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <cmath>
+
+#include "AliasTable.hpp"
+#include "MovementRule.hpp"
+
+TEST(AliasTableTest, probabilitiesMatchWeights)
+{
+   std::vector<double> weights = {1, 0, 3, 0.5, 2.5, 1};
+   AliasTable table(weights);
+   ASSERT_EQ(6, table.Size());
+   for(int i = 0; i < weights.size(); i++)
+   {
+      EXPECT_NEAR(weights[i] / 8.0, table.Probability(i), 1e-12);
+   }
+}
+
+TEST(AliasTableTest, samplesFollowWeights)
+{
+   std::vector<double> weights = {5, 1, 0, 2};
+   AliasTable table(weights);
+   std::mt19937_64 gen(1234);
+   std::vector<int> counts(weights.size(), 0);
+   const int n = 200000;
+   for(int i = 0; i < n; i++)
+   {
+      counts[table(gen)]++;
+   }
+   EXPECT_EQ(0, counts[2]);
+   for(int i = 0; i < weights.size(); i++)
+   {
+      EXPECT_THAT((double)counts[i] / n, ::testing::DoubleNear(weights[i] / 8.0, 0.005));
+   }
+}
+
+TEST(AliasTableTest, invalidWeights)
+{
+   EXPECT_THROW(AliasTable(std::vector<double>()), std::invalid_argument);
+   EXPECT_THROW(AliasTable(std::vector<double>({0, 0})), std::invalid_argument);
+   EXPECT_THROW(AliasTable(std::vector<double>({1, -1, 2})), std::invalid_argument);
+}
+
+/**
+ * Measure the number of steps between turns of a Levy walk.
+ */
+std::vector<double> LevyStepFrequencies(double mu, int max_step, int max_k)
+{
+   LevyWalk walk(mu, max_step);
+   std::mt19937_64 gen(42);
+   Point p(0, 0);
+   Heading h(0);
+   std::vector<double> counts(max_k + 1, 0);
+   int last_turn = 0;
+   int turns = 0;
+   for(int t = 1; t < 400000; t++)
+   {
+      Heading next = walk.Turn(p, h, gen);
+      if(next != h)
+      {
+         if(turns > 0 && t - last_turn <= max_k)
+         {
+            counts[t - last_turn]++;
+         }
+         turns++;
+         last_turn = t;
+         h = next;
+      }
+   }
+   for(double& c : counts)
+   {
+      c /= (turns - 1);
+   }
+   return counts;
+}
+
+TEST(AliasTableTest, levyStepLengthsFollowPowerLaw)
+{
+   const double mu = 2.0;
+   const int max_step = 50;
+   std::vector<double> frequencies = LevyStepFrequencies(mu, max_step, 5);
+
+   // floor of a continuous power law on [1, max_step)
+   double norm = 1 - pow(max_step, 1 - mu);
+   for(int k = 1; k <= 5; k++)
+   {
+      double expected = (pow(k, 1 - mu) - pow(k + 1, 1 - mu)) / norm;
+      EXPECT_THAT(frequencies[k], ::testing::DoubleNear(expected, 0.01)) << "k = " << k;
+   }
+}
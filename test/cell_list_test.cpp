@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <algorithm>
+
+#include "CellList.hpp"
+#include "Point.hpp"
+
+std::vector<std::pair<int,int>> all_pairs(const std::vector<Point>& points, double range)
+{
+   std::vector<std::pair<int,int>> pairs;
+   for(int i = 0; i < points.size(); i++)
+   {
+      for(int j = i+1; j < points.size(); j++)
+      {
+         if(points[i].Within(range, points[j]))
+         {
+            pairs.push_back(std::make_pair(i, j));
+         }
+      }
+   }
+   return pairs;
+}
+
+std::vector<Point> random_points(int n, double arena_size, int seed)
+{
+   std::mt19937_64 gen(seed);
+   std::uniform_real_distribution<double> coordinate(-arena_size/2, arena_size/2);
+   std::vector<Point> points;
+   for(int i = 0; i < n; i++)
+   {
+      double x = coordinate(gen);
+      points.push_back(Point(x, coordinate(gen)));
+   }
+   return points;
+}
+
+TEST(CellListTest, matchesAllPairs)
+{
+   for(double range : {0.5, 1.0, 5.0, 13.0, 60.0, 200.0})
+   {
+      std::vector<Point> points = random_points(500, 100, 1234);
+      CellList cells(100, range);
+      std::vector<std::pair<int,int>> pairs;
+      cells.Build(points);
+      cells.Pairs(points, pairs);
+      std::sort(pairs.begin(), pairs.end());
+      EXPECT_EQ(all_pairs(points, range), pairs);
+   }
+}
+
+TEST(CellListTest, pointsOnBoundary)
+{
+   std::vector<Point> points = {
+      Point(-5, -5), Point(5, 5), Point(-5, 5), Point(5, -5),
+      Point(5, 4), Point(-5, -4), Point(0, 0), Point(0, 5)
+   };
+   CellList cells(10, 1.0);
+   std::vector<std::pair<int,int>> pairs;
+   cells.Build(points);
+   cells.Pairs(points, pairs);
+   EXPECT_THAT(pairs, ::testing::UnorderedElementsAreArray(all_pairs(points, 1.0)));
+}
+
+TEST(CellListTest, zeroRange)
+{
+   std::vector<Point> points = { Point(1, 1), Point(1, 1), Point(2, 1) };
+   CellList cells(10, 0.0);
+   std::vector<std::pair<int,int>> pairs;
+   cells.Build(points);
+   cells.Pairs(points, pairs);
+   ASSERT_EQ(1, pairs.size());
+   EXPECT_EQ(std::make_pair(0, 1), pairs[0]);
+}
+
+TEST(CellListTest, gridIsBounded)
+{
+   CellList cells(100, 0.001);
+   cells.Build(random_points(16, 100, 42));
+   EXPECT_LE(cells.CellsPerSide(), 8);
+   EXPECT_GE(cells.CellsPerSide(), 1);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <getopt.h>
+
+#include "ConvergenceDetector.hpp"
+#include "LCAFactory.hpp"
+
+typedef ConvergenceDetector::Outcome Outcome;
+
+TEST(ConvergenceDetectorTest, consensusByDefault)
+{
+   ConvergenceDetector detector;
+   EXPECT_EQ(Outcome::Undecided, detector.Observe({0, 1, 1}, 2));
+   EXPECT_EQ(Outcome::Undecided, detector.Observe({0, 1, 1}, 2));
+   EXPECT_EQ(Outcome::Consensus, detector.Observe({1, 1, 1}, 3));
+   EXPECT_TRUE(detector.IsDecided());
+
+   // decided outcomes stick until reset.
+   EXPECT_EQ(Outcome::Consensus, detector.Observe({0, 1, 1}, 2));
+   detector.Reset();
+   EXPECT_FALSE(detector.IsDecided());
+   EXPECT_EQ(0, detector.Observed());
+
+   detector.DetectConsensus(false);
+   EXPECT_EQ(Outcome::Undecided, detector.Observe({0, 0, 0}, 0));
+}
+
+TEST(ConvergenceDetectorTest, fixedPoint)
+{
+   ConvergenceDetector detector;
+   detector.DetectCycles(3, 4);
+   detector.Observe({1, 0, 0}, 1);
+   for(int t = 0; t < 4; t++)
+   {
+      EXPECT_EQ(Outcome::Undecided, detector.Observe({0, 1, 0}, 1));
+   }
+   EXPECT_EQ(Outcome::FixedPoint, detector.Observe({0, 1, 0}, 1));
+   EXPECT_EQ(1, detector.Period());
+}
+
+TEST(ConvergenceDetectorTest, cycle)
+{
+   std::vector<std::vector<int>> cycle = {{1, 0, 0, 1}, {0, 1, 1, 0}, {0, 0, 1, 1}};
+   ConvergenceDetector detector;
+   detector.DetectCycles(4, 2);
+
+   // the first period, then 2 more periods of matches less one step.
+   int t = 0;
+   for(; t < 3 + 2 * 3 - 1; t++)
+   {
+      EXPECT_EQ(Outcome::Undecided, detector.Observe(cycle[t % 3], 2)) << t;
+   }
+   EXPECT_EQ(Outcome::Cycle, detector.Observe(cycle[t % 3], 2));
+   EXPECT_EQ(3, detector.Period());
+
+   // a change in the middle starts the count again.
+   detector.Reset();
+   for(t = 0; t < 7; t++)
+   {
+      detector.Observe(cycle[t % 3], 2);
+   }
+   detector.Observe({1, 1, 1, 0}, 3);
+   EXPECT_EQ(Outcome::Undecided, detector.Observe(cycle[t % 3], 2));
+}
+
+TEST(ConvergenceDetectorTest, plateau)
+{
+   // only the count of ones matters for a plateau.
+   std::vector<int> states(100);
+   ConvergenceDetector detector;
+   detector.DetectPlateau(3, 0.05);
+   EXPECT_EQ(Outcome::Undecided, detector.Observe(states, 30));
+   EXPECT_EQ(Outcome::Undecided, detector.Observe(states, 50));
+   EXPECT_EQ(Outcome::Undecided, detector.Observe(states, 52));
+   EXPECT_EQ(Outcome::Undecided, detector.Observe(states, 46));
+   EXPECT_EQ(Outcome::Undecided, detector.Observe(states, 49));
+   EXPECT_EQ(Outcome::Plateau, detector.Observe(states, 48));
+   EXPECT_STREQ("plateau", ConvergenceDetector::Name(detector.GetOutcome()));
+}
+
+TEST(ConvergenceDetectorTest, lcaStopsWhenDecided)
+{
+   // the default rule never changes a state, so the states are a fixed
+   // point from the start.
+   const char* argv[] = {"test", "--seed", "5", "--num-agents", "30", "--max-time", "500",
+                         "--max-period", "2", "--period-repeats", "6"};
+   LCAFactory factory;
+   optind = 1;
+   factory.Init(11, const_cast<char**>(argv));
+
+   std::unique_ptr<LCA> lca = factory.Create(0.5, 1);
+   EXPECT_EQ(6, lca->RunUntilDecided());
+   EXPECT_EQ(Outcome::FixedPoint, lca->GetConvergence().GetOutcome());
+
+   std::unique_ptr<LCA> consensus = factory.Create(1.0, 1);
+   EXPECT_EQ(0, consensus->RunUntilDecided());
+   EXPECT_EQ(Outcome::Consensus, consensus->GetConvergence().GetOutcome());
+
+   ConvergenceDetector never;
+   never.DetectConsensus(false);
+   lca->SetConvergence(never);
+   EXPECT_EQ(500, lca->RunUntilDecided());
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <getopt.h>
+
+#include "EnsembleRunner.hpp"
+
+TEST(EnsembleRunnerTest, resultsInOrder)
+{
+   EnsembleRunner runner(4);
+   auto results = runner.Run(7, 5, [](int p, int r)
+                             {
+                                // uneven task lengths so that threads steal work.
+                                std::this_thread::sleep_for(std::chrono::microseconds(100 * (p % 3)));
+                                return std::make_pair(p, r);
+                             });
+   ASSERT_EQ(7, results.size());
+   for(int p = 0; p < 7; p++)
+   {
+      ASSERT_EQ(5, results[p].size());
+      for(int r = 0; r < 5; r++)
+      {
+         EXPECT_EQ(std::make_pair(p, r), results[p][r]);
+      }
+   }
+}
+
+TEST(EnsembleRunnerTest, boolResults)
+{
+   EnsembleRunner runner(3);
+   auto results = runner.Run(10, 100, [](int p, int r) { return (p + r) % 2 == 0; });
+   for(int p = 0; p < 10; p++)
+   {
+      for(int r = 0; r < 100; r++)
+      {
+         EXPECT_EQ((p + r) % 2 == 0, results[p][r]);
+      }
+   }
+}
+
+TEST(EnsembleRunnerTest, factorySeedsAreReproducible)
+{
+   const char* argv[] = {"test", "--seed", "17", "--num-agents", "20", "--arena-size", "20", "--max-time", "20"};
+   LCAFactory factory;
+   optind = 1;
+   factory.Init(9, const_cast<char**>(argv));
+
+   std::vector<double> densities = {0.2, 0.5, 0.8};
+   auto final_states = [](LCA& lca)
+      {
+         lca.Run();
+         return lca.GetStates();
+      };
+
+   EnsembleRunner serial(1);
+   EnsembleRunner parallel(4);
+   auto expected = serial.Run(factory, densities, 6, final_states);
+   auto actual   = parallel.Run(factory, densities, 6, final_states);
+   EXPECT_EQ(expected, actual);
+
+   EXPECT_EQ(factory.Seed(1, 2), factory.Seed(1, 2));
+   EXPECT_NE(factory.Seed(1, 2), factory.Seed(2, 1));
+   EXPECT_EQ(expected[1][3], final_states(*factory.Create(0.5, factory.Seed(1, 3))));
+}
+
+TEST(EnsembleRunnerTest, resetLCAMatchesNewLCA)
+{
+   const char* argv[] = {"test", "--seed", "3", "--num-agents", "40", "--arena-size", "30",
+                         "--max-time", "30", "--by-position", "--counter-rng", "--verlet-skin", "1"};
+   LCAFactory factory;
+   optind = 1;
+   factory.Init(13, const_cast<char**>(argv));
+
+   std::unique_ptr<LCA> reused = factory.Create(0.8, factory.Seed(0, 0));
+   reused->StreamStats();
+   reused->Run();
+   factory.Reset(*reused, 0.4, factory.Seed(1, 0));
+
+   std::unique_ptr<LCA> fresh = factory.Create(0.4, factory.Seed(1, 0));
+   fresh->StreamStats();
+   EXPECT_EQ(fresh->GetStates(), reused->GetStates());
+   fresh->Run();
+   reused->Run();
+   EXPECT_EQ(fresh->GetStates(), reused->GetStates());
+   EXPECT_EQ(fresh->GetStats().IsCorrect(), reused->GetStats().IsCorrect());
+   EXPECT_EQ(fresh->GetStats().ElapsedTime(), reused->GetStats().ElapsedTime());
+   EXPECT_EQ(fresh->GetStats().RecentCADensity(3), reused->GetStats().RecentCADensity(3));
+}
+
+TEST(EnsembleRunnerTest, resumeFinishesSavedLCA)
+{
+   const char* argv[] = {"test", "--seed", "5", "--num-agents", "40", "--arena-size", "30",
+                         "--max-time", "30", "--counter-rng"};
+   LCAFactory factory;
+   optind = 1;
+   factory.Init(10, const_cast<char**>(argv));
+
+   std::unique_ptr<LCA> whole = factory.Create(0.6, factory.Seed(0, 0));
+   whole->Run();
+   EXPECT_EQ(30, whole->GetModel().Steps());
+
+   std::unique_ptr<LCA> first = factory.Create(0.6, factory.Seed(0, 0));
+   first->Run(12);
+   std::stringstream saved;
+   first->Save(saved);
+
+   std::unique_ptr<LCA> resumed = factory.Create(0.6, factory.Seed(0, 0));
+   resumed->Load(saved);
+   resumed->Resume();
+   EXPECT_EQ(30, resumed->GetModel().Steps());
+   EXPECT_EQ(whole->GetStates(), resumed->GetStates());
+   EXPECT_EQ(whole->GetStats().GetDensityHistory(), resumed->GetStats().GetDensityHistory());
+
+   // Run() always takes max_time steps, wherever the model starts
+   resumed->Run();
+   EXPECT_EQ(60, resumed->GetModel().Steps());
+}
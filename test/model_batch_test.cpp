@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include "ModelBatch.hpp"
+#include "Model.hpp"
+#include "LCA.hpp"
+#include "Rule.hpp"
+
+class ModelBatchTest : public ::testing::Test
+{
+public:
+   std::vector<int> seeds = {1, 22, 333, 4444, 55555};
+
+   /**
+    * Build one counter-based Model per seed with the same settings as
+    * the batch.
+    */
+   std::vector<Model> Models(double density, double noise, double p_dark)
+      {
+         std::vector<Model> models;
+         for(int seed : seeds)
+         {
+            Model m(20, 40, 5, seed, density);
+            m.UseCounterRng();
+            m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 10));
+            m.SetNoise(noise);
+            m.SetPDark(p_dark);
+            m.SetPInteractive(0.3);
+            models.push_back(m);
+         }
+         return models;
+      }
+
+   ModelBatch Batch(double density, double noise, double p_dark)
+      {
+         ModelBatch batch(20, 40, 5, seeds, density);
+         batch.SetMovementRule(std::make_shared<LevyWalk>(1.5, 10));
+         batch.SetNoise(noise);
+         batch.SetPDark(p_dark);
+         batch.SetPInteractive(0.3);
+         return batch;
+      }
+
+   void ExpectSame(const std::vector<Model>& models, const ModelBatch& batch)
+      {
+         for(int r = 0; r < models.size(); r++)
+         {
+            ASSERT_EQ(models[r].GetAgentStore().Positions(), batch.Positions(r));
+            ASSERT_EQ(models[r].GetStates(), batch.GetStates(r));
+            ASSERT_EQ(models[r].GetStats().GetDensityHistory(),
+                      batch.GetStats(r).GetDensityHistory());
+            ASSERT_EQ(models[r].GetStats().AverageAggregateDegree(),
+                      batch.GetStats(r).AverageAggregateDegree());
+            for(int i = 0; i < batch.NumAgents(); i++)
+            {
+               ASSERT_EQ(models[r].GetAgentStore().GetHeading(i), batch.Headings(r)[i]);
+            }
+         }
+      }
+};
+
+TEST_F(ModelBatchTest, replicasMatchCounterRngModels)
+{
+   MajorityRule rule;
+   std::vector<Model> models = Models(0.5, 0.1, 0.2);
+   ModelBatch batch = Batch(0.5, 0.1, 0.2);
+   batch.SetThreads(3);
+   ExpectSame(models, batch);
+   for(int t = 0; t < 30; t++)
+   {
+      for(Model& m : models)
+      {
+         m.Step(&rule);
+      }
+      batch.Step(&rule);
+      ExpectSame(models, batch);
+   }
+}
+
+TEST_F(ModelBatchTest, verletSearchMatchesModels)
+{
+   MajorityRule rule;
+   std::vector<Model> models = Models(0.5, 0.0, 0.1);
+   ModelBatch batch = Batch(0.5, 0.0, 0.1);
+   batch.SetNeighborSearch(NetworkBuilder::Method::Verlet);
+   batch.SetThreads(2);
+   for(Model& m : models)
+   {
+      m.SetNeighborSearch(Model::NeighborSearch::Verlet);
+   }
+   for(int t = 0; t < 30; t++)
+   {
+      for(Model& m : models)
+      {
+         m.Step(&rule);
+      }
+      batch.Step(&rule);
+      ExpectSame(models, batch);
+   }
+   for(int r = 0; r < seeds.size(); r++)
+   {
+      EXPECT_EQ(models[r].VerletRebuilds(), batch.VerletRebuilds(r));
+      EXPECT_EQ(models[r].CurrentOnes(), batch.CurrentOnes(r));
+   }
+}
+
+TEST_F(ModelBatchTest, negativeNoiseDropsMessages)
+{
+   MajorityRule rule;
+   std::vector<Model> models = Models(0.4, -0.2, 0.0);
+   ModelBatch batch = Batch(0.4, -0.2, 0.0);
+   for(int t = 0; t < 20; t++)
+   {
+      for(Model& m : models)
+      {
+         m.Step(&rule);
+      }
+      batch.Step(&rule);
+   }
+   ExpectSame(models, batch);
+}
+
+TEST_F(ModelBatchTest, stoppedReplicasAreFrozen)
+{
+   MajorityRule rule;
+   std::vector<Model> models = Models(0.5, 0.0, 0.0);
+   ModelBatch batch = Batch(0.5, 0.0, 0.0);
+
+   // stop each replica after a different number of steps
+   for(int t = 0; batch.NumActive() > 0; t++)
+   {
+      for(int r = 0; r < seeds.size(); r++)
+      {
+         if(batch.IsActive(r) && t == 2 * r + 1)
+         {
+            batch.Stop(r);
+         }
+      }
+      batch.Step(&rule);
+   }
+   std::vector<int> steps;
+   for(int r = 0; r < seeds.size(); r++)
+   {
+      steps.push_back(batch.Steps(r));
+   }
+   ASSERT_EQ(seeds.size(), steps.size());
+   EXPECT_EQ(0, batch.NumActive());
+   for(int r = 0; r < seeds.size(); r++)
+   {
+      EXPECT_FALSE(batch.IsActive(r));
+      EXPECT_EQ(2 * r + 1, steps[r]);
+      EXPECT_EQ(steps[r] + 1, batch.GetStats(r).GetDensityHistory().size());
+      for(int t = 0; t < steps[r]; t++)
+      {
+         models[r].Step(&rule);
+      }
+   }
+   ExpectSame(models, batch);
+}
+
+TEST_F(ModelBatchTest, runMatchesLCA)
+{
+   MajorityRule rule;
+   auto consensus = [](const ModelStats& stats)
+      {
+         return stats.CurrentCADensity() == 0.0 || stats.CurrentCADensity() == 1.0;
+      };
+   ModelBatch batch(20, 40, 5, seeds, 0.6);
+   std::vector<int> steps = batch.Run(&rule, 100, consensus);
+   for(int r = 0; r < seeds.size(); r++)
+   {
+      Model m(20, 40, 5, seeds[r], 0.6);
+      m.UseCounterRng();
+      LCA lca(m, std::make_shared<MajorityRule>(), 100);
+      EXPECT_EQ(lca.Run(consensus), steps[r]);
+      EXPECT_EQ(lca.GetStats().GetDensityHistory(), batch.GetStats(r).GetDensityHistory());
+   }
+}
+
+TEST_F(ModelBatchTest, invalidReplica)
+{
+   ModelBatch batch(20, 10, 5, seeds, 0.5);
+   EXPECT_THROW(batch.GetStates(5), std::out_of_range);
+   EXPECT_THROW(batch.Stop(-1), std::out_of_range);
+}
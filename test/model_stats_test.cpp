@@ -120,3 +120,72 @@ TEST_F(ModelStatsTest, medianAggregateDegreeNoEdges)
 {
    EXPECT_EQ(0.0, empty.MedianAggregateDegree());
 }
+
+TEST_F(ModelStatsTest, runningSummaries)
+{
+   EXPECT_EQ(0.1, stats.InitialCADensity());
+   EXPECT_EQ(0.1, stats.MinCADensity());
+   EXPECT_EQ(0.3, stats.MaxCADensity());
+   EXPECT_DOUBLE_EQ(0.2, stats.MeanCADensity());
+   EXPECT_EQ(0.2, stats.RecentCADensity(1));
+   EXPECT_THROW(stats.RecentCADensity(3), std::out_of_range);
+
+   EXPECT_EQ(1, stats_synchronized.FirstPassageTime(0));
+   EXPECT_EQ(2, stats_synchronized.FirstPassageTime(1));
+   EXPECT_EQ(-1, stats.FirstPassageTime(0));
+}
+
+TEST_F(ModelStatsTest, streamingKeepsRecentDensities)
+{
+   stats.Streaming(4);
+   EXPECT_TRUE(stats.IsStreaming());
+   EXPECT_EQ(0.3, stats.CurrentCADensity());
+   EXPECT_EQ(0.1, stats.RecentCADensity(2));
+
+   for(int t = 0; t < 1000; t++)
+   {
+      stats.PushState(t % 2, t0);
+   }
+   EXPECT_EQ(1003, stats.ElapsedTime());
+   EXPECT_EQ(1.0, stats.CurrentCADensity());
+   EXPECT_EQ(0.0, stats.RecentCADensity(3));
+   EXPECT_THROW(stats.RecentCADensity(4), std::out_of_range);
+   EXPECT_TRUE(stats.IsSynchronized());
+   EXPECT_EQ(0.1, stats.InitialCADensity());
+   EXPECT_EQ(0.0, stats.MinCADensity());
+   EXPECT_EQ(3, stats.FirstPassageTime(0));
+   EXPECT_EQ(4, stats.FirstPassageTime(1));
+
+   EXPECT_THROW(stats.GetDensityHistory(), std::logic_error);
+   EXPECT_THROW(stats.AverageAggregateDegree(), std::logic_error);
+   EXPECT_THROW(stats.GetNetwork(), std::logic_error);
+}
+
+TEST_F(ModelStatsTest, streamingClassification)
+{
+   stats_dense.Streaming();
+   EXPECT_FALSE(stats_dense.IsCorrect());
+   stats_dense.PushState(1.0, t0);
+   EXPECT_TRUE(stats_dense.IsCorrect());
+
+   empty.Streaming(3);
+   EXPECT_FALSE(empty.IsCorrect());
+   EXPECT_FALSE(empty.IsSynchronized());
+   EXPECT_THROW(empty.Streaming(2), std::invalid_argument);
+}
+
+TEST_F(ModelStatsTest, onesCount)
+{
+   empty.PushCount(3, t0);
+   EXPECT_EQ(3, empty.CurrentOnes());
+   EXPECT_EQ(0.3, empty.CurrentCADensity());
+   EXPECT_FALSE(empty.IsConsensus());
+   empty.PushCount(0, t1);
+   EXPECT_TRUE(empty.IsConsensus());
+   EXPECT_TRUE(empty.IsCorrect());
+
+   EXPECT_EQ(0, stats_zero.CurrentOnes());
+   EXPECT_TRUE(stats_zero.IsConsensus());
+   EXPECT_EQ(3, stats.CurrentOnes());
+   EXPECT_FALSE(stats.IsConsensus());
+}
@@ -1,7 +1,11 @@
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <sstream>
+
 #include "Model.hpp"
 #include "Rule.hpp"
+#include "TotalisticRule.hpp"
 
 class ModelTest : public ::testing::Test
 {
@@ -195,3 +199,349 @@ TEST_F(ModelTest, agentSpeedHigh)
       }
    }
 }
+
+TEST_F(ModelTest, neighborSearchMethodsAgree)
+{
+   Model cell_list(100, 500, 5.0, 1234, 0.5);
+   Model all_pairs(100, 500, 5.0, 1234, 0.5);
+   Model verlet(100, 500, 5.0, 1234, 0.5);
+   all_pairs.SetNeighborSearch(Model::NeighborSearch::AllPairs);
+   verlet.SetNeighborSearch(Model::NeighborSearch::Verlet);
+   for(int i = 0; i < 20; i++)
+   {
+      ASSERT_EQ(*cell_list.CurrentNetwork(), *all_pairs.CurrentNetwork());
+      ASSERT_EQ(*cell_list.CurrentNetwork(), *verlet.CurrentNetwork());
+      ASSERT_EQ(*cell_list.CurrentNetwork(), *cell_list.StepNetwork());
+      ASSERT_EQ(*verlet.CurrentNetwork(), *verlet.StepNetwork());
+      cell_list.Step(&majority_rule);
+      all_pairs.Step(&majority_rule);
+      verlet.Step(&majority_rule);
+      ASSERT_EQ(cell_list.GetStates(), all_pairs.GetStates());
+      ASSERT_EQ(cell_list.GetStates(), verlet.GetStates());
+   }
+}
+
+TEST_F(ModelTest, currentNetworkLeavesVerletListAlone)
+{
+   Model original(100, 500, 5.0, 1234, 0.5);
+   original.SetNeighborSearch(Model::NeighborSearch::Verlet);
+   for(int i = 0; i < 30; i++)
+   {
+      original.Step(&majority_rule);
+   }
+   std::stringstream saved;
+   original.Save(saved);
+
+   // the loaded agents are far from where the candidates were built.
+   Model queried(100, 500, 5.0, 1234, 0.5);
+   queried.SetNeighborSearch(Model::NeighborSearch::Verlet);
+   queried.Load(saved);
+   int rebuilds = queried.VerletRebuilds();
+   EXPECT_EQ(*original.StepNetwork(), *queried.CurrentNetwork());
+   EXPECT_EQ(rebuilds, queried.VerletRebuilds());
+   queried.Step(&majority_rule);
+   original.Step(&majority_rule);
+   EXPECT_EQ(rebuilds + 1, queried.VerletRebuilds());
+   EXPECT_EQ(*original.StepNetwork(), *queried.StepNetwork());
+}
+
+/**
+ * Majority rule that hides its count-based entry point, forcing
+ * Model::Step to build the neighbor state vector.
+ */
+class VectorMajority : public Rule
+{
+   MajorityRule majority;
+public:
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return majority.Apply(self, neighbors);
+      }
+};
+
+TEST_F(ModelTest, countAndVectorRulesAgree)
+{
+   VectorMajority vector_majority;
+   Model counted(50, 200, 5.0, 4321, 0.5);
+   Model vectored(50, 200, 5.0, 4321, 0.5);
+   counted.SetNoise(0.05);
+   vectored.SetNoise(0.05);
+   for(int i = 0; i < 50; i++)
+   {
+      counted.Step(&majority_rule);
+      vectored.Step(&vector_majority);
+      ASSERT_EQ(counted.GetStates(), vectored.GetStates());
+   }
+}
+
+TEST_F(ModelTest, counterRngIsReproducible)
+{
+   Model a(50, 200, 5.0, 4321, 0.5);
+   Model b(50, 200, 5.0, 4321, 0.5);
+   a.UseCounterRng();
+   b.UseCounterRng();
+   a.SetMovementRule(std::make_shared<LevyWalk>(1.6, 30));
+   b.SetMovementRule(std::make_shared<LevyWalk>(1.6, 30));
+   a.SetNoise(0.05);
+   b.SetNoise(0.05);
+   a.SetPDark(0.1);
+   b.SetPDark(0.1);
+   a.SetPInteractive(0.2);
+   b.SetPInteractive(0.2);
+   for(int i = 0; i < 50; i++)
+   {
+      a.Step(&majority_rule);
+      b.Step(&majority_rule);
+      ASSERT_EQ(a.GetStates(), b.GetStates());
+   }
+   std::vector<Agent> agents_a = a.GetAgents();
+   std::vector<Agent> agents_b = b.GetAgents();
+   for(int i = 0; i < agents_a.size(); i++)
+   {
+      EXPECT_EQ(agents_a[i].Position(), agents_b[i].Position());
+   }
+}
+
+TEST_F(ModelTest, threadedStepMatchesSerial)
+{
+   for(bool counter_rng : {false, true})
+   {
+      Model serial(100, 1000, 5.0, 2468, 0.5);
+      Model threaded(100, 1000, 5.0, 2468, 0.5);
+      threaded.SetThreads(4);
+      for(Model* m : {&serial, &threaded})
+      {
+         if(counter_rng)
+         {
+            m->UseCounterRng();
+         }
+         m->SetMovementRule(std::make_shared<CorrelatedRandomWalk>(0.4));
+         m->SetNoise(0.05);
+         m->SetPInteractive(0.5);
+         m->SetPDark(0.1);
+      }
+      for(int i = 0; i < 30; i++)
+      {
+         serial.Step(&majority_rule);
+         threaded.Step(&majority_rule);
+         ASSERT_EQ(serial.GetStates(), threaded.GetStates());
+      }
+      for(int i = 0; i < 1000; i++)
+      {
+         ASSERT_EQ(serial.GetAgentStore().Position(i), threaded.GetAgentStore().Position(i));
+         ASSERT_EQ(serial.GetAgentStore().GetHeading(i), threaded.GetAgentStore().GetHeading(i));
+      }
+   }
+}
+
+TEST_F(ModelTest, streamingStatsDoNotChangeTheRun)
+{
+   Model full(50, 200, 5.0, 2468, 0.45);
+   Model streaming(50, 200, 5.0, 2468, 0.45);
+   streaming.StreamStats(5);
+   for(int i = 0; i < 40; i++)
+   {
+      full.Step(&majority_rule);
+      streaming.Step(&majority_rule);
+      ASSERT_EQ(full.GetStates(), streaming.GetStates());
+      ASSERT_EQ(full.GetStats().CurrentCADensity(), streaming.GetStats().CurrentCADensity());
+   }
+   EXPECT_EQ(full.GetStats().IsCorrect(), streaming.GetStats().IsCorrect());
+   EXPECT_EQ(full.GetStats().ElapsedTime(), streaming.GetStats().ElapsedTime());
+   EXPECT_EQ(full.GetStats().GetDensityHistory()[36], streaming.GetStats().RecentCADensity(4));
+}
+
+TEST_F(ModelTest, onesCountFollowsTheStates)
+{
+   for(bool counter_rng : {false, true})
+   {
+      Model m(100, 500, 5.0, 1357, 0.5);
+      m.SetThreads(4);
+      if(counter_rng)
+      {
+         m.UseCounterRng();
+      }
+      m.SetNoise(0.1);
+      m.SetPInteractive(0.5);
+      for(int i = 0; i < 30; i++)
+      {
+         m.Step(&majority_rule);
+         const std::vector<int>& states = m.GetStates();
+         int ones = std::count(states.begin(), states.end(), 1);
+         ASSERT_EQ(ones, m.CurrentOnes());
+         ASSERT_EQ(ones, m.GetStats().CurrentOnes());
+         ASSERT_EQ((double)ones / states.size(), m.CurrentDensity());
+      }
+   }
+
+   Model m(100, 50, 5.0, 1357, 0.5);
+   m.SetPositionalState(0.2);
+   EXPECT_EQ(std::count(m.GetStates().begin(), m.GetStates().end(), 1), m.CurrentOnes());
+   EXPECT_FALSE(m.GetStats().IsConsensus());
+   m.Step(&always_one);
+   EXPECT_EQ(50, m.CurrentOnes());
+   EXPECT_TRUE(m.GetStats().IsConsensus());
+}
+
+TEST_F(ModelTest, packedStatesMatchNeighborLists)
+{
+   // dense enough for the packed states: every agent has about 200
+   // neighbors. Only the Verlet search keeps the adjacency rows.
+   std::istringstream rule_file(
+      "@ + [0.0, 0.3] -> 1, 17\n"
+      "1 + [0.3, 0.55] -> 0, 137.5\n"
+      "0 + [0.3, 0.55] -> 1, 137.5\n"
+      "1 + [0.55, 1.0] -> 1, 1\n"
+      "0 + [0.55, 1.0] -> 0, -1\n");
+   TotalisticRule rule;
+   rule_file >> rule;
+
+   Model packed(20, 300, 10.0, 97531, 0.5);
+   Model lists(20, 300, 10.0, 97531, 0.5);
+   lists.UsePackedStates(false);
+   for(Model* m : {&packed, &lists})
+   {
+      m->SetNeighborSearch(Model::NeighborSearch::Verlet);
+      m->UseCounterRng();
+      m->SetThreads(3);
+      m->SetPInteractive(0.5);
+      m->SetPDark(0.2);
+   }
+   for(int i = 0; i < 20; i++)
+   {
+      packed.Step(&rule);
+      lists.Step(&rule);
+      ASSERT_EQ(lists.GetStates(), packed.GetStates());
+      ASSERT_EQ(lists.CurrentOnes(), packed.CurrentOnes());
+      packed.Step(&majority_rule);
+      lists.Step(&majority_rule);
+      ASSERT_EQ(lists.GetStates(), packed.GetStates());
+   }
+}
+
+TEST_F(ModelTest, resetMatchesNewModel)
+{
+   auto configure = [](Model& m, bool counter_rng)
+      {
+         if(counter_rng)
+         {
+            m.UseCounterRng();
+            m.SetThreads(3);
+            m.SetNeighborSearch(Model::NeighborSearch::Verlet);
+         }
+         m.SetMovementRule(std::make_shared<LevyWalk>(2.0, 10));
+         m.SetNoise(0.05);
+         m.SetPDark(0.1);
+         m.SetPInteractive(0.5);
+      };
+   for(bool counter_rng : {false, true})
+   {
+      Model reused(60, 150, 8.0, 1111, 0.3, 0.5);
+      configure(reused, counter_rng);
+      for(int i = 0; i < 10; i++)
+      {
+         reused.Step(&majority_rule);
+      }
+      reused.Reset(2222, 0.6);
+
+      Model fresh(60, 150, 8.0, 2222, 0.6, 0.5);
+      configure(fresh, counter_rng);
+      EXPECT_EQ(0, reused.Steps());
+      EXPECT_EQ(fresh.GetStates(), reused.GetStates());
+      EXPECT_EQ(1, reused.GetStats().ElapsedTime());
+      for(int i = 0; i < 25; i++)
+      {
+         fresh.Step(&majority_rule);
+         reused.Step(&majority_rule);
+         ASSERT_EQ(fresh.GetStates(), reused.GetStates());
+         ASSERT_EQ(*fresh.CurrentNetwork(), *reused.CurrentNetwork());
+      }
+      for(int i = 0; i < 150; i++)
+      {
+         ASSERT_EQ(fresh.GetAgentStore().Position(i), reused.GetAgentStore().Position(i));
+      }
+      EXPECT_EQ(fresh.GetStats().GetDensityHistory(), reused.GetStats().GetDensityHistory());
+      EXPECT_EQ(fresh.GetStats().AverageAggregateDegree(), reused.GetStats().AverageAggregateDegree());
+   }
+}
+
+TEST_F(ModelTest, loadedModelContinuesTheRun)
+{
+   for(bool counter_rng : {false, true})
+   {
+      for(std::shared_ptr<MovementRule> rule : {std::shared_ptr<MovementRule>(std::make_shared<CorrelatedRandomWalk>(0.4)),
+                                                std::shared_ptr<MovementRule>(std::make_shared<LevyWalk>(1.5, 20))})
+      {
+         auto make = [counter_rng, rule]()
+            {
+               Model m(50, 200, 5.0, 1357, 0.5);
+               if(counter_rng)
+               {
+                  m.UseCounterRng();
+               }
+               m.SetMovementRule(rule);
+               m.SetPDark(0.1);
+               return m;
+            };
+
+         Model original = make();
+         original.SetNoise(0.05);
+         original.SetPInteractive(0.5);
+         for(int i = 0; i < 15; i++)
+         {
+            original.Step(&majority_rule);
+         }
+
+         std::stringstream saved;
+         original.Save(saved);
+         Model restored = make();
+         restored.Load(saved);
+         EXPECT_EQ(15, restored.Steps());
+         EXPECT_EQ(*original.StepNetwork(), *restored.StepNetwork());
+         EXPECT_EQ(original.GetStats().GetDensityHistory(), restored.GetStats().GetDensityHistory());
+         EXPECT_EQ(original.GetStats().AggregateDensityHistory(), restored.GetStats().AggregateDensityHistory());
+         EXPECT_EQ(*original.GetStats().GetNetwork().GetSnapshot(7),
+                   *restored.GetStats().GetNetwork().GetSnapshot(7));
+
+         for(int i = 0; i < 25; i++)
+         {
+            original.Step(&majority_rule);
+            restored.Step(&majority_rule);
+            ASSERT_EQ(original.GetStates(), restored.GetStates());
+         }
+         for(int i = 0; i < 200; i++)
+         {
+            ASSERT_EQ(original.GetAgentStore().Position(i), restored.GetAgentStore().Position(i));
+            ASSERT_EQ(original.GetAgentStore().GetHeading(i), restored.GetAgentStore().GetHeading(i));
+            ASSERT_EQ(original.GetAgentStore().IsDark(i), restored.GetAgentStore().IsDark(i));
+         }
+         EXPECT_EQ(original.GetStats().AverageAggregateDegree(), restored.GetStats().AverageAggregateDegree());
+      }
+   }
+}
+
+TEST_F(ModelTest, loadRejectsMismatchedModels)
+{
+   Model original(50, 200, 5.0, 1357, 0.5);
+   original.SetMovementRule(std::make_shared<RandomWalk>());
+   original.Step(&majority_rule);
+   std::stringstream saved;
+   original.Save(saved);
+   std::string bytes = saved.str();
+
+   Model fewer_agents(50, 100, 5.0, 1357, 0.5);
+   fewer_agents.SetMovementRule(std::make_shared<RandomWalk>());
+   std::stringstream in(bytes);
+   EXPECT_THROW(fewer_agents.Load(in), std::runtime_error);
+
+   Model other_rule(50, 200, 5.0, 1357, 0.5);
+   std::stringstream in2(bytes);
+   EXPECT_THROW(other_rule.Load(in2), std::runtime_error);
+   EXPECT_EQ(0, other_rule.Steps());
+
+   Model truncated(50, 200, 5.0, 1357, 0.5);
+   truncated.SetMovementRule(std::make_shared<RandomWalk>());
+   std::stringstream in3(bytes.substr(0, bytes.size() / 2));
+   EXPECT_THROW(truncated.Load(in3), std::runtime_error);
+   EXPECT_EQ(0, truncated.Steps());
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <cmath>
+
+#include "NetworkBuilder.hpp"
+#include "Point.hpp"
+
+namespace
+{
+   std::vector<Point> RandomPoints(int n, double arena_size, std::mt19937_64& gen)
+   {
+      std::uniform_real_distribution<double> coordinate(-arena_size / 2, arena_size / 2);
+      std::vector<Point> points;
+      for(int i = 0; i < n; i++)
+      {
+         double x = coordinate(gen);
+         points.push_back(Point(x, coordinate(gen)));
+      }
+      return points;
+   }
+
+   /**
+    * Move every point a distance step in a random direction, staying
+    * in the arena.
+    */
+   void Jitter(std::vector<Point>& points, double step, double arena_size, std::mt19937_64& gen)
+   {
+      std::uniform_real_distribution<double> angle(0, 2*M_PI);
+      for(Point& p : points)
+      {
+         double a = angle(gen);
+         double x = std::max(-arena_size / 2, std::min(arena_size / 2, p.GetX() + step * cos(a)));
+         double y = std::max(-arena_size / 2, std::min(arena_size / 2, p.GetY() + step * sin(a)));
+         p = Point(x, y);
+      }
+   }
+
+   void ExpectRowsMatch(const NetworkSnapshot& network, const BitMatrix& adjacency)
+   {
+      ASSERT_EQ(network.Size(), adjacency.Size());
+      for(int i = 0; i < network.Size(); i++)
+      {
+         std::vector<bool> neighbor(network.Size(), false);
+         for(int j : network.GetNeighbors(i))
+         {
+            neighbor[j] = true;
+         }
+         for(int j = 0; j < network.Size(); j++)
+         {
+            ASSERT_EQ(neighbor[j], adjacency.Test(i, j)) << "(" << i << ", " << j << ")";
+         }
+      }
+   }
+}
+
+TEST(NetworkBuilderTest, verletKeepsAdjacencyRows)
+{
+   // a mean degree of about 65, above the threshold for 300 points.
+   std::mt19937_64 gen(2468);
+   std::vector<Point> points = RandomPoints(300, 30, gen);
+   NetworkBuilder builder(30, 8, 1.0);
+   builder.SetMethod(NetworkBuilder::Method::Verlet);
+   builder.KeepAdjacency(true);
+
+   ThreadPool pool(3);
+   for(int t = 0; t < 60; t++)
+   {
+      std::shared_ptr<NetworkSnapshot> network = (t % 2) ? builder.Build(points) : builder.Build(points, pool);
+      ASSERT_NE(nullptr, builder.Adjacency());
+      ASSERT_EQ(*builder.Search(points), *network) << "step " << t;
+      ExpectRowsMatch(*network, *builder.Adjacency());
+      if(testing::Test::HasFatalFailure())
+      {
+         FAIL() << "step " << t;
+      }
+      Jitter(points, 0.1, 30, gen);
+   }
+   EXPECT_GT(builder.VerletRebuilds(), 1);
+   EXPECT_LT(builder.VerletRebuilds(), 30);
+
+   // replaced points are found from scratch.
+   builder.Clear();
+   points = RandomPoints(300, 30, gen);
+   std::shared_ptr<NetworkSnapshot> network = builder.Build(points, pool);
+   EXPECT_EQ(*builder.Search(points), *network);
+   ExpectRowsMatch(*network, *builder.Adjacency());
+
+   builder.KeepAdjacency(false);
+   builder.Build(points, pool);
+   EXPECT_EQ(nullptr, builder.Adjacency());
+}
+
+TEST(NetworkBuilderTest, adjacencyOnlyForDenseVerletNetworks)
+{
+   std::mt19937_64 gen(1357);
+   std::vector<Point> points = RandomPoints(300, 30, gen);
+   ThreadPool pool(1);
+
+   NetworkBuilder cells(30, 8, 1.0);
+   cells.KeepAdjacency(true);
+   cells.Build(points, pool);
+   EXPECT_EQ(nullptr, cells.Adjacency());
+
+   // a mean degree of about 1.
+   NetworkBuilder sparse(30, 1, 1.0);
+   sparse.SetMethod(NetworkBuilder::Method::Verlet);
+   sparse.KeepAdjacency(true);
+   sparse.Build(points, pool);
+   EXPECT_EQ(nullptr, sparse.Adjacency());
+}
@@ -224,3 +224,55 @@ TEST_F(NetworkTest, snapshotUnion)
 
    ASSERT_EQ(u, snapshot_final);
 }
+
+TEST_F(NetworkTest, bulkConstructionMatchesAddEdge)
+{
+   std::vector<std::pair<int,int>> edges = { {3,1}, {0,9}, {1,3}, {4,5}, {9,2}, {0,1} };
+   NetworkSnapshot bulk(10, edges);
+   NetworkSnapshot incremental(10);
+   for(auto& e : edges)
+   {
+      incremental.AddEdge(e.first, e.second);
+   }
+   EXPECT_EQ(bulk, incremental);
+   EXPECT_EQ(5, bulk.EdgeCount());
+   EXPECT_EQ(2, bulk.Degree(1));
+}
+
+TEST_F(NetworkTest, neighborsAreSorted)
+{
+   NetworkSnapshot s(6);
+   s.AddEdge(2,5);
+   s.AddEdge(2,0);
+   s.AddEdge(4,2);
+   auto neighbors = s.GetNeighbors(2);
+   ASSERT_EQ(3, neighbors.size());
+   EXPECT_EQ(0, neighbors[0]);
+   EXPECT_EQ(4, neighbors[1]);
+   EXPECT_EQ(5, neighbors[2]);
+}
+
+TEST_F(NetworkTest, setEdgesRejectsInvalidEdges)
+{
+   NetworkSnapshot s(4, {{0,1}});
+   EXPECT_THROW(s.SetEdges({{0,2}, {3,3}}), std::out_of_range);
+   EXPECT_EQ(NetworkSnapshot(4, {{0,1}}), s);
+   EXPECT_THROW(s.AddEdge(0,4), std::out_of_range);
+}
+
+TEST_F(NetworkTest, setAdjacencyMatchesSetEdges)
+{
+   // rows spanning more than one word.
+   std::vector<std::pair<int,int>> edges = { {0,1}, {0,64}, {3,99}, {63,64}, {64,130}, {129,130} };
+   BitMatrix adjacency(131);
+   for(auto& e : edges)
+   {
+      adjacency.Set(e.first, e.second);
+      adjacency.Set(e.second, e.first);
+   }
+   NetworkSnapshot s(131, {{5,6}});
+   s.SetAdjacency(adjacency);
+   EXPECT_EQ(NetworkSnapshot(131, edges), s);
+   EXPECT_EQ(6, s.EdgeCount());
+   EXPECT_THROW(s.SetAdjacency(BitMatrix(130)), std::invalid_argument);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+
+#include "PackedLattice.hpp"
+#include "Rule.hpp"
+
+/**
+ * Step a ring lattice one cell at a time with MajorityRule.
+ */
+std::vector<int> ReferenceStep(const std::vector<int>& states, int radius, const MajorityRule& rule)
+{
+   int n = states.size();
+   std::vector<int> next(n);
+   for(int i = 0; i < n; i++)
+   {
+      std::set<int> neighbors;
+      for(int j = i - radius; j <= i + radius; j++)
+      {
+         int cell = ((j % n) + n) % n;
+         if(cell != i)
+         {
+            neighbors.insert(cell);
+         }
+      }
+      int ones = 0;
+      for(int cell : neighbors)
+      {
+         ones += states[cell];
+      }
+      next[i] = rule.ApplyCount(states[i], ones, neighbors.size()).first;
+   }
+   return next;
+}
+
+void CheckAgainstReference(int num_cells, int radius, bool flip)
+{
+   MajorityRule rule(flip);
+   PackedLattice lattice(num_cells, radius, flip);
+   std::mt19937_64 gen(num_cells * 100 + radius);
+   lattice.SetDensity(0.5, gen);
+
+   std::vector<std::vector<int>> expected;
+   for(int r = 0; r < PackedLattice::REPLICAS; r++)
+   {
+      expected.push_back(lattice.GetStates(r));
+   }
+
+   for(int t = 0; t < 20; t++)
+   {
+      lattice.Step();
+      for(int r = 0; r < PackedLattice::REPLICAS; r++)
+      {
+         std::vector<int> next = ReferenceStep(expected[r], radius, rule);
+         bool changed = next != expected[r];
+         expected[r] = next;
+         ASSERT_EQ(expected[r], lattice.GetStates(r))
+            << "cells " << num_cells << " radius " << radius << " replica " << r << " step " << t;
+         if(t > 0)
+         {
+            EXPECT_EQ(changed, (lattice.Changing() >> r) & 1);
+         }
+      }
+   }
+}
+
+TEST(PackedLatticeTest, matchesMajorityRule)
+{
+   for(bool flip : {true, false})
+   {
+      CheckAgainstReference(127, 1, flip);
+      CheckAgainstReference(127, 7, flip);
+      CheckAgainstReference(127, 63, flip);
+      CheckAgainstReference(10, 3, flip);
+      CheckAgainstReference(10, 5, flip); // neighborhood wraps onto itself
+   }
+}
+
+TEST(PackedLatticeTest, setAndGetStates)
+{
+   PackedLattice lattice(5, 1);
+   std::vector<int> states = {1, 0, 1, 1, 0};
+   lattice.SetStates(17, states);
+   EXPECT_EQ(states, lattice.GetStates(17));
+   EXPECT_EQ(3, lattice.Ones(17));
+   EXPECT_EQ(0.6, lattice.GetDensity(17));
+   EXPECT_EQ(0, lattice.Ones(16));
+   EXPECT_THROW(lattice.SetStates(64, states), std::out_of_range);
+}
+
+TEST(PackedLatticeTest, consensusIsFixed)
+{
+   PackedLattice lattice(50, 3);
+   lattice.SetStates(0, std::vector<int>(50, 1));
+   lattice.Step();
+   lattice.Step();
+   EXPECT_EQ(0u, lattice.Changing() & 1);
+   EXPECT_EQ(50, lattice.Ones(0));
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "Philox.hpp"
+
+/**
+ * Known-answer vectors for Philox4x32-10 from the Random123 library.
+ */
+TEST(PhiloxTest, knownAnswers)
+{
+   std::uint32_t out[4];
+
+   const std::uint32_t zero_key[2] = {0, 0};
+   const std::uint32_t zero_ctr[4] = {0, 0, 0, 0};
+   Philox::Block(zero_key, zero_ctr, out);
+   EXPECT_EQ(0x6627e8d5u, out[0]);
+   EXPECT_EQ(0xe169c58du, out[1]);
+   EXPECT_EQ(0xbc57ac4cu, out[2]);
+   EXPECT_EQ(0x9b00dbd8u, out[3]);
+
+   const std::uint32_t ones_key[2] = {0xffffffff, 0xffffffff};
+   const std::uint32_t ones_ctr[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+   Philox::Block(ones_key, ones_ctr, out);
+   EXPECT_EQ(0x408f276du, out[0]);
+   EXPECT_EQ(0x41c83b0eu, out[1]);
+   EXPECT_EQ(0xa20bc7c6u, out[2]);
+   EXPECT_EQ(0x6d5451fdu, out[3]);
+
+   const std::uint32_t pi_key[2] = {0xa4093822, 0x299f31d0};
+   const std::uint32_t pi_ctr[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+   Philox::Block(pi_key, pi_ctr, out);
+   EXPECT_EQ(0xd16cfe09u, out[0]);
+   EXPECT_EQ(0x94fdccebu, out[1]);
+   EXPECT_EQ(0x5001e420u, out[2]);
+   EXPECT_EQ(0x24126ea1u, out[3]);
+}
+
+TEST(PhiloxTest, sameStreamSameOutput)
+{
+   Philox a(42, 7, 3, 1);
+   Philox b(42, 7, 3, 1);
+   for(int i = 0; i < 100; i++)
+   {
+      EXPECT_EQ(a(), b());
+   }
+}
+
+TEST(PhiloxTest, streamsDiffer)
+{
+   Philox base(42, 7, 3, 1);
+   Philox seed(43, 7, 3, 1);
+   Philox stream(42, 8, 3, 1);
+   Philox step(42, 7, 4, 1);
+   Philox substream(42, 7, 3, 2);
+   Philox::result_type first = base();
+   EXPECT_NE(first, seed());
+   EXPECT_NE(first, stream());
+   EXPECT_NE(first, step());
+   EXPECT_NE(first, substream());
+}
+
+TEST(PhiloxTest, seekAndDiscard)
+{
+   Philox sequential(99, 1, 2);
+   std::vector<Philox::result_type> outputs;
+   for(int i = 0; i < 11; i++)
+   {
+      outputs.push_back(sequential());
+   }
+   EXPECT_EQ(11u, sequential.Position());
+
+   for(int n = 0; n < 11; n++)
+   {
+      Philox seeked(99, 1, 2);
+      seeked.Seek(n);
+      EXPECT_EQ(n, seeked.Position());
+      EXPECT_EQ(outputs[n], seeked());
+
+   }
+
+   for(int n = 0; n < 10; n++)
+   {
+      Philox discarded(99, 1, 2);
+      discarded();
+      discarded.discard(n);
+      EXPECT_EQ(outputs[n + 1], discarded());
+   }
+}
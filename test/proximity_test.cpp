@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "Proximity.hpp"
+#include "Point.hpp"
+
+TEST(ProximityTest, squaredRangeIsExact)
+{
+   std::mt19937_64 gen(99);
+   std::uniform_real_distribution<double> range_distribution(0, 50);
+   for(int t = 0; t < 1000; t++)
+   {
+      double range   = range_distribution(gen);
+      double squared = proximity::SquaredRange(range);
+      EXPECT_LE(sqrt(squared), range);
+      EXPECT_GT(sqrt(nextafter(squared, INFINITY)), range);
+   }
+
+   EXPECT_EQ(0.0, proximity::SquaredRange(0.0));
+   EXPECT_LT(proximity::SquaredRange(-1.0), 0.0);
+   EXPECT_LT(proximity::SquaredRange(NAN), 0.0);
+   EXPECT_EQ(INFINITY, proximity::SquaredRange(INFINITY));
+}
+
+TEST(ProximityTest, withinMatchesPoint)
+{
+   std::mt19937_64 gen(7);
+   std::uniform_real_distribution<double> coordinate(-10, 10);
+   std::vector<double> xs;
+   std::vector<double> ys;
+   for(int k = 0; k < 1001; k++)
+   {
+      xs.push_back(coordinate(gen));
+      ys.push_back(coordinate(gen));
+   }
+   // points exactly on the boundary of a range of 5 around (1, 1).
+   xs.insert(xs.end(), {4.0, 1.0, -2.0, 1.0, 6.0, 1.0 + 5 * cos(0.3)});
+   ys.insert(ys.end(), {5.0, 6.0, -3.0, -4.0, 1.0, 1.0 + 5 * sin(0.3)});
+
+   for(double range : {0.0, 0.1, 5.0, 7.3, 30.0})
+   {
+      for(Point centre : {Point(1, 1), Point(-3.25, 8.5)})
+      {
+         std::vector<int> expected;
+         for(int k = 0; k < xs.size(); k++)
+         {
+            if(centre.Within(range, Point(xs[k], ys[k])))
+            {
+               expected.push_back(k);
+            }
+         }
+
+         std::vector<int> hits(xs.size());
+         int count = proximity::Within(centre.GetX(), centre.GetY(), xs.data(), ys.data(), xs.size(),
+                                       proximity::SquaredRange(range), hits.data());
+         hits.resize(count);
+         EXPECT_EQ(expected, hits) << proximity::KernelName() << " range " << range;
+      }
+   }
+}
+
+TEST(ProximityTest, allPairs)
+{
+   std::mt19937_64 gen(3);
+   std::uniform_real_distribution<double> coordinate(-50, 50);
+   std::vector<Point> points;
+   for(int i = 0; i < 301; i++)
+   {
+      double x = coordinate(gen);
+      points.push_back(Point(x, coordinate(gen)));
+   }
+
+   std::vector<std::pair<int,int>> expected;
+   for(int i = 0; i < points.size(); i++)
+   {
+      for(int j = i + 1; j < points.size(); j++)
+      {
+         if(points[i].Within(8.0, points[j]))
+         {
+            expected.push_back(std::make_pair(i, j));
+         }
+      }
+   }
+
+   std::vector<std::pair<int,int>> pairs = {{0, 1}};
+   proximity::AllPairs(points, 8.0, pairs);
+   EXPECT_EQ(expected, pairs);
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+#include "Model.hpp"
+#include "ModelBatch.hpp"
+#include "Rule.hpp"
+#include "TotalisticRule.hpp"
+#include "StepProfile.hpp"
+
+#ifndef LCA_PROFILE
+namespace
+{
+   thread_local long long test_allocations = 0;
+}
+
+// Count allocations on this thread. With LCA_PROFILE the library
+// already replaces operator new and counts them for us.
+void* operator new(std::size_t size)
+{
+   test_allocations++;
+   void* p = std::malloc(size == 0 ? 1 : size);
+   if(p == nullptr)
+   {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+#endif
+
+namespace
+{
+   long long Allocations()
+   {
+#ifdef LCA_PROFILE
+      return StepProfile::ThreadAllocations();
+#else
+      return test_allocations;
+#endif
+   }
+
+   /**
+    * Warm up the model then count the allocations made by the next
+    * steps.
+    */
+   long long StepAllocations(Model& model, const Rule* rule)
+   {
+      model.RecordNetworkDensityOnly();
+      model.Reserve(60);
+      for(int t = 0; t < 10; t++)
+      {
+         model.Step(rule);
+      }
+      long long before = Allocations();
+      for(int t = 0; t < 50; t++)
+      {
+         model.Step(rule);
+      }
+      return Allocations() - before;
+   }
+
+   /**
+    * Majority rule without a count-based entry point, so Step() builds
+    * a vector of neighbor states.
+    */
+   class VectorMajority : public Rule
+   {
+      MajorityRule majority;
+   public:
+      std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+         {
+            return majority.Apply(self, neighbors);
+         }
+   };
+}
+
+TEST(StepAllocationTest, cellListStepDoesNotAllocate)
+{
+   MajorityRule rule;
+   Model model(50, 300, 5.0, 1234, 0.5);
+   model.SetNoise(0.05);
+   model.SetPDark(0.1);
+   model.SetPInteractive(0.5);
+   EXPECT_EQ(0, StepAllocations(model, &rule));
+}
+
+TEST(StepAllocationTest, otherSearchesDoNotAllocate)
+{
+   MajorityRule rule;
+   Model all_pairs(50, 300, 5.0, 1234, 0.5);
+   all_pairs.SetNeighborSearch(Model::NeighborSearch::AllPairs);
+   EXPECT_EQ(0, StepAllocations(all_pairs, &rule));
+
+   Model verlet(50, 300, 5.0, 1234, 0.5, 0.2);
+   verlet.SetNeighborSearch(Model::NeighborSearch::Verlet);
+   EXPECT_EQ(0, StepAllocations(verlet, &rule));
+}
+
+TEST(StepAllocationTest, counterRngAndVectorRuleDoNotAllocate)
+{
+   VectorMajority rule;
+   Model model(50, 300, 5.0, 1234, 0.5);
+   model.UseCounterRng();
+   model.SetMovementRule(std::make_shared<LevyWalk>(1.5, 20));
+   EXPECT_EQ(0, StepAllocations(model, &rule));
+}
+
+TEST(StepAllocationTest, keepingSnapshotsAllocates)
+{
+   // each step's snapshot is kept in the stats, so a new one is needed
+   MajorityRule rule;
+   Model model(50, 300, 5.0, 1234, 0.5);
+   model.Step(&rule);
+   long long before = Allocations();
+   model.Step(&rule);
+   EXPECT_GT(Allocations(), before);
+}
+
+TEST(StepAllocationTest, batchStepDoesNotAllocate)
+{
+   MajorityRule rule;
+   for(auto method : {NetworkBuilder::Method::CellList, NetworkBuilder::Method::Verlet})
+   {
+      ModelBatch batch(50, 300, 5.0, {1, 2, 3, 4}, 0.5, 0.2);
+      batch.SetNeighborSearch(method);
+      batch.SetMovementRule(std::make_shared<LevyWalk>(1.5, 20));
+      batch.SetNoise(0.05);
+      batch.RecordNetworkDensityOnly();
+      batch.Reserve(90);
+      // long enough for every replica's buffers to reach their size.
+      for(int t = 0; t < 40; t++)
+      {
+         batch.Step(&rule);
+      }
+      long long before = Allocations();
+      for(int t = 0; t < 50; t++)
+      {
+         batch.Step(&rule);
+      }
+      EXPECT_EQ(0, Allocations() - before);
+   }
+}
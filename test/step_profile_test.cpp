@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "Model.hpp"
+#include "Rule.hpp"
+
+TEST(StepProfileTest, countsWhenEnabled)
+{
+   MajorityRule majority;
+   Model m(50, 100, 5.0, 1234, 0.5);
+   m.SetPDark(0.3);
+   long long edges = 0;
+   for(int i = 0; i < 10; i++)
+   {
+      m.Step(&majority);
+      edges += m.GetStats().GetNetwork().GetSnapshot(i + 1)->EdgeCount();
+   }
+
+   const StepProfile& profile = m.GetProfile();
+   if(!StepProfile::Enabled())
+   {
+      EXPECT_EQ(0, profile.steps);
+      EXPECT_EQ(0.0, profile.TotalSeconds());
+      return;
+   }
+
+   EXPECT_EQ(10, profile.steps);
+   EXPECT_EQ(edges, profile.edges);
+   EXPECT_GT(profile.rule_applications, 0);
+   EXPECT_LE(profile.rule_applications, 10 * 100);
+   EXPECT_GT(profile.allocations, 0);
+   EXPECT_GT(profile.TotalSeconds(), 0.0);
+}
+
+TEST(StepProfileTest, sum)
+{
+   StepProfile a;
+   a.move_seconds = 1;
+   a.steps        = 2;
+   StepProfile b;
+   b.stats_seconds = 0.5;
+   b.steps         = 3;
+   a += b;
+   EXPECT_EQ(1.5, a.TotalSeconds());
+   EXPECT_EQ(5, a.steps);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <cstdio> // std::remove
+#include <fstream>
+#include <atomic>
+#include <stdexcept>
+#include <getopt.h>
+
+#include "SweepCheckpoint.hpp"
+#include "EnsembleRunner.hpp"
+
+class SweepCheckpointTest : public ::testing::Test
+{
+public:
+   std::string path;
+
+   SweepCheckpointTest() : path("sweep_checkpoint_test.txt") { std::remove(path.c_str()); }
+   ~SweepCheckpointTest() { std::remove(path.c_str()); }
+};
+
+TEST_F(SweepCheckpointTest, resultsSurviveReopening)
+{
+   {
+      SweepCheckpoint checkpoint(path, "--seed 3", 3);
+      EXPECT_EQ(0, checkpoint.Size());
+      checkpoint.Put(0, 1, true);
+      checkpoint.Put(2, 0, 0.1);
+   }
+
+   SweepCheckpoint checkpoint(path, "--seed 3", 99);
+   EXPECT_EQ(3, checkpoint.Seed());
+   EXPECT_EQ(2, checkpoint.Size());
+
+   bool   correct = false;
+   double density = 0;
+   EXPECT_TRUE(checkpoint.Get(0, 1, correct));
+   EXPECT_TRUE(correct);
+   EXPECT_TRUE(checkpoint.Get(2, 0, density));
+   EXPECT_EQ(0.1, density);
+   EXPECT_FALSE(checkpoint.Get(1, 1, density));
+}
+
+TEST_F(SweepCheckpointTest, differentSweepIsRejected)
+{
+   {
+      SweepCheckpoint checkpoint(path, "--num-agents 10", 1);
+   }
+   EXPECT_THROW(SweepCheckpoint(path, "--num-agents 20", 1), std::runtime_error);
+
+   std::ofstream(path) << "not a checkpoint\n";
+   EXPECT_THROW(SweepCheckpoint(path, "--num-agents 10", 1), std::runtime_error);
+}
+
+TEST_F(SweepCheckpointTest, partialLastLineIsIgnored)
+{
+   {
+      SweepCheckpoint checkpoint(path, "", 5);
+      checkpoint.Put(0, 0, 0.125);
+   }
+   std::ofstream(path, std::ios::app) << "1 0 0.12"; // killed while writing 0.125
+
+   {
+      SweepCheckpoint checkpoint(path, "", 5);
+      double result;
+      EXPECT_EQ(1, checkpoint.Size());
+      EXPECT_FALSE(checkpoint.Get(1, 0, result));
+      checkpoint.Put(1, 0, 0.5);
+   }
+
+   SweepCheckpoint checkpoint(path, "", 5);
+   double result;
+   EXPECT_EQ(2, checkpoint.Size());
+   ASSERT_TRUE(checkpoint.Get(1, 0, result));
+   EXPECT_EQ(0.5, result);
+}
+
+TEST_F(SweepCheckpointTest, resumedEnsembleSkipsFinishedCells)
+{
+   std::atomic<int> calls(0);
+   auto f = [&calls](int p, int r)
+      {
+         calls++;
+         return p * 10 + r;
+      };
+
+   EnsembleRunner runner(3);
+   auto expected = runner.Run(4, 5, f);
+   calls = 0;
+
+   {
+      // a sweep that was stopped after a few cells.
+      SweepCheckpoint checkpoint(path, "sweep", 0);
+      for(int r = 0; r < 5; r++)
+      {
+         checkpoint.Put(1, r, expected[1][r]);
+      }
+      checkpoint.Put(3, 2, expected[3][2]);
+   }
+
+   SweepCheckpoint checkpoint(path, "sweep", 0);
+   auto resumed = runner.Run(4, 5, f, &checkpoint);
+   EXPECT_EQ(expected, resumed);
+   EXPECT_EQ(20 - 6, calls);
+   EXPECT_EQ(20, checkpoint.Size());
+
+   calls = 0;
+   EXPECT_EQ(expected, runner.Run(4, 5, f, &checkpoint));
+   EXPECT_EQ(0, calls);
+}
+
+/**
+ * A result that can't be written, standing in for a checkpoint file
+ * that can't be written.
+ */
+struct Unwritable
+{
+   int value = 0;
+};
+
+std::ostream& operator<<(std::ostream&, const Unwritable&)
+{
+   throw std::runtime_error("can't write");
+}
+
+std::istream& operator>>(std::istream& in, Unwritable& result)
+{
+   return in >> result.value;
+}
+
+TEST_F(SweepCheckpointTest, failedRecordReachesTheCaller)
+{
+   std::atomic<int> calls(0);
+   SweepCheckpoint checkpoint(path, "sweep", 0);
+   EnsembleRunner runner(3);
+   EXPECT_THROW(runner.Run(10, 10, [&calls](int, int)
+                           {
+                              calls++;
+                              return Unwritable();
+                           }, &checkpoint),
+                std::runtime_error);
+   EXPECT_LT(calls, 100);
+   EXPECT_EQ(0, checkpoint.Size());
+}
+
+TEST_F(SweepCheckpointTest, factoryKeepsTheSeedOfTheCheckpoint)
+{
+   const char* argv[] = {"test", "--num-agents", "20", "--arena-size", "20", "--max-time", "20",
+                         "--checkpoint", "sweep_checkpoint_test.txt"};
+   std::vector<double> densities = {0.3, 0.7};
+   auto final_density = [](LCA& lca)
+      {
+         lca.Run();
+         return lca.CurrentDensity();
+      };
+
+   // without --seed each Init() picks a random seed, unless the
+   // checkpoint already has one.
+   LCAFactory first;
+   optind = 1;
+   first.Init(9, const_cast<char**>(argv));
+   EnsembleRunner runner(2);
+   auto expected = runner.Run(first, densities, 3, final_density, first.Checkpoint());
+
+   LCAFactory second;
+   optind = 1;
+   second.Init(9, const_cast<char**>(argv));
+   ASSERT_NE(nullptr, second.Checkpoint());
+   EXPECT_EQ(first.Seed(1, 2), second.Seed(1, 2));
+   EXPECT_EQ(expected, runner.Run(densities.size(), 3, [&second, &densities, &final_density](int d, int r)
+                                  {
+                                     return final_density(*second.Create(densities[d], second.Seed(d, r)));
+                                  }));
+}
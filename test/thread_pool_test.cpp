@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+TEST(ThreadPoolTest, runsEveryTaskOnce)
+{
+   ThreadPool pool(4);
+   std::vector<int> counts(100, 0);
+   for(int repeat = 0; repeat < 10; repeat++)
+   {
+      pool.Run(counts.size(), [&counts](int t) { counts[t]++; });
+   }
+   for(int count : counts)
+   {
+      EXPECT_EQ(10, count);
+   }
+}
+
+TEST(ThreadPoolTest, parallelForCoversRange)
+{
+   for(int threads : {1, 3, 8})
+   {
+      ThreadPool pool(threads);
+      EXPECT_EQ(threads, pool.NumThreads());
+      for(int n : {0, 1, 5, 1000})
+      {
+         std::vector<int> visits(n, 0);
+         pool.ParallelFor(0, n, [&visits](int begin, int end)
+                          {
+                             for(int i = begin; i < end; i++)
+                             {
+                                visits[i]++;
+                             }
+                          });
+         EXPECT_EQ(std::vector<int>(n, 1), visits);
+      }
+   }
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <sstream>
+
+#include "TotalisticRule.hpp"
+
+class TotalisticRuleTest : public ::testing::Test
+{
+public:
+   TotalisticRule majority;
+   TotalisticRule turning;
+   TotalisticRule exclusive;
+
+   TotalisticRuleTest()
+      {
+         std::istringstream majority_file(
+            "1 + [0.0,0.5) -> 0, 0\n"
+            "0 + [0.0,0.5) -> 0, 0\n"
+            "0 + (0.5,1.0] -> 1, 0\n"
+            "1 + (0.5,1.0] -> 1, 0\n"
+            "1 + [0.5,0.5] -> 0, 0\n"
+            "0 + [0.5,0.5] -> 1, 0\n");
+         majority_file >> majority;
+
+         std::istringstream turning_file(
+            "@ + [0.0, 0.15] -> 1, 17\n"
+            "@ + [0.15, 0.3] -> 0, -13\n"
+            "1 + [0.3, 0.75] -> 0, 137.5\n"
+            "0 + [0.3, 0.75] -> 1, 137.5\n"
+            "1 + [0.75, 1.0] -> 1, 1\n"
+            "0 + [0.75, 1.0] -> 0, -1\n");
+         turning_file >> turning;
+
+         std::istringstream exclusive_file(
+            "@ - [1.0,1.0] -> 1, 0\n"
+            "@ - [0.0,0.0] -> 0, 0\n"
+            "@ - (0.0,1.0) -> 0, 0\n");
+         exclusive_file >> exclusive;
+      }
+};
+
+TEST_F(TotalisticRuleTest, compiledByDefault)
+{
+   EXPECT_EQ(TotalisticRule::DEFAULT_MAX_DEGREE, majority.MaxDegree());
+}
+
+TEST_F(TotalisticRuleTest, majority)
+{
+   EXPECT_EQ(1, majority.ApplyCount(0, 3, 4).first);
+   EXPECT_EQ(0, majority.ApplyCount(1, 1, 4).first);
+   EXPECT_EQ(0, majority.ApplyCount(1, 0, 1).first); // tie flips
+   EXPECT_EQ(1, majority.ApplyCount(0, 1, 1).first);
+   EXPECT_EQ(1, majority.Apply(0, {1, 1, 0, 1}).first);
+}
+
+TEST_F(TotalisticRuleTest, compiledMatchesUncompiled)
+{
+   for(TotalisticRule* rule : {&majority, &turning, &exclusive})
+   {
+      TotalisticRule uncompiled(*rule);
+      uncompiled.Compile(-1);
+      TotalisticRule small(*rule);
+      small.Compile(5);
+      for(int self = 0; self <= 1; self++)
+      {
+         for(int total = 0; total <= 20; total++)
+         {
+            for(int ones = 0; ones <= total; ones++)
+            {
+               auto expected = uncompiled.ApplyCount(self, ones, total);
+               EXPECT_EQ(expected, rule->ApplyCount(self, ones, total));
+               EXPECT_EQ(expected, small.ApplyCount(self, ones, total));
+            }
+         }
+      }
+   }
+}
+
+TEST_F(TotalisticRuleTest, headingChange)
+{
+   EXPECT_EQ(std::make_pair(1, 17 * M_PI / 180.0), turning.ApplyCount(0, 0, 9));
+   EXPECT_EQ(std::make_pair(0, -13 * M_PI / 180.0), turning.ApplyCount(1, 1, 9));
+   EXPECT_EQ(std::make_pair(1, 1 * M_PI / 180.0), turning.ApplyCount(1, 9, 9));
+   EXPECT_EQ(std::make_pair(0, -1 * M_PI / 180.0), turning.ApplyCount(0, 9, 9));
+}
+
+TEST_F(TotalisticRuleTest, emptyNeighborhoodExcludingSelf)
+{
+   // no transition matches a neighborhood with no neighbors, so the
+   // state is unchanged.
+   EXPECT_EQ(std::make_pair(1, 0.0), exclusive.ApplyCount(1, 0, 0));
+   EXPECT_EQ(std::make_pair(0, 0.0), exclusive.ApplyCount(0, 0, 0));
+}
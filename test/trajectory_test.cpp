@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>   // std::remove
+#include <fstream>
+#include <unistd.h> // truncate
+
+#include "Model.hpp"
+#include "Rule.hpp"
+#include "Trajectory.hpp"
+
+class TrajectoryTest : public ::testing::Test
+{
+public:
+   std::string  path;
+   MajorityRule majority_rule;
+
+   TrajectoryTest() : path("trajectory_test.traj") {}
+   ~TrajectoryTest() { std::remove(path.c_str()); }
+
+   void ExpectFrameMatches(const TrajectoryFrame& frame, const Model& model)
+      {
+         const AgentStore& agents = model.GetAgentStore();
+         ASSERT_EQ(agents.Size(), frame.NumAgents());
+         for(int i = 0; i < agents.Size(); i++)
+         {
+            EXPECT_EQ(agents.Position(i), frame.Position(i));
+            EXPECT_EQ(agents.GetHeading(i), frame.GetHeading(i));
+            EXPECT_EQ(model.GetStates()[i], frame.State(i));
+            EXPECT_EQ(agents.IsDark(i), frame.IsDark(i));
+         }
+         EXPECT_EQ(model.CurrentDensity(), frame.Density());
+      }
+};
+
+TEST_F(TrajectoryTest, roundTrip)
+{
+   Model model(50, 101, 5.0, 1234, 0.5);
+   model.SetPDark(0.2);
+   std::vector<Model> expected;
+   {
+      TrajectoryWriter writer(path, 101, 50, true);
+      for(int t = 0; t < 10; t++)
+      {
+         writer.Write(model);
+         expected.push_back(model);
+         model.Step(&majority_rule);
+      }
+      EXPECT_EQ(10, writer.NumFrames());
+   }
+
+   TrajectoryReader reader(path);
+   EXPECT_EQ(101, reader.NumAgents());
+   EXPECT_EQ(50.0, reader.ArenaSize());
+   EXPECT_TRUE(reader.HasEdges());
+   ASSERT_EQ(10, reader.NumFrames());
+   for(int t = 0; t < 10; t++)
+   {
+      TrajectoryFrame frame = reader.GetFrame(t);
+      ExpectFrameMatches(frame, expected[t]);
+      std::shared_ptr<NetworkSnapshot> network = expected[t].CurrentNetwork();
+      EXPECT_EQ(network->EdgeCount(), frame.NumEdges());
+      EXPECT_TRUE(*network == *frame.GetNetwork());
+   }
+   EXPECT_THROW(reader.GetFrame(10), std::out_of_range);
+}
+
+TEST_F(TrajectoryTest, withoutEdges)
+{
+   Model model(20, 7, 5.0, 99, 0.5);
+   {
+      TrajectoryWriter writer(path, 7, 20);
+      writer.Write(model);
+   }
+   TrajectoryReader reader(path);
+   EXPECT_FALSE(reader.HasEdges());
+   ASSERT_EQ(1, reader.NumFrames());
+   EXPECT_EQ(0, reader.GetFrame(0).NumEdges());
+   ExpectFrameMatches(reader.GetFrame(0), model);
+}
+
+TEST_F(TrajectoryTest, truncatedFrameIgnored)
+{
+   Model model(20, 7, 5.0, 99, 0.5);
+   {
+      TrajectoryWriter writer(path, 7, 20, true);
+      writer.Write(model);
+      writer.Write(model);
+   }
+   std::size_t full_size = trajectory::HEADER_SIZE
+      + 2 * trajectory::FrameSize(7, model.CurrentNetwork()->EdgeCount());
+   ASSERT_EQ(0, truncate(path.c_str(), full_size - 3));
+
+   TrajectoryReader reader(path);
+   EXPECT_EQ(1, reader.NumFrames());
+}
+
+TEST_F(TrajectoryTest, rejectsOtherFiles)
+{
+   {
+      std::ofstream out(path);
+      out << "this is not a trajectory file, just some text";
+   }
+   EXPECT_THROW(TrajectoryReader reader(path), std::runtime_error);
+   EXPECT_THROW(TrajectoryReader reader("no/such/file"), std::runtime_error);
+}
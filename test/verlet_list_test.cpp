@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include "VerletList.hpp"
+#include "CellList.hpp"
+#include "Point.hpp"
+
+namespace
+{
+   std::vector<std::pair<int,int>> SortedCellListPairs(const std::vector<Point>& points, double range)
+   {
+      std::vector<std::pair<int,int>> pairs;
+      CellList cells(100, range);
+      cells.Build(points);
+      cells.Pairs(points, pairs);
+      std::sort(pairs.begin(), pairs.end());
+      return pairs;
+   }
+
+   /**
+    * Move every point a distance step in a random direction.
+    */
+   void Jitter(std::vector<Point>& points, double step, std::mt19937_64& gen)
+   {
+      std::uniform_real_distribution<double> angle(0, 2*M_PI);
+      for(Point& p : points)
+      {
+         double a = angle(gen);
+         p = Point(p.GetX() + step * cos(a), p.GetY() + step * sin(a));
+      }
+   }
+}
+
+TEST(VerletListTest, matchesCellListAsPointsMove)
+{
+   std::mt19937_64 gen(1234);
+   std::uniform_real_distribution<double> coordinate(-50, 50);
+   std::vector<Point> points;
+   for(int i = 0; i < 400; i++)
+   {
+      double x = coordinate(gen);
+      points.push_back(Point(x, coordinate(gen)));
+   }
+
+   ThreadPool pool(1);
+   VerletList verlet(100, 5.0, 1.0);
+   std::vector<std::pair<int,int>> pairs;
+   for(int t = 0; t < 100; t++)
+   {
+      verlet.Pairs(points, pairs, pool);
+      std::sort(pairs.begin(), pairs.end());
+      ASSERT_EQ(SortedCellListPairs(points, 5.0), pairs) << "step " << t;
+      Jitter(points, 0.1, gen);
+   }
+
+   // points move at most 0.1 per step, so the list lasts at least
+   // five steps.
+   EXPECT_LE(verlet.Rebuilds(), 20);
+   EXPECT_GE(verlet.Rebuilds(), 1);
+}
+
+TEST(VerletListTest, rebuildsWhenAPointMovesTooFar)
+{
+   std::vector<Point> points = { Point(0, 0), Point(10, 0) };
+   ThreadPool pool(1);
+   VerletList verlet(100, 5.0, 2.0);
+   std::vector<std::pair<int,int>> pairs;
+
+   verlet.Pairs(points, pairs, pool);
+   EXPECT_TRUE(pairs.empty());
+   EXPECT_EQ(1, verlet.Rebuilds());
+
+   // still within skin/2 of where it started: no rebuild needed
+   points[1] = Point(9.5, 0);
+   verlet.Pairs(points, pairs, pool);
+   EXPECT_EQ(1, verlet.Rebuilds());
+
+   // moved past skin/2 and now in range
+   points[1] = Point(5.0, 0);
+   verlet.Pairs(points, pairs, pool);
+   EXPECT_EQ(2, verlet.Rebuilds());
+   ASSERT_EQ(1, pairs.size());
+   EXPECT_EQ(std::make_pair(0, 1), pairs[0]);
+}
+
+TEST(VerletListTest, rebuildsWhenPointsAreAdded)
+{
+   std::vector<Point> points = { Point(0, 0), Point(1, 0) };
+   ThreadPool pool(1);
+   VerletList verlet(100, 5.0, 2.0);
+   std::vector<std::pair<int,int>> pairs;
+   verlet.Pairs(points, pairs, pool);
+   points.push_back(Point(0, 1));
+   verlet.Pairs(points, pairs, pool);
+   EXPECT_EQ(2, verlet.Rebuilds());
+   EXPECT_EQ(3, pairs.size());
+}
+
+TEST(VerletListTest, changesTrackPairs)
+{
+   std::mt19937_64 gen(4321);
+   std::uniform_real_distribution<double> coordinate(-50, 50);
+   std::vector<Point> points;
+   for(int i = 0; i < 400; i++)
+   {
+      double x = coordinate(gen);
+      points.push_back(Point(x, coordinate(gen)));
+   }
+
+   ThreadPool pool(1);
+   VerletList verlet(100, 5.0, 1.0);
+   std::vector<std::pair<int,int>> pairs;
+   std::vector<std::pair<int,int>> entered;
+   std::vector<std::pair<int,int>> left;
+   std::set<std::pair<int,int>> tracked;
+   int updates = 0;
+   for(int t = 0; t < 100; t++)
+   {
+      if(verlet.Changes(points, pairs, entered, left, pool))
+      {
+         for(auto& pair : left)
+         {
+            ASSERT_EQ(1u, tracked.erase(pair));
+         }
+         for(auto& pair : entered)
+         {
+            ASSERT_TRUE(tracked.insert(pair).second);
+         }
+         updates++;
+      }
+      else
+      {
+         EXPECT_TRUE(entered.empty());
+         EXPECT_TRUE(left.empty());
+         tracked = std::set<std::pair<int,int>>(pairs.begin(), pairs.end());
+      }
+      std::set<std::pair<int,int>> found(pairs.begin(), pairs.end());
+      ASSERT_EQ(found, tracked) << "step " << t;
+      Jitter(points, 0.1, gen);
+   }
+   EXPECT_EQ(100 - verlet.Rebuilds(), updates);
+}